@@ -0,0 +1,191 @@
+import argparse
+import json
+import os
+import shlex
+import time
+
+import i2s_diff
+import i2s_offline
+
+
+def add_decode_arguments(parser):
+    parser.add_argument("--clock", type=int, default=1, help="CLOCK channel")
+    parser.add_argument("--frame", type=int, default=2, help="FRAME channel")
+    parser.add_argument("--data", type=int, default=3, help="DATA channel")
+    parser.add_argument("--edge", choices=["rising", "falling"], default="rising", help="CLOCK data valid edge")
+    parser.add_argument("--bits", type=int, default=32, help="Audio bit depth (bits/sample)")
+    parser.add_argument("--frame-type", choices=list(i2s_offline.FRAME_TYPES), default="once-every-word",
+                        help="FRAME signal transitions")
+    parser.add_argument("--alignment", choices=["left", "right"], default="left", help="DATA bits alignment")
+    parser.add_argument("--shift", type=int, choices=[0, 1], default=1, help="DATA bits shift")
+    parser.add_argument("--lsb-first", action="store_true", help="Least significant bit sent first")
+    parser.add_argument("--test", choices=["contiguous", "none"], default="contiguous", help="Test mode")
+    parser.add_argument("--clock-gap-threshold", type=int, default=0,
+                        help="Restart framing after a CLOCK gap of this many bit periods, 0 is off")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count(), help="Worker processes")
+    parser.add_argument("--segments", type=int, default=0, help="Segments to cut the capture into, default 4 per job")
+
+
+def settings_from_arguments(args):
+    return i2s_offline.DecodeSettings(
+        clock=args.clock, frame=args.frame, data=args.data, data_valid_edge=args.edge, bits_per_word=args.bits,
+        frame_type=args.frame_type, word_alignment=args.alignment, bit_shift=args.shift, lsb_first=args.lsb_first,
+        test=args.test, clock_gap_threshold=args.clock_gap_threshold)
+
+
+def print_summary(summary):
+    duration = (summary['last_time'] or 0.0) - (summary['first_time'] or 0.0)
+    print(f"Frames: {summary['frames']} in {duration:.6f} s, {summary['segments']} segments")
+    print(f"Words: left {summary['words'][0]}, right {summary['words'][1]}")
+    if summary['bit_period_min'] is not None:
+        print(f"Bit period: {summary['bit_period_min'] * 1e9:.2f} to {summary['bit_period_max'] * 1e9:.2f} ns")
+    print(f"Clock gaps: {summary['clock_gaps']}")
+    print(f"Frame errors: {summary['frame_errors']}")
+    print(f"Test errors: {summary['test_errors']}")
+    for error in summary['errors']:
+        name = i2s_offline.ERROR_TYPE_NAMES.get(error['type'], f"type {error['type']}")
+        if error['type'] == i2s_offline.ERROR_TEST:
+            print(f"  {error['start']:.9f} s channel {error['channel']}: {name}, "
+                  f"expected {error['expected']:#x} received {error['received']:#x}")
+        else:
+            print(f"  {error['start']:.9f} s: {name}")
+
+
+def print_batch_progress(report, done, total):
+    if report['error'] is not None:
+        print(f"[{done}/{total}] {report['capture']}: FAILED {report['error']}")
+        return
+    ppm = f"{report['ppm']:+.1f} ppm" if report['ppm'] is not None else "no rate"
+    print(f"[{done}/{total}] {report['capture']}: {report['frames']} frames, {report['test_errors']} test errors, "
+          f"{report['frame_errors']} frame errors, {ppm}, {report['decode_seconds']:.2f} s")
+
+
+def print_batch_summary(batch):
+    totals = batch['totals']
+    print(f"{'Capture':<40} {'Frames':>10} {'Test err':>9} {'Frame err':>9} {'Gaps':>5} {'ppm':>9} {'BER':>9} {'MB/s':>7}")
+    for report in batch['captures']:
+        name = report['capture'][-40:]
+        if report['error'] is not None:
+            print(f"{name:<40} FAILED {report['error']}")
+            continue
+        ppm = f"{report['ppm']:+.1f}" if report['ppm'] is not None else "-"
+        ber = f"{report['ber']:.2e}" if report['ber'] is not None else "-"
+        rate = report['input_bytes'] / report['decode_seconds'] / 1e6 if report['decode_seconds'] > 0 else 0.0
+        print(f"{name:<40} {report['frames']:>10} {report['test_errors']:>9} {report['frame_errors']:>9} "
+              f"{report['clock_gaps']:>5} {ppm:>9} {ber:>9} {rate:>7.1f}")
+    ber = f"{totals['ber']:.2e}" if totals['ber'] is not None else "-"
+    print(f"{totals['captures']} captures ({totals['failed']} failed), {totals['frames']} frames, "
+          f"{totals['test_errors']} test errors, {totals['frame_errors']} frame errors, BER {ber}")
+    if totals['ppm_min'] is not None:
+        print(f"Drift {totals['ppm_min']:+.1f} to {totals['ppm_max']:+.1f} ppm")
+    print(f"Decoded {totals['input_bytes'] / 1e6:.1f} MB in {totals['wall_seconds']:.2f} s "
+          f"({totals['bytes_per_second'] / 1e6:.1f} MB/s, {totals['realtime_factor']:.2f}x realtime)")
+
+
+def print_diff(report):
+    if not report['aligned']:
+        print("No common run of words, the captures don't carry the same stream")
+        print(f"Words: {report['tail'][0]} / {report['tail'][1]}")
+        return
+    print(f"Aligned after skipping {report['skipped'][0]} / {report['skipped'][1]} words")
+    print(f"Compared: {report['compared']} words, {report['matched']} matched, {report['mismatched']} mismatched")
+    print(f"Dropped: {report['dropped_words']} words in {report['dropped_runs']} runs")
+    print(f"Inserted: {report['inserted_words']} words in {report['inserted_runs']} runs")
+    if report['lost_lock']:
+        print(f"Lost lock: {report['lost_lock']} times")
+    print(f"Left over at the end, not compared: {report['tail'][0]} / {report['tail'][1]} words")
+    divergence = report['first_divergence']
+    if divergence is None:
+        print("Identical" if report['identical'] else "No divergence, but too many words were left uncompared")
+        return
+    a, b = divergence['a'], divergence['b']
+    print(f"First divergence: word {a['index']} at {a['time']:.9f} s channel {a['channel']} {a['value']:#x} / "
+          f"word {b['index']} at {b['time']:.9f} s channel {b['channel']} {b['value']:#x}")
+    for event in report['events']:
+        print(f"  {event['a']['time']:.9f} s / {event['b']['time']:.9f} s: {event['kind']} {event['words']} words")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a Logic 2 binary export of an I2S / PCM capture")
+    parser.add_argument("input", nargs="+",
+                        help="Directory or zip file with the digital_N.bin files of the capture. With --batch: capture "
+                             "directories, zipped exports, .sal files, directories to search for them, or text files "
+                             "listing them")
+    parser.add_argument("--json", help="Write the summary (or the batch report) to this file")
+    parser.add_argument("--checkpoint",
+                        help="Resume from this file if it is for the same capture and settings, then update it. "
+                             "Re-running on a capture that is still being appended to only decodes the new data")
+    parser.add_argument("--batch", action="store_true", help="Decode many captures, one per job")
+    parser.add_argument("--memory-budget", type=int, default=0,
+                        help="Batch: MB of working memory for the captures in flight, 0 is unlimited")
+    parser.add_argument("--nominal-rate", type=int, default=0,
+                        help="Batch: frame rate to measure drift against, default the nearest standard rate")
+    parser.add_argument("--logic2-port", type=int, default=10430, help="Batch: Logic 2 automation port for .sal files")
+    parser.add_argument("--diff", nargs="?", const="", metavar="CAPTURE",
+                        help="Compare the words of the input with this capture, or with itself under --diff-settings. "
+                             "Exits with 1 if they diverge")
+    parser.add_argument("--diff-settings", default="",
+                        help="Decode settings of the second side that differ, e.g. \"--edge falling --shift 0\"")
+    add_decode_arguments(parser)
+    args = parser.parse_args()
+    settings = settings_from_arguments(args)
+
+    if args.diff is not None:
+        if len(args.input) > 1:
+            parser.error("--diff compares one input with one other capture")
+        other_parser = argparse.ArgumentParser(prog="--diff-settings")
+        add_decode_arguments(other_parser)
+        other_parser.set_defaults(**vars(args))
+        other_settings = settings_from_arguments(other_parser.parse_args(shlex.split(args.diff_settings)))
+        report = i2s_diff.diff_captures(args.input[0], settings, args.diff or args.input[0], other_settings,
+                                        jobs=args.jobs)
+        print_diff(report)
+        if args.json:
+            with open(args.json, 'w') as f:
+                json.dump(report, f, indent=2)
+        if not report['identical']:
+            raise SystemExit(1)
+        return
+
+    if args.batch:
+        batch = i2s_offline.decode_batch(args.input, settings, jobs=args.jobs,
+                                         memory_budget=args.memory_budget * 1000000,
+                                         segments=args.segments or None, nominal_rate=args.nominal_rate or None,
+                                         logic2_port=args.logic2_port, progress=print_batch_progress)
+        print_batch_summary(batch)
+        if args.json:
+            with open(args.json, 'w') as f:
+                json.dump(batch, f, indent=2)
+        return
+
+    if len(args.input) > 1:
+        parser.error("more than one input needs --batch")
+
+    checkpoint = None
+    if args.checkpoint and os.path.exists(args.checkpoint):
+        with open(args.checkpoint) as f:
+            checkpoint = json.load(f)
+
+    started = time.perf_counter()
+    summary = i2s_offline.decode_capture(args.input[0], settings, jobs=args.jobs,
+                                         segments=args.segments or None, checkpoint=checkpoint)
+    summary['decode_seconds'] = time.perf_counter() - started
+
+    if args.checkpoint:
+        if summary['resumed_from'] is not None:
+            print(f"Resumed from {summary['resumed_from']:.9f} s")
+        elif checkpoint is not None:
+            print("Checkpoint doesn't match the capture or settings, decoded from the start")
+        if summary['checkpoint'] is not None:
+            with open(args.checkpoint, 'w') as f:
+                json.dump(summary['checkpoint'], f)
+    summary.pop('checkpoint')
+    print_summary(summary)
+    print(f"Decoded in {summary['decode_seconds']:.3f} s")
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(summary, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
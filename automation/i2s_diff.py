@@ -0,0 +1,234 @@
+"""Differential decode: are two captures (or one capture under two settings) carrying the same word stream?
+
+Both sides are decoded a segment at a time and compared in lock-step, so memory stays bounded however long the captures
+are. The streams are first aligned on the first run of ALIGN_RUN_WORDS words they have in common, captures started at
+different points in the stream are fine. After a divergence the comparison looks ahead for the nearest point where
+the streams match again for ALIGN_RUN_WORDS words, and reads the skew there as words dropped from or inserted into
+the second stream. Words that are merely different count as mismatched.
+
+Words before the alignment and after the shorter stream ends are not compared. The streams are only reported identical
+when nothing diverged and, beyond the later start, no more than ALIGN_SLACK_WORDS of them were left out at either end.
+"""
+
+import math
+import os
+import shutil
+from collections import deque
+from concurrent.futures import ProcessPoolExecutor
+
+import numpy as np
+
+from i2s_offline import MAX_REPORTED_ERRORS, decode_segment, segment_bounds
+from transition_reader import source_bytes, unpack_source
+
+ALIGN_RUN_WORDS = 16
+# words either end can leave uncompared and still be identical, a run too short to align on
+ALIGN_SLACK_WORDS = ALIGN_RUN_WORDS
+# how far into each capture the first common run is looked for
+ALIGN_SEARCH_WORDS = 1 << 20
+# how far past a divergence the streams are looked at to get back in step
+RESYNC_SEARCH_WORDS = 1 << 16
+COMPARE_CHUNK_WORDS = 1 << 16
+STREAM_SEGMENT_TRANSITIONS = 1 << 20
+HASH_MULTIPLIER = np.uint64(0x9E3779B97F4A7C15)
+
+
+class WordStream:
+    """The words of a capture in order, decoded one segment at a time as the comparison needs them.
+
+    Only the words not yet consumed are held, plus up to ahead segments being decoded in the pool.
+    position is the index of the first held word in the whole stream.
+    """
+
+    def __init__(self, source, settings, pool, ahead):
+        self.source = source
+        self.settings = settings
+        self.pool = pool
+        self.ahead = ahead
+        self.pending = deque()
+        segments = max(math.ceil(source_bytes(source, settings.clock) / 8 / STREAM_SEGMENT_TRANSITIONS), 1)
+        self.bounds = iter(segment_bounds(source, settings, segments))
+        self.values = np.empty(0, dtype=np.uint64)
+        self.channels = np.empty(0, dtype=np.uint8)
+        self.times = np.empty(0, dtype=np.float64)
+        self.position = 0
+        self.exhausted = False
+
+    def __len__(self):
+        return len(self.values)
+
+    def fill(self, count):
+        """Decode until count words are held, or the capture ends."""
+        while len(self.values) < count and not self.exhausted:
+            while len(self.pending) < self.ahead:
+                bound = next(self.bounds, None)
+                if bound is None:
+                    break
+                self.pending.append(self.pool.submit(decode_segment, self.source, self.settings, *bound, words=True))
+            if not self.pending:
+                self.exhausted = True
+                break
+            stream = self.pending.popleft().result().get('word_stream')
+            if stream is not None:
+                self.values = np.concatenate((self.values, stream[0]))
+                self.channels = np.concatenate((self.channels, stream[1]))
+                self.times = np.concatenate((self.times, stream[2]))
+
+    def consume(self, count):
+        self.values = self.values[count:]
+        self.channels = self.channels[count:]
+        self.times = self.times[count:]
+        self.position += count
+
+    def head(self, count):
+        return self.values[:count], self.channels[:count]
+
+    def drain(self):
+        """Consume everything that is left, returns how many words that was."""
+        count = 0
+        while True:
+            self.fill(COMPARE_CHUNK_WORDS)
+            if len(self) == 0:
+                return count
+            count += len(self)
+            self.consume(len(self))
+
+    def word(self, index=0):
+        return {'index': self.position + index, 'time': float(self.times[index]), 'channel': int(self.channels[index]),
+                'value': int(self.values[index])}
+
+
+def window_hashes(keys, run):
+    """Hash of every run words long window of keys."""
+    count = len(keys) - run + 1
+    hashes = np.zeros(max(count, 0), dtype=np.uint64)
+    for k in range(run):
+        hashes = hashes * HASH_MULTIPLIER + keys[k:k + count]
+    return hashes
+
+
+def find_alignment(a, b, run):
+    """Smallest (i, j), by i + j, where run words of a from i on equal those of b from j on, or None.
+
+    a and b are (values, channels) array pairs.
+    """
+    hashes_a = window_hashes(a[0] ^ (a[1] * HASH_MULTIPLIER), run)
+    hashes_b = window_hashes(b[0] ^ (b[1] * HASH_MULTIPLIER), run)
+    if len(hashes_a) == 0 or len(hashes_b) == 0:
+        return None
+    unique, first = np.unique(hashes_a, return_index=True)
+    slot = np.minimum(np.searchsorted(unique, hashes_b), len(unique) - 1)
+    found = np.flatnonzero(unique[slot] == hashes_b)
+    if len(found) == 0:
+        return None
+    i = first[slot[found]]
+    # hashes can collide, check the candidates in order of cost
+    for index in np.argsort(i + found, kind='stable'):
+        start_a, start_b = int(i[index]), int(found[index])
+        if all(np.array_equal(x[start_a:start_a + run], y[start_b:start_b + run]) for x, y in zip(a, b)):
+            return start_a, start_b
+    return None
+
+
+def new_diff_report():
+    return {'aligned': False, 'skipped': [0, 0], 'compared': 0, 'matched': 0, 'mismatched': 0, 'first_divergence': None,
+            'dropped_runs': 0, 'dropped_words': 0, 'inserted_runs': 0, 'inserted_words': 0, 'lost_lock': 0,
+            'events': [], 'tail': [0, 0], 'identical': False}
+
+
+def add_event(report, kind, a, b, words):
+    if len(report['events']) < MAX_REPORTED_ERRORS:
+        report['events'].append({'kind': kind, 'a': a.word(), 'b': b.word(), 'words': int(words)})
+
+
+def diff_streams(a, b):
+    """Compare two WordStreams, a being the reference. Dropped and inserted are from the point of view of b."""
+    report = new_diff_report()
+    a.fill(ALIGN_SEARCH_WORDS)
+    b.fill(ALIGN_SEARCH_WORDS)
+    alignment = find_alignment(a.head(ALIGN_SEARCH_WORDS), b.head(ALIGN_SEARCH_WORDS), ALIGN_RUN_WORDS)
+    if alignment is None:
+        report['tail'] = [a.drain(), b.drain()]
+        return report
+    report['aligned'] = True
+    report['skipped'] = list(alignment)
+    a.consume(alignment[0])
+    b.consume(alignment[1])
+
+    while True:
+        a.fill(COMPARE_CHUNK_WORDS)
+        b.fill(COMPARE_CHUNK_WORDS)
+        count = min(len(a), len(b))
+        if count == 0:
+            break
+        differ = (a.values[:count] != b.values[:count]) | (a.channels[:count] != b.channels[:count])
+        same = int(np.argmax(differ)) if np.any(differ) else count
+        report['compared'] += same
+        report['matched'] += same
+        a.consume(same)
+        b.consume(same)
+        if same == count:
+            continue
+
+        if report['first_divergence'] is None:
+            report['first_divergence'] = {'a': a.word(), 'b': b.word()}
+        a.fill(RESYNC_SEARCH_WORDS)
+        b.fill(RESYNC_SEARCH_WORDS)
+        alignment = find_alignment(a.head(RESYNC_SEARCH_WORDS), b.head(RESYNC_SEARCH_WORDS), ALIGN_RUN_WORDS)
+        if alignment is None:
+            # no way back in step nearby, write the window off and try again after it.
+            lost = min(len(a), len(b), RESYNC_SEARCH_WORDS)
+            report['lost_lock'] += 1
+            add_event(report, 'lost lock', a, b, lost)
+            report['compared'] += lost
+            report['mismatched'] += lost
+            a.consume(lost)
+            b.consume(lost)
+            continue
+
+        i, j = alignment
+        changed = min(i, j)
+        mismatched = int(np.count_nonzero((a.values[:changed] != b.values[:changed]) |
+                                          (a.channels[:changed] != b.channels[:changed])))
+        report['compared'] += changed
+        report['matched'] += changed - mismatched
+        report['mismatched'] += mismatched
+        a.consume(changed)
+        b.consume(changed)
+        if i > j:
+            report['dropped_runs'] += 1
+            report['dropped_words'] += i - j
+            add_event(report, 'dropped', a, b, i - j)
+        elif j > i:
+            report['inserted_runs'] += 1
+            report['inserted_words'] += j - i
+            add_event(report, 'inserted', a, b, j - i)
+        a.consume(i - changed)
+        b.consume(j - changed)
+
+    report['tail'] = [a.drain(), b.drain()]
+    # a start skipped on one side only is the later capture starting, words skipped on both were never compared
+    report['identical'] = (report['first_divergence'] is None and min(report['skipped']) <= ALIGN_SLACK_WORDS and
+                           max(report['tail']) <= ALIGN_SLACK_WORDS)
+    return report
+
+
+def diff_captures(source_a, settings_a, source_b, settings_b, jobs=None):
+    """Diff two captures, or one capture under two settings when the sources are the same.
+
+    Each side decodes up to jobs segments ahead of the comparison in worker processes.
+    """
+    jobs = jobs or os.cpu_count() or 1
+    channels_a = (settings_a.clock, settings_a.frame, settings_a.data)
+    channels_b = (settings_b.clock, settings_b.frame, settings_b.data)
+    unpacked_a, temporary_a = unpack_source(source_a, channels_a)
+    temporary_b = None
+    try:
+        unpacked_b, temporary_b = unpack_source(source_b, channels_b)
+        with ProcessPoolExecutor(max_workers=jobs) as pool:
+            return diff_streams(WordStream(unpacked_a, settings_a, pool, jobs),
+                                WordStream(unpacked_b, settings_b, pool, jobs))
+    finally:
+        for temporary in (temporary_a, temporary_b):
+            if temporary:
+                shutil.rmtree(temporary, ignore_errors=True)
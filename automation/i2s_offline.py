@@ -0,0 +1,624 @@
+"""Offline I2S / PCM decoder for Logic 2 binary exports, read through transition_reader.
+
+Decodes the same way as the analyzer plugin (data valid edge, FRAME rising edge starts a frame, optional one bit shift,
+words per frame by FRAME type) but works on whole transition arrays with numpy instead of walking edges one by one.
+Large captures are cut into segments at FRAME rising edges and decoded in parallel, the per-segment results are then
+stitched together so the contiguous test sees one continuous stream. Segments are also capped in size, so with the
+channel files memory mapped a decode's working memory doesn't grow with the capture.
+"""
+
+import copy
+import math
+import os
+import shutil
+import tempfile
+import time
+from concurrent.futures import FIRST_COMPLETED, ProcessPoolExecutor, wait
+from dataclasses import dataclass, asdict
+
+import numpy as np
+
+from transition_reader import DigitalChannel, channel_source, source_bytes, unpack_source
+
+FRAME_TYPES = {
+    'twice-every-word': 1,          # FRAME_TRANSITION_TWICE_EVERY_WORD
+    'once-every-word': 2,           # FRAME_TRANSITION_ONCE_EVERY_WORD (I2S, PCM standard)
+    'twice-every-four-words': 4,    # FRAME_TRANSITION_TWICE_EVERY_FOUR_WORDS
+}
+
+# I2sResultType values, so offline and plugin error types read the same
+ERROR_TOO_FEW_BITS = 2
+ERROR_DOESNT_DIVIDE_EVENLY = 3
+ERROR_TEST = 4
+ERROR_TYPE_NAMES = {ERROR_TOO_FEW_BITS: "too few bits", ERROR_DOESNT_DIVIDE_EVENLY: "bits don't divide evenly",
+                    ERROR_TEST: "test error"}
+
+MAX_REPORTED_ERRORS = 100
+SEGMENT_PAD_BITS = 8
+
+CHECKPOINT_VERSION = 1
+
+MAX_SEGMENT_TRANSITIONS = 1 << 22
+# working memory of a segment, per byte of CLOCK transitions in it
+DECODE_MEMORY_PER_INPUT_BYTE = 4
+STANDARD_FRAME_RATES = (8000, 11025, 16000, 22050, 24000, 32000, 44100, 48000, 88200, 96000, 176400, 192000, 352800,
+                        384000, 705600, 768000)
+
+
+@dataclass
+class DecodeSettings:
+    clock: int = 1
+    frame: int = 2
+    data: int = 3
+    data_valid_edge: str = 'rising'
+    bits_per_word: int = 32
+    frame_type: str = 'once-every-word'
+    word_alignment: str = 'left'
+    bit_shift: int = 1
+    lsb_first: bool = False
+    test: str = 'contiguous'
+    clock_gap_threshold: int = 0  # bit periods, 0 disables clock gap detection
+
+
+def open_channels(source, settings, first_transitions=(0, 0, 0)):
+    return tuple(DigitalChannel(channel_source(source, channel), first)
+                 for channel, first in zip((settings.clock, settings.frame, settings.data), first_transitions))
+
+
+def word_mask(bits):
+    return np.uint64((1 << bits) - 1) if bits < 64 else np.uint64(0xFFFFFFFFFFFFFFFF)
+
+
+def segment_bounds(source, settings, segments, first_transitions=(0, 0, 0), resume_time=-np.inf):
+    """Cut the capture from resume_time on at the FRAME rising edge after each of segments evenly spaced offsets."""
+    clock, frame, _ = open_channels(source, settings, first_transitions)
+    rising = frame.edges(rising=True)
+    if len(clock.times) < 2 or frame.edge_index(resume_time, rising=True, side='right') == len(rising):
+        return [(resume_time, np.inf)]
+
+    start = max(clock.times[0], resume_time)
+    end = clock.times[-1]
+    offsets = start + (end - start) * np.arange(1, segments) / segments
+    cuts = np.unique(rising[np.minimum(frame.edge_index(offsets, rising=True), len(rising) - 1)])
+    bounds = np.concatenate(([resume_time], cuts, [np.inf]))
+    return list(zip(bounds[:-1].tolist(), bounds[1:].tolist()))
+
+
+def decode_segment(source, settings, t_begin, t_end, first_transitions=(0, 0, 0), words=False):
+    """Decode the frames whose FRAME rising edge is in [t_begin, t_end).
+
+    Returns a summary that merge_segments() can stitch to its neighbours: counts, the errors found, and per channel
+    what the contiguous test needs to carry over the segment border. With words, 'word_stream' also holds the decoded
+    words in order as (values, channels, start times) arrays.
+    """
+    clock, frame, data = open_channels(source, settings, first_transitions)
+    valid_rising = settings.data_valid_edge == 'rising'
+
+    # from the frame before the segment on, so a clock gap that ended the previous segment is seen too, and a few
+    # bits either side, so frames that straddle the borders are complete.
+    previous_frame = frame.edge_index(t_begin, rising=True) - 1
+    window_begin = frame.edges(rising=True)[previous_frame] if previous_frame >= 0 else t_begin
+    first = max(clock.edge_index(window_begin, valid_rising) - SEGMENT_PAD_BITS, 0)
+    last = clock.edge_index(t_end, valid_rising) + SEGMENT_PAD_BITS
+    valid = np.ascontiguousarray(clock.edges(valid_rising)[first:last])
+
+    result = new_segment_result(t_begin)
+    if len(valid) < 2:
+        return result
+
+    ws = frame.levels_at(valid)
+    bits = data.levels_at(valid)
+
+    # bit i - 1 to bit i crosses a clock gap
+    periods = np.diff(valid)
+    gap_after = np.zeros(len(valid), dtype=bool)
+    if settings.clock_gap_threshold > 0:
+        nominal = float(np.median(periods))
+        gap_after[:-1] = periods > nominal * settings.clock_gap_threshold
+
+    # frames start where FRAME is first read high, a rising edge across a clock gap doesn't count.
+    detected = np.flatnonzero((ws[1:] == 1) & (ws[:-1] == 0) & ~gap_after[:-1]) + 1
+    edge_times = frame.times[frame.search(valid[detected], side='right') - 1]
+    starts = detected + settings.bit_shift
+    ends = np.append(starts[1:], len(valid))
+    in_range = (edge_times >= t_begin) & (edge_times < t_end)
+    owned = in_range & (ends <= len(valid) - 1)
+    if len(owned):
+        owned[-1] = False
+
+    # frames still waiting for their end are left to the next run over a growing capture, so are the clock stats.
+    incomplete = np.flatnonzero(in_range & ~owned)
+    if len(incomplete):
+        result['resume_time'] = float(edge_times[incomplete[0]])
+    stats_end = min(t_end, result['resume_time']) if result['resume_time'] is not None else t_end
+    in_segment = (valid[1:] >= t_begin) & (valid[1:] < stats_end)
+    if np.any(in_segment & ~gap_after[:-1]):
+        result['bit_period_min'] = float(periods[in_segment & ~gap_after[:-1]].min())
+        result['bit_period_max'] = float(periods[in_segment & ~gap_after[:-1]].max())
+    result['clock_gaps'] = int(np.count_nonzero(gap_after[:-1] & in_segment))
+
+    # drop frames cut by a clock gap, the test starts over after it.
+    gap_index = np.flatnonzero(gap_after[:-1])
+    gap_count_before = np.searchsorted(gap_index, starts)
+    gap_count_to_end = np.searchsorted(gap_index, ends - 1)
+    cut_by_gap = gap_count_to_end != gap_count_before
+
+    keep = owned & ~cut_by_gap
+    if not np.any(keep):
+        return result
+    kept = np.flatnonzero(keep)
+    restart = np.zeros(len(starts), dtype=bool)
+    restart[kept[1:]] = gap_count_before[kept[1:]] != gap_count_to_end[kept[:-1]]
+    # merge_segments() decides if this one is after the previous segment's last frame.
+    if gap_count_before[kept[0]] > 0:
+        result['gap_before'] = float(valid[gap_index[gap_count_before[kept[0]] - 1] + 1])
+
+    words_per_frame = FRAME_TYPES[settings.frame_type]
+    lengths = ends - starts
+    result['frames'] = int(len(kept))
+    result['first_time'] = float(valid[starts[kept[0]]])
+    result['last_time'] = float(valid[ends[kept[-1]] - 1])
+    result['frame_time'] = float(np.sum(valid[ends[kept]] - valid[starts[kept]]))
+
+    frame_error = np.zeros(len(starts), dtype=np.int64)
+    frame_error[keep & (lengths % words_per_frame != 0)] = ERROR_DOESNT_DIVIDE_EVENLY
+    frame_error[keep & (frame_error == 0) & (lengths // words_per_frame < settings.bits_per_word)] = ERROR_TOO_FEW_BITS
+    for index in np.flatnonzero(frame_error):
+        result['frame_errors'] += 1
+        if len(result['errors']) < MAX_REPORTED_ERRORS:
+            result['errors'].append(error_entry(valid[starts[index]], valid[ends[index] - 1], 0, 0, 0,
+                                                int(frame_error[index])))
+
+    # gather the words of all good frames of the same length in one go.
+    good = np.flatnonzero(keep & (frame_error == 0))
+    n_bits = settings.bits_per_word
+    word_frames = []
+    word_values = []
+    word_starts = []
+    word_ends = []
+    word_subframes = []
+    for length in np.unique(lengths[good]):
+        group = good[lengths[good] == length]
+        slot = int(length) // words_per_frame
+        offset = 0 if settings.word_alignment == 'left' else slot - n_bits
+        for subframe in range(words_per_frame):
+            first_bit = starts[group] + subframe * slot + offset
+            matrix = bits[first_bit[:, None] + np.arange(n_bits)]
+            word_values.append(pack_words(matrix, settings.lsb_first))
+            word_frames.append(group)
+            word_starts.append(valid[first_bit])
+            word_ends.append(valid[first_bit + n_bits - 1])
+            word_subframes.append(np.full(len(group), subframe))
+
+    if not word_values:
+        return result
+    frames_of_words = np.concatenate(word_frames)
+    subframes = np.concatenate(word_subframes)
+    order = np.lexsort((subframes, frames_of_words))
+    values = np.concatenate(word_values)[order]
+    times = np.stack((np.concatenate(word_starts)[order], np.concatenate(word_ends)[order]), axis=1)
+    subframes = subframes[order]
+    word_restart = restart[frames_of_words[order]] & (subframes < 2)
+    if words:
+        result['word_stream'] = (values, (subframes & 1).astype(np.uint8), times[:, 0])
+
+    for channel in (0, 1):
+        selected = (subframes & 1) == channel
+        summary = channel_summary(values[selected], times[selected], word_restart[selected], channel, settings)
+        result['channels'][channel] = summary
+    return result
+
+
+def pack_words(matrix, lsb_first):
+    """Rows of bits, first bit first, into uint64 words."""
+    values = np.zeros(matrix.shape[0], dtype=np.uint64)
+    columns = range(matrix.shape[1] - 1, -1, -1) if lsb_first else range(matrix.shape[1])
+    for column in columns:
+        values = (values << np.uint64(1)) | matrix[:, column].astype(np.uint64)
+    return values
+
+
+def popcount(values):
+    """Set bits of each uint64."""
+    return np.unpackbits(np.ascontiguousarray(values, dtype=np.uint64).view(np.uint8).reshape(-1, 8), axis=1).sum(axis=1)
+
+
+def new_segment_result(t_begin):
+    return {'begin': t_begin, 'resume_time': None, 'frames': 0, 'frame_time': 0.0, 'frame_errors': 0, 'clock_gaps': 0, 'gap_before': None,
+            'first_time': None, 'last_time': None, 'bit_period_min': None, 'bit_period_max': None,
+            'errors': [], 'channels': [None, None]}
+
+
+def error_entry(start_time, end_time, channel, expected, received, error_type):
+    return {'start': float(start_time), 'end': float(end_time), 'channel': int(channel), 'expected': int(expected),
+            'received': int(received), 'type': int(error_type)}
+
+
+def channel_summary(values, times, restart, channel, settings):
+    """Contiguous test of one channel's words, as far as it can be done without the previous segment.
+
+    TestExtension::process() reports a word that isn't the previous one + 1, then skips checking the word after it.
+    So inside a run of mismatches every other word is an error, starting with the first. The first word of the
+    segment is unchecked here, merge_segments() fixes up the leading run once it knows what came before.
+    """
+    count = len(values)
+    summary = {'words': int(count), 'first_value': None, 'last_value': None, 'lead_run': 0, 'lead_words': [],
+               'lead_bit_errors': [0, 0], 'last_error': False, 'errors': 0, 'bit_errors': 0, 'error_list': []}
+    if count == 0:
+        return summary
+    summary['first_value'] = int(values[0])
+    summary['last_value'] = int(values[-1])
+    if settings.test != 'contiguous':
+        return summary
+
+    mask = word_mask(settings.bits_per_word)
+    mismatch = np.zeros(count, dtype=bool)
+    mismatch[1:] = values[1:] != ((values[:-1] + np.uint64(1)) & mask)
+    mismatch &= ~restart
+    mismatch[0] = False
+
+    positions = np.arange(count)
+    last_match = np.maximum.accumulate(np.where(mismatch, -1, positions))
+    errors = mismatch & ((positions - last_match - 1) % 2 == 0)
+
+    lead_run = count - 1 if np.all(mismatch[1:]) else int(np.argmin(mismatch[1:]))
+    summary['lead_run'] = lead_run
+    # bit errors at the odd and the even positions of the run, merge_segments() picks the ones that are errors.
+    run_bits = popcount(values[1:lead_run + 1] ^ ((values[:lead_run] + np.uint64(1)) & mask))
+    summary['lead_bit_errors'] = [int(run_bits[0::2].sum()), int(run_bits[1::2].sum())]
+    summary['lead_words'] = [(int(values[i]), float(times[i][0]), float(times[i][1]))
+                             for i in range(min(lead_run + 1, MAX_REPORTED_ERRORS))]
+    summary['last_error'] = bool(errors[-1])
+
+    # errors past the leading run don't depend on the previous segment.
+    later = np.flatnonzero(errors[lead_run + 1:]) + lead_run + 1
+    summary['errors'] = int(len(later))
+    summary['bit_errors'] = int(popcount(values[later] ^ ((values[later - 1] + np.uint64(1)) & mask)).sum())
+    for index in later[:MAX_REPORTED_ERRORS]:
+        expected = (values[index - 1] + np.uint64(1)) & mask
+        summary['error_list'].append(error_entry(times[index][0], times[index][1], channel, expected, values[index],
+                                                 ERROR_TEST))
+    return summary
+
+
+def merge_segments(segments, settings, resumed=None):
+    """Stitch per-segment results in capture order into one summary, carrying on from a previous run's summary."""
+    mask = int(word_mask(settings.bits_per_word))
+    if resumed is not None:
+        total = copy.deepcopy(resumed)
+    else:
+        total = {'frames': 0, 'frame_time': 0.0, 'frame_errors': 0, 'clock_gaps': 0, 'test_errors': 0,
+                 'bit_errors': 0, 'words': [0, 0], 'first_time': None, 'last_time': None, 'bit_period_min': None,
+                 'bit_period_max': None, 'errors': [], 'test_state': [None, None]}
+    # (last value, last word was an error) per channel
+    previous = total['test_state']
+
+    for segment in segments:
+        total['frames'] += segment['frames']
+        total['frame_time'] += segment['frame_time']
+        total['frame_errors'] += segment['frame_errors']
+        total['clock_gaps'] += segment['clock_gaps']
+        total['errors'].extend(segment['errors'])
+        for key, pick in (('bit_period_min', min), ('bit_period_max', max)):
+            if segment[key] is not None:
+                total[key] = segment[key] if total[key] is None else pick(total[key], segment[key])
+        if segment['gap_before'] is not None and (total['last_time'] is None
+                                                  or segment['gap_before'] > total['last_time']):
+            previous = [None, None]
+        if segment['first_time'] is not None:
+            if total['first_time'] is None:
+                total['first_time'] = segment['first_time']
+            total['last_time'] = segment['last_time']
+
+        for channel, summary in enumerate(segment['channels']):
+            if summary is None or summary['words'] == 0:
+                continue
+            total['words'][channel] += summary['words']
+            total['test_errors'] += summary['errors']
+            total['bit_errors'] += summary['bit_errors']
+            total['errors'].extend(summary['error_list'])
+            if settings.test != 'contiguous':
+                continue
+
+            # the leading run of mismatches alternates from whatever the previous segment ended on.
+            first_error = False
+            expected = None
+            if previous[channel] is not None:
+                last_value, last_error = previous[channel]
+                expected = (last_value + 1) & mask
+                first_error = summary['first_value'] != expected and not last_error
+            run = summary['lead_run']
+            if first_error:
+                total['test_errors'] += 1 + run // 2
+                total['bit_errors'] += bin(summary['first_value'] ^ expected).count('1') + summary['lead_bit_errors'][1]
+            else:
+                total['test_errors'] += (run + 1) // 2
+                total['bit_errors'] += summary['lead_bit_errors'][0]
+
+            lead = summary['lead_words']
+            for position, (value, start, end) in enumerate(lead):
+                if position > 0:
+                    expected = (lead[position - 1][0] + 1) & mask
+                if (position % 2 == 0) == first_error:
+                    total['errors'].append(error_entry(start, end, channel, expected, value, ERROR_TEST))
+            last_error = ((run % 2 == 0) == first_error) if run == summary['words'] - 1 else summary['last_error']
+            previous[channel] = [summary['last_value'], last_error]
+
+    total['errors'].sort(key=lambda entry: entry['start'])
+    total['errors'] = total['errors'][:MAX_REPORTED_ERRORS]
+    total['test_state'] = previous
+    return total
+
+
+def decode_capture(source, settings, jobs=None, segments=None, checkpoint=None):
+    """Decode a whole capture, in parallel segments when jobs > 1.
+
+    With a checkpoint from an earlier run over the same, since grown, capture only what was appended is decoded.
+    The summary then covers the whole capture and its 'checkpoint' entry is where the next run carries on from.
+    """
+    jobs = jobs or os.cpu_count() or 1
+    source, temporary = unpack_source(source, (settings.clock, settings.frame, settings.data))
+    try:
+        return decode_unpacked(source, settings, jobs, segments, checkpoint)
+    finally:
+        if temporary:
+            shutil.rmtree(temporary, ignore_errors=True)
+
+
+def decode_unpacked(source, settings, jobs, segments, checkpoint):
+    segments = max(segments or jobs * 4,
+                   math.ceil(source_bytes(source, settings.clock) / 8 / MAX_SEGMENT_TRANSITIONS))
+    resumed = checkpoint if checkpoint_matches(checkpoint, source, settings) else None
+    first_transitions = tuple(resumed['first_transitions']) if resumed else (0, 0, 0)
+    resume_time = resumed['resume_time'] if resumed else -np.inf
+
+    bounds = segment_bounds(source, settings, segments, first_transitions, resume_time)
+    if jobs == 1 or len(bounds) == 1:
+        results = [decode_segment(source, settings, begin, end, first_transitions) for begin, end in bounds]
+    else:
+        with ProcessPoolExecutor(max_workers=jobs) as pool:
+            futures = [pool.submit(decode_segment, source, settings, begin, end, first_transitions)
+                       for begin, end in bounds]
+            results = [future.result() for future in futures]
+
+    # nothing complete in the last segment, the next run decodes it again.
+    next_resume = results[-1]['resume_time']
+    if next_resume is None and np.isfinite(results[-1]['begin']):
+        next_resume = results[-1]['begin']
+        results.pop()
+
+    summary = merge_segments(results, settings, resumed['summary'] if resumed else None)
+    summary['checkpoint'] = make_checkpoint(source, settings, first_transitions, next_resume, summary) \
+        if next_resume is not None else checkpoint if resumed else None
+    summary['resumed_from'] = resumed['resume_time'] if resumed else None
+    summary['settings'] = asdict(settings)
+    summary['segments'] = len(bounds)
+    return summary
+
+
+def make_checkpoint(source, settings, first_transitions, resume_time, summary):
+    """Where the next run over this capture starts: the transitions to skip and the summary so far.
+
+    The next run needs the frame before resume_time too (see decode_segment()), so the skipped transitions stop a
+    frame and a few bits earlier. The last skipped transition of each channel is kept to check the file is the same.
+    """
+    clock, frame, data = open_channels(source, settings, first_transitions)
+    valid_rising = settings.data_valid_edge == 'rising'
+    valid = clock.edges(valid_rising)
+    previous_frame = frame.edge_index(resume_time, rising=True) - 1
+    load_from = frame.edges(rising=True)[previous_frame] if previous_frame >= 0 else resume_time
+    first = max(clock.edge_index(load_from, valid_rising) - SEGMENT_PAD_BITS - 2, 0)
+    load_from = min(load_from, valid[first]) if len(valid) else load_from
+
+    skip = [channel.transitions_before(load_from) for channel in (clock, frame, data)]
+    state = {key: value for key, value in summary.items() if key != 'checkpoint'}
+    return {'version': CHECKPOINT_VERSION, 'settings': asdict(settings), 'first_transitions': skip,
+            'last_skipped': [checkpoint_sample(channel, index) for channel, index in zip((clock, frame, data), skip)],
+            'resume_time': resume_time, 'summary': state}
+
+
+def checkpoint_sample(channel, index):
+    """Time of transition index - 1, or None for the start of the file."""
+    if index == 0:
+        return None
+    sample = channel.transition(index - 1)
+    return sample if sample is not None else DigitalChannel(channel.source).transition(index - 1)
+
+
+def checkpoint_matches(checkpoint, source, settings):
+    """The checkpoint is for these settings, and the capture still starts with the transitions it skips."""
+    if not checkpoint or checkpoint.get('version') != CHECKPOINT_VERSION or checkpoint['settings'] != asdict(settings):
+        return False
+    for channel, index, sample in zip((settings.clock, settings.frame, settings.data),
+                                      checkpoint['first_transitions'], checkpoint['last_skipped']):
+        if index > 0 and DigitalChannel(channel_source(source, channel)).transition(index - 1) != sample:
+            return False
+    return True
+
+
+def find_captures(paths, settings):
+    """Captures among paths: directories holding a binary export of the CLOCK channel, .sal files, zipped exports, and
+    text files listing any of these, one per line. Directories without an export are searched recursively."""
+    captures = []
+    for path in paths:
+        if os.path.isdir(path):
+            try:
+                channel_source(path, settings.clock)
+                captures.append(path)
+                continue
+            except FileNotFoundError:
+                pass
+            for entry in sorted(os.listdir(path)):
+                entry_path = os.path.join(path, entry)
+                if os.path.isdir(entry_path) or entry.endswith(('.sal', '.zip')):
+                    captures.extend(find_captures([entry_path], settings))
+        elif path.endswith(('.sal', '.zip')):
+            captures.append(path)
+        elif os.path.isfile(path):
+            with open(path) as f:
+                listed = [line.strip() for line in f if line.strip() and not line.startswith('#')]
+            captures.extend(find_captures(listed, settings))
+    return captures
+
+
+class SalExporter:
+    """Converts .sal files to binary exports through a running Logic 2, which is the only thing that reads them."""
+
+    def __init__(self, port, settings):
+        self.port = port
+        self.channels = sorted({settings.clock, settings.frame, settings.data})
+        self.manager = None
+
+    def export(self, sal_path):
+        if self.manager is None:
+            from saleae import automation
+            self.manager = automation.Manager.connect(port=self.port)
+        directory = tempfile.mkdtemp(prefix='i2s-batch-')
+        with self.manager.load_capture(filepath=os.path.abspath(sal_path)) as capture:
+            capture.export_raw_data_binary(directory=directory, digital_channels=self.channels)
+        return directory
+
+    def close(self):
+        if self.manager is not None:
+            self.manager.close()
+
+
+def input_bytes(source, settings):
+    return sum(source_bytes(source, channel) for channel in {settings.clock, settings.frame, settings.data})
+
+
+def decode_memory(source, settings):
+    """Working memory estimate of decode_batch_entry(), which decodes one capped segment at a time."""
+    return min(source_bytes(source, settings.clock), MAX_SEGMENT_TRANSITIONS * 8) * DECODE_MEMORY_PER_INPUT_BYTE
+
+
+def decode_batch_entry(path, directory, settings, segments):
+    """One capture of a batch, in a worker process. Returns its report line."""
+    started = time.perf_counter()
+    summary = decode_capture(directory, settings, jobs=1, segments=segments)
+    return capture_report(path, summary, input_bytes(directory, settings), time.perf_counter() - started, settings)
+
+
+def capture_report(path, summary, size, seconds, settings, nominal_rate=None):
+    duration = (summary['last_time'] - summary['first_time']) if summary['first_time'] is not None else 0.0
+    frame_rate = summary['frames'] / summary['frame_time'] if summary['frame_time'] > 0 else None
+    words = sum(summary['words'])
+    bits_checked = words * settings.bits_per_word if settings.test == 'contiguous' else 0
+    return {
+        'capture': path,
+        'frames': summary['frames'],
+        'words': words,
+        'duration': duration,
+        'frame_rate': frame_rate,
+        'nominal_rate': nominal_rate,
+        'ppm': None,
+        'frame_errors': summary['frame_errors'],
+        'test_errors': summary['test_errors'],
+        'clock_gaps': summary['clock_gaps'],
+        'bit_errors': summary['bit_errors'],
+        'bits_checked': bits_checked,
+        'ber': summary['bit_errors'] / bits_checked if bits_checked else None,
+        'first_errors': summary['errors'][:10],
+        'input_bytes': size,
+        'decode_seconds': seconds,
+        'realtime_factor': duration / seconds if seconds > 0 else None,
+        'error': None,
+    }
+
+
+def apply_nominal_rate(report, nominal_rate):
+    """Frame rate drift against nominal_rate, or against the nearest standard rate when None."""
+    if report['frame_rate'] is None:
+        return
+    if nominal_rate is None:
+        nominal_rate = min(STANDARD_FRAME_RATES, key=lambda rate: abs(rate - report['frame_rate']))
+    report['nominal_rate'] = nominal_rate
+    report['ppm'] = (report['frame_rate'] / nominal_rate - 1.0) * 1e6
+
+
+def decode_batch(paths, settings, jobs=None, memory_budget=None, segments=None, nominal_rate=None, logic2_port=10430,
+                 progress=None):
+    """Decode many captures, up to jobs at a time, and report on all of them.
+
+    Captures are queued in order and a worker only picks up the next one while the estimated working memory of
+    everything in flight stays within memory_budget bytes. A capture bigger than the budget runs on its own.
+    .sal files are exported one at a time through Logic 2 just before they are decoded, and the export is deleted after.
+    """
+    jobs = jobs or os.cpu_count() or 1
+    captures = find_captures(paths, settings)
+    reports = {}
+    exporter = None
+    started = time.perf_counter()
+
+    queue = list(reversed(captures))
+    ready = None  # (path, directory, export directory to delete, memory estimate) of the next capture
+    in_flight = {}  # future -> ready entry
+    used = 0
+    try:
+        with ProcessPoolExecutor(max_workers=jobs) as pool:
+            while queue or ready or in_flight:
+                while (queue or ready) and len(in_flight) < jobs:
+                    if ready is None:
+                        path = queue.pop()
+                        temporary = None
+                        try:
+                            directory = path
+                            if path.endswith('.sal'):
+                                exporter = exporter or SalExporter(logic2_port, settings)
+                                directory = temporary = exporter.export(path)
+                            ready = (path, directory, temporary, decode_memory(directory, settings))
+                        except Exception as error:
+                            reports[path] = failed_report(path, error)
+                            if temporary:
+                                shutil.rmtree(temporary, ignore_errors=True)
+                            if progress:
+                                progress(reports[path], len(reports), len(captures))
+                            continue
+                    if in_flight and memory_budget and used + ready[3] > memory_budget:
+                        break
+                    future = pool.submit(decode_batch_entry, ready[0], ready[1], settings, segments)
+                    in_flight[future] = ready
+                    used += ready[3]
+                    ready = None
+
+                if not in_flight:
+                    continue
+                done, _ = wait(in_flight, return_when=FIRST_COMPLETED)
+                for future in done:
+                    path, _, temporary, estimate = in_flight.pop(future)
+                    used -= estimate
+                    if temporary:
+                        shutil.rmtree(temporary, ignore_errors=True)
+                    try:
+                        reports[path] = future.result()
+                        apply_nominal_rate(reports[path], nominal_rate)
+                    except Exception as error:
+                        reports[path] = failed_report(path, error)
+                    if progress:
+                        progress(reports[path], len(reports), len(captures))
+    finally:
+        if exporter:
+            exporter.close()
+
+    ordered = [reports[path] for path in captures]
+    return {'captures': ordered, 'totals': batch_totals(ordered, time.perf_counter() - started),
+            'settings': asdict(settings)}
+
+
+def failed_report(path, error):
+    return {'capture': path, 'error': f"{type(error).__name__}: {error}"}
+
+
+def batch_totals(reports, seconds):
+    decoded = [report for report in reports if report['error'] is None]
+    totals = {'captures': len(reports), 'failed': len(reports) - len(decoded), 'wall_seconds': seconds}
+    for key in ('frames', 'words', 'frame_errors', 'test_errors', 'clock_gaps', 'bit_errors', 'bits_checked',
+                'input_bytes', 'duration'):
+        totals[key] = sum(report[key] for report in decoded)
+    totals['ber'] = totals['bit_errors'] / totals['bits_checked'] if totals['bits_checked'] else None
+    drifts = [report['ppm'] for report in decoded if report['ppm'] is not None]
+    totals['ppm_min'] = min(drifts) if drifts else None
+    totals['ppm_max'] = max(drifts) if drifts else None
+    totals['bytes_per_second'] = totals['input_bytes'] / seconds if seconds > 0 else None
+    totals['realtime_factor'] = totals['duration'] / seconds if seconds > 0 else None
+    return totals
@@ -21,7 +21,7 @@ def main():
     with automation.Manager.connect(port=10430) as manager:
         device_configuration = automation.LogicDeviceConfiguration(
             enabled_digital_channels=[0, 1, 2, 3],
-            digital_sample_rate=500_000_000,
+            digital_sample_rate=SAMPLE_RATE,
             digital_threshold_volts=3.3,
         )
 
@@ -74,6 +74,7 @@ def main():
 
             # Export raw digital data
             capture.export_raw_data_csv(directory=output_dir, digital_channels=[0, 1, 2, 3])
+            capture.export_raw_data_binary(directory=output_dir, digital_channels=[0, 1, 2, 3])
 
             # Save the capture to a file
             capture_filepath = os.path.join(output_dir, 'i2s_test.sal')
@@ -114,7 +115,18 @@ def start_server(host, port, capture, stop_event):
                         if len(data) == 16:
                             try:
                                 value1, value2 = deserialize(data)
-                                if value1 == 1111 and value2 == 9999:
+                                if value1 == RECORD_MAGIC:
+                                    record_type = value2 >> 32
+                                    fields = receive_fields(conn, value2 & 0xFFFFFFFF)
+                                    if fields is None:
+                                        print(f"Connection closed by {addr}")
+                                        break
+                                    log_record(record_type, fields)
+                                    if record_type == RECORD_ERROR and fields[5] == ERROR_TYPE_TEST:
+                                        capture.stop()
+                                        print("Capture stopped by test error.")
+                                        break
+                                elif value1 == 1111 and value2 == 9999:
                                     capture.stop()
                                     print("Capture stopped by external command.")
                                     break
@@ -131,6 +143,173 @@ def start_server(host, port, capture, stop_event):
                 # Continue loop to check stop_event after timeout
                 continue
 
+RECORD_MAGIC = 0x5245434F5244
+RECORD_FAULT_MAP = 1
+RECORD_ERROR = 2
+RECORD_AUDIO_QUALITY = 3
+RECORD_LEVEL = 4
+RECORD_REFERENCE = 5
+RECORD_LATENCY = 6
+RECORD_LOCKSTEP = 7
+RECORD_SEQUENCE = 8
+RECORD_STARTUP = 9
+RECORD_CLOCK_RECOVERY = 10
+RECORD_CLOCK_TREE_EVENT = 11
+RECORD_CLOCK_TREE = 12
+RECORD_JITTER_SPECTRUM = 13
+RECORD_CLOCK_GLITCH = 14
+RECORD_CLOCK_PULSES = 15
+RECORD_FRAME_SLIP = 16
+RECORD_FRAME_LENGTH = 17
+RECORD_SAMPLE_RATE = 18
+RECORD_RATE_SEGMENT = 19
+
+# I2sResultType values used as the error type of error records
+ERROR_TYPE_NAMES = {2: "too few bits", 3: "bits don't divide evenly", 4: "test error"}
+ERROR_TYPE_TEST = 4
+SAMPLE_RATE = 500_000_000
+LOCKSTEP_STATE_NAMES = {0: "in step", 1: "skewed", 2: "swapped", 3: "mismatch"}
+REFERENCE_EVENT_NAMES = {0: "locked", 2: "drop", 3: "repeat", 4: "lock lost", 5: "reference end"}
+SEQUENCE_EVENT_NAMES = {0: "drop", 1: "duplicate", 2: "reorder", 3: "corruption"}
+STARTUP_MILESTONE_NAMES = ["CLOCK edge", "FRAME edge", "valid frame", "test pass"]
+CLOCK_TREE_EVENT_NAMES = {0: "MCLK per FRAME", 1: "CLOCK per FRAME", 2: "MCLK phase slip", 3: "CLOCK phase slip"}
+JITTER_BAND_NAMES = ["<1 kHz", "1-10 kHz", "10-100 kHz", "0.1-1 MHz", ">1 MHz"]
+STARTUP_NOT_REACHED = 0xFFFFFFFFFFFFFFFF
+
+def receive_fields(conn, count):
+    data = b''
+    while len(data) < count * 8:
+        chunk = conn.recv(count * 8 - len(data))
+        if not chunk:
+            return None
+        data += chunk
+    return struct.unpack(f'<{count}Q', data)
+
+def log_record(record_type, fields):
+    if record_type == RECORD_FAULT_MAP:
+        channel, errors, mismatch_mask, stuck_high, stuck_low = fields[0:5]
+        slips = fields[5:9]
+        bit_errors = {bit: count for bit, count in enumerate(fields[9:]) if count}
+        print(f"Fault map ch{channel}: errors: {errors}, mismatch mask: {mismatch_mask:#x}, "
+              f"stuck high: {stuck_high:#x}, stuck low: {stuck_low:#x}, "
+              f"slips left 1/2: {slips[0]}/{slips[1]}, right 1/2: {slips[2]}/{slips[3]}, bits: {bit_errors}")
+    elif record_type == RECORD_ERROR:
+        start_sample, end_sample, channel, expected, received, error_type = fields
+        print(f"Error: {ERROR_TYPE_NAMES.get(error_type, error_type)} on ch{channel} at sample {start_sample}-{end_sample} "
+              f"({start_sample / SAMPLE_RATE:.9f} s), expected: {expected:#x}, received: {received:#x}")
+    elif record_type == RECORD_AUDIO_QUALITY:
+        channel, first_sample, last_sample = fields[0:3]
+        frequency, thd_n, snr, dc_offset = struct.unpack('<4d', struct.pack('<4Q', *fields[3:7]))
+        print(f"Audio ch{channel} @ {last_sample / SAMPLE_RATE:.6f} s: {frequency:.2f} Hz, THD+N: {thd_n:.2f} dB, "
+              f"SNR: {snr:.2f} dB, DC: {dc_offset * 100:.4f} %FS")
+    elif record_type == RECORD_LEVEL:
+        channel, is_total, first_sample, last_sample, count = fields[0:5]
+        minimum, maximum = struct.unpack('<2q', struct.pack('<2Q', *fields[5:7]))
+        clipped, longest_silence = fields[7:9]
+        mean, rms = struct.unpack('<2d', struct.pack('<2Q', *fields[9:11]))
+        print(f"Level ch{channel} {'total' if is_total else 'block'} ({count} words): min: {minimum}, max: {maximum}, "
+              f"DC: {mean * 100:.4f} %FS, RMS: {rms * 100:.4f} %FS, clipped: {clipped}, longest silence: {longest_silence}")
+    elif record_type == RECORD_REFERENCE:
+        kind, first_sample, position, frames = fields
+        print(f"Reference {REFERENCE_EVENT_NAMES.get(kind, kind)} at frame {position} "
+              f"(sample {first_sample}, {first_sample / SAMPLE_RATE:.9f} s)" + (f", {frames} frames" if frames else ""))
+    elif record_type == RECORD_LATENCY:
+        first_sample, last_sample, matches, unmatched, latency, minimum, maximum, total_min, total_max = fields[0:9]
+        mean, jitter, frame_period = struct.unpack('<3d', struct.pack('<3Q', *fields[9:12]))
+        ns = 1e9 / SAMPLE_RATE
+        print(f"Latency @ {last_sample / SAMPLE_RATE:.6f} s ({matches} matches, {unmatched} unmatched): "
+              f"{latency * ns:.1f} ns ({latency / frame_period if frame_period else 0:.3f} frames), "
+              f"min: {minimum * ns:.1f} ns, max: {maximum * ns:.1f} ns, mean: {mean * ns:.1f} ns, jitter: {jitter * ns:.1f} ns rms, "
+              f"total min/max: {total_min * ns:.1f}/{total_max * ns:.1f} ns")
+    elif record_type == RECORD_LOCKSTEP:
+        channel, state, value, first_sample, previous_frames = fields
+        value = struct.unpack('<q', struct.pack('<Q', value))[0]
+        detail = {1: f" by {value} frames", 2: f", carries ch{value}"}.get(state, "")
+        print(f"Lock-step ch{channel} {LOCKSTEP_STATE_NAMES.get(state, state)}{detail} at sample {first_sample} "
+              f"({first_sample / SAMPLE_RATE:.9f} s), after {previous_frames} frames")
+    elif record_type == RECORD_SEQUENCE:
+        kind, first_sample, sequence, expected, frames = fields
+        detail = {0: f", {frames} frames", 2: f", {frames} frames late"}.get(kind, "")
+        print(f"Sequence {SEQUENCE_EVENT_NAMES.get(kind, kind)} of frame {sequence} (expected {expected}) at sample {first_sample} "
+              f"({first_sample / SAMPLE_RATE:.9f} s){detail}")
+    elif record_type == RECORD_STARTUP:
+        cycle, complete, anchor = fields[0:3]
+        milestones = [f"{name} +{(sample - anchor) / SAMPLE_RATE * 1000:.3f} ms"
+                      for name, sample in zip(STARTUP_MILESTONE_NAMES, fields[3:7]) if sample != STARTUP_NOT_REACHED]
+        print(f"Startup cycle {cycle} {'complete' if complete else 'incomplete'} from sample {anchor} "
+              f"({anchor / SAMPLE_RATE:.9f} s): {', '.join(milestones)}")
+    elif record_type == RECORD_CLOCK_RECOVERY:
+        locked, lock_changed, first_sample, last_sample, frames, bad_frames, edges = fields[0:7]
+        bit_period, jitter_rms, jitter_pp = struct.unpack('<3d', struct.pack('<3Q', *fields[7:10]))
+        ns = 1e9 / SAMPLE_RATE
+        event = ("locked" if locked else "lock lost") if lock_changed else ("locked" if locked else "unlocked")
+        print(f"Recovered clock {event} @ {last_sample / SAMPLE_RATE:.6f} s: {SAMPLE_RATE / bit_period if bit_period else 0:.0f} Hz, "
+              f"jitter: {jitter_rms * ns:.2f} ns rms, {jitter_pp * ns:.2f} ns peak to peak, "
+              f"{frames} frames ({bad_frames} slipped), {edges} edges")
+    elif record_type == RECORD_CLOCK_TREE_EVENT:
+        kind, sample = fields[0:2]
+        previous, current = struct.unpack('<2d', struct.pack('<2Q', *fields[2:4]))
+        print(f"Clock tree {CLOCK_TREE_EVENT_NAMES.get(kind, kind)} {previous:g} -> {current:g} @ {sample / SAMPLE_RATE:.6f} s")
+    elif record_type == RECORD_CLOCK_TREE:
+        first_sample, last_sample, frames, mclk_per_frame, clock_per_frame, ratio_changes, phase_slips = fields[0:7]
+        phases = struct.unpack('<6d', struct.pack('<6Q', *fields[7:13]))
+        detail = "".join(f", {name} phase {mean:.3f} ({rms:.4f} rms, {pp:.4f} pp)"
+                         for name, (mean, rms, pp) in zip(["MCLK", "CLOCK"], [phases[0:3], phases[3:6]]) if mean >= 0)
+        print(f"Clock tree @ {last_sample / SAMPLE_RATE:.6f} s: {mclk_per_frame} MCLK, {clock_per_frame} CLOCK per FRAME over {frames} frames, "
+              f"{ratio_changes} ratio changes, {phase_slips} phase slips{detail}")
+    elif record_type == RECORD_JITTER_SPECTRUM:
+        first_sample, last_sample, blocks, spur_count = fields[0:4]
+        values = struct.unpack(f'<{7 + 2 * spur_count}d', struct.pack(f'<{7 + 2 * spur_count}Q', *fields[4:11 + 2 * spur_count]))
+        bit_period, rms = values[0:2]
+        ns = 1e9 / SAMPLE_RATE
+        bands = ", ".join(f"{name}: {band * ns:.3f}" for name, band in zip(JITTER_BAND_NAMES, values[2:7]))
+        spurs = ", ".join(f"{values[i]:.0f} Hz {values[i + 1] * ns:.3f} ns" for i in range(7, len(values), 2))
+        print(f"Jitter spectrum @ {last_sample / SAMPLE_RATE:.6f} s: {SAMPLE_RATE / bit_period if bit_period else 0:.0f} Hz, "
+              f"{rms * ns:.3f} ns rms over {blocks} blocks ({bands} ns)" + (f", spurs: {spurs}" if spurs else ""))
+    elif record_type == RECORD_CLOCK_GLITCH:
+        first_sample, last_sample, pulses, shortest, shortest_high = fields
+        ns = 1e9 / SAMPLE_RATE
+        print(f"CLOCK glitch @ {first_sample / SAMPLE_RATE:.9f} s: {pulses} short pulses over {(last_sample - first_sample) * ns:.1f} ns, "
+              f"shortest {shortest * ns:.1f} ns {'high' if shortest_high else 'low'}")
+    elif record_type == RECORD_CLOCK_PULSES:
+        first_sample, last_sample, glitches, glitch_pulses = fields[0:4]
+        high_count, high_min, high_max, low_count, low_min, low_max = fields[4:10]
+        high_mean, low_mean, duty, duty_min, duty_max = struct.unpack('<5d', struct.pack('<5Q', *fields[10:15]))
+        ns = 1e9 / SAMPLE_RATE
+        detail = f"duty cycle {duty * 100:.2f} % ({duty_min * 100:.2f} - {duty_max * 100:.2f} %), " if duty >= 0 else ""
+        print(f"CLOCK pulses @ {last_sample / SAMPLE_RATE:.6f} s: {detail}"
+              f"high {high_mean * ns:.1f} ns ({high_min * ns:.1f} - {high_max * ns:.1f}, {high_count} pulses), "
+              f"low {low_mean * ns:.1f} ns ({low_min * ns:.1f} - {low_max * ns:.1f}, {low_count} pulses), "
+              f"{glitches} glitches ({glitch_pulses} pulses)")
+    elif record_type == RECORD_FRAME_SLIP:
+        sample, bits, nominal = fields
+        print(f"FRAME slip @ {sample / SAMPLE_RATE:.9f} s: {bits} bits instead of {nominal}")
+    elif record_type == RECORD_FRAME_LENGTH:
+        first_sample, last_sample, frames, nominal, slips, total_slips, truncated, other = fields[0:8]
+        run_count, length_count, slip_count = fields[8:11]
+        pairs = fields[11:11 + 2 * (run_count + length_count)]
+        runs = ", ".join(f"{pairs[i + 1]} x {pairs[i]}" for i in range(0, 2 * run_count, 2)) + (", ..." if truncated else "")
+        lengths = ", ".join(f"{pairs[i]}: {pairs[i + 1]}" for i in range(2 * run_count, len(pairs), 2))
+        lengths += f", other: {other}" if other else ""
+        slip_samples = fields[11 + 2 * (run_count + length_count):]
+        detail = f", slips at {', '.join(str(sample) for sample in slip_samples)}" if slip_samples else ""
+        print(f"Frame length @ {last_sample / SAMPLE_RATE:.6f} s: {nominal} bits, {slips} slips ({total_slips} total) over {frames} frames, "
+              f"runs: {runs}, lengths: {lengths}{detail}")
+    elif record_type == RECORD_SAMPLE_RATE:
+        sample, segment = fields[0:2]
+        previous, rate, nominal = struct.unpack('<3d', struct.pack('<3Q', *fields[2:5]))
+        detail = f" ({rate / nominal * 1e6 - 1e6:+.0f} ppm from {nominal:.0f} Hz)" if nominal else ""
+        print(f"Sample rate segment {segment} @ {sample / SAMPLE_RATE:.6f} s: {rate:.3f} Hz{detail}"
+              + (f", was {previous:.3f} Hz" if previous else ""))
+    elif record_type == RECORD_RATE_SEGMENT:
+        segment, first_sample, last_sample, frames, off_rate, errors, clock_gaps = fields[0:7]
+        rate, nominal, ppm, min_rate, max_rate = struct.unpack('<5d', struct.pack('<5Q', *fields[7:12]))
+        detail = f" ({ppm:+.0f} ppm from {nominal:.0f} Hz)" if nominal else ""
+        print(f"Sample rate segment {segment} {first_sample / SAMPLE_RATE:.6f} - {last_sample / SAMPLE_RATE:.6f} s: {rate:.3f} Hz{detail}, "
+              f"{min_rate:.3f} - {max_rate:.3f} Hz, {frames} frames ({off_rate} off rate), {errors} errors, {clock_gaps} clock gaps")
+    else:
+        print(f"Unknown record type {record_type}: {fields}")
+
 def deserialize(data):
     if len(data) != 16:
         raise ValueError("Data must be exactly 16 bytes long.")
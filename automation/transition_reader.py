@@ -0,0 +1,221 @@
+"""Zero-copy reader for Logic 2 digital binary exports.
+
+A channel file is a header and then one little endian double per transition, so it is memory mapped and used in place:
+nothing is copied or expanded to per-sample data, and only the pages that are looked at get read. Channel files can sit in
+a directory, or in a zip archive; stored entries are mapped straight out of the archive, compressed ones are inflated in
+chunks to a temporary file first.
+
+The digital-N.bin entries of a .sal file start with the same magic but are Logic 2's internal, compressed encoding
+(type 100), not a transition list. They are rejected with a pointer to the export instead of being misread.
+"""
+
+import os
+import shutil
+from bisect import bisect_left, bisect_right
+import struct
+import tempfile
+import zipfile
+
+import numpy as np
+
+BINARY_EXPORT_MAGIC = b'<SALEAE>'
+BINARY_EXPORT_HEADER = struct.Struct('<8siiIddQ')
+BINARY_EXPORT_TYPE_DIGITAL = 0
+SAL_INTERNAL_TYPE = 100
+
+ZIP_LOCAL_HEADER = struct.Struct('<4s5H3I2H')
+INFLATE_CHUNK_BYTES = 1 << 20
+
+
+class DigitalChannel:
+    """One digital channel: the initial level and the transition times in seconds, mapped from the file.
+
+    The transition count in the header isn't trusted, a file that is still being appended to is read up to its last
+    complete transition. first_transition skips the ones before it, initial_state is then the level before that one.
+    """
+
+    def __init__(self, source, first_transition=0):
+        path, offset, length = source if isinstance(source, tuple) else (source, 0, None)
+        with open(path, 'rb') as f:
+            f.seek(offset)
+            header = f.read(BINARY_EXPORT_HEADER.size)
+            if length is None:
+                length = os.fstat(f.fileno()).st_size - offset
+        _, _, _, initial_state, begin_time, end_time, _ = check_header(header, path)
+
+        data_offset = offset + BINARY_EXPORT_HEADER.size
+        count = (length - BINARY_EXPORT_HEADER.size) // 8
+        first_transition = min(first_transition, count)
+        if count > first_transition:
+            self.times = np.memmap(path, dtype='<f8', mode='r', offset=data_offset + first_transition * 8,
+                                   shape=(count - first_transition,))
+        else:
+            self.times = np.empty(0, dtype='<f8')
+        self.source = source
+        self.path = path
+        self.first_transition = first_transition
+        self.initial_state = (int(initial_state) ^ first_transition) & 1
+        self.begin_time = begin_time
+        self.end_time = end_time
+
+    def search(self, times, side='left'):
+        """np.searchsorted() of a time, or of sorted times, in the mapping.
+
+        The transitions start 44 bytes into the file, so the mapping isn't aligned and numpy would copy all of it to
+        search it. Bisect to the slice the times fall in instead, and only copy that.
+        """
+        bisect = bisect_right if side == 'right' else bisect_left
+        if np.ndim(times) == 0:
+            return bisect(self.times, float(times))
+        times = np.asarray(times)
+        if len(times) == 0:
+            return np.zeros(0, dtype=np.intp)
+        low = bisect(self.times, float(times[0]))
+        high = bisect(self.times, float(times[-1]))
+        return low + np.searchsorted(np.ascontiguousarray(self.times[low:high]), times, side=side)
+
+    def levels_at(self, times):
+        """Level at each time, counting a transition at exactly that time, like AdvanceToAbsPosition()."""
+        transitions = self.search(times, side='right')
+        return (self.initial_state ^ (transitions & 1)).astype(np.uint8)
+
+    def edges(self, rising):
+        """Times of the rising (or falling) transitions, a view on the mapping."""
+        first = 0 if (self.initial_state == 0) == rising else 1
+        return self.times[first::2]
+
+    def edge_index(self, time, rising, side='left'):
+        """np.searchsorted() of a time, or of sorted times, in edges(rising)."""
+        first = 0 if (self.initial_state == 0) == rising else 1
+        return np.maximum(self.search(time, side) - first + 1, 0) // 2
+
+    def transitions_before(self, time):
+        """Absolute index of the first transition at or after time."""
+        return self.first_transition + self.search(time)
+
+    def transition(self, index):
+        """Time of transition index (absolute), or None if it isn't mapped."""
+        local = index - self.first_transition
+        return float(self.times[local]) if 0 <= local < len(self.times) else None
+
+    def iterate(self, time=-np.inf):
+        return EdgeIterator(self, time)
+
+
+def check_header(header, name):
+    if len(header) != BINARY_EXPORT_HEADER.size:
+        raise ValueError(f"{name}: file too short")
+    fields = BINARY_EXPORT_HEADER.unpack(header)
+    magic, data_type = fields[0], fields[2]
+    if magic == BINARY_EXPORT_MAGIC and data_type == SAL_INTERNAL_TYPE:
+        raise ValueError(f"{name}: Logic 2 internal capture data, export the capture with export_raw_data_binary() "
+                         "(or File > Export Raw Data, binary) and decode the export")
+    if magic != BINARY_EXPORT_MAGIC or data_type != BINARY_EXPORT_TYPE_DIGITAL:
+        raise ValueError(f"{name}: not a Logic 2 digital binary export")
+    return fields
+
+
+class EdgeIterator:
+    """Walks a channel's transitions like AnalyzerChannelData: the current level, a look at the next edge, and
+    advancing to an edge or a time. chunk() hands out the next transitions as a view for vectorised consumers."""
+
+    def __init__(self, channel, time=-np.inf):
+        self.channel = channel
+        self.index = channel.search(time, side='right')
+
+    @property
+    def level(self):
+        return self.channel.initial_state ^ (self.index & 1)
+
+    def more_edges(self):
+        return self.index < len(self.channel.times)
+
+    def next_edge(self):
+        """Time of the next transition, None at the end of the data."""
+        return float(self.channel.times[self.index]) if self.more_edges() else None
+
+    def advance_to_next_edge(self):
+        self.index += 1
+        return self.channel.times[self.index - 1]
+
+    def advance_to(self, time):
+        """Pass the transitions up to and including time, returns how many."""
+        passed = max(self.channel.search(time, side='right') - self.index, 0)
+        self.index += passed
+        return passed
+
+    def chunk(self, count):
+        """The next count transitions (fewer at the end), and advance past them."""
+        view = self.channel.times[self.index:self.index + count]
+        self.index += len(view)
+        return view
+
+
+def channel_file(directory, channel):
+    """Logic 2 exports name the files digital_N.bin, the entries inside .sal files are digital-N.bin."""
+    for name in (f'digital_{channel}.bin', f'digital-{channel}.bin'):
+        path = os.path.join(directory, name)
+        if os.path.exists(path):
+            return path
+    raise FileNotFoundError(f"no binary export of channel {channel} in {directory}")
+
+
+def zip_entry(archive, channel):
+    with zipfile.ZipFile(archive) as z:
+        names = {os.path.basename(info.filename): info for info in z.infolist()}
+    for name in (f'digital_{channel}.bin', f'digital-{channel}.bin'):
+        if name in names:
+            return names[name]
+    raise FileNotFoundError(f"no binary export of channel {channel} in {archive}")
+
+
+def channel_source(source, channel):
+    """What DigitalChannel() opens for a channel of a capture: a file, or (archive, offset, length) for a stored zip
+    entry.
+
+    Compressed entries have to be unpacked with unpack_source() first.
+    """
+    if os.path.isdir(source):
+        return channel_file(source, channel)
+    info = zip_entry(source, channel)
+    if info.compress_type != zipfile.ZIP_STORED:
+        raise ValueError(f"{source}: {info.filename} is compressed, unpack_source() it first")
+    with open(source, 'rb') as f:
+        f.seek(info.header_offset)
+        fields = ZIP_LOCAL_HEADER.unpack(f.read(ZIP_LOCAL_HEADER.size))
+    name_length, extra_length = fields[-2], fields[-1]
+    return source, info.header_offset + ZIP_LOCAL_HEADER.size + name_length + extra_length, info.file_size
+
+
+def source_bytes(source, channel):
+    """Size of a channel's transition data, as stored."""
+    if os.path.isdir(source):
+        return os.path.getsize(channel_file(source, channel))
+    return zip_entry(source, channel).file_size
+
+
+def unpack_source(source, channels):
+    """Make source mappable: compressed zip entries are inflated a chunk at a time into a temporary directory.
+
+    Returns the source to decode from and the temporary directory to delete afterwards, or None.
+    """
+    if os.path.isdir(source) or not zipfile.is_zipfile(source):
+        return source, None
+    infos = [zip_entry(source, channel) for channel in channels]
+    with zipfile.ZipFile(source) as z:
+        for info in infos:
+            with z.open(info) as entry:
+                check_header(entry.read(BINARY_EXPORT_HEADER.size), f"{source}: {info.filename}")
+    if all(info.compress_type == zipfile.ZIP_STORED for info in infos):
+        return source, None
+
+    directory = tempfile.mkdtemp(prefix='i2s-inflate-')
+    try:
+        with zipfile.ZipFile(source) as z:
+            for info in infos:
+                with z.open(info) as entry, open(os.path.join(directory, os.path.basename(info.filename)), 'wb') as out:
+                    shutil.copyfileobj(entry, out, INFLATE_CHUNK_BYTES)
+    except BaseException:
+        shutil.rmtree(directory, ignore_errors=True)
+        raise
+    return directory, directory
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+#include "Fft.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#define AUDIO_QUALITY_DC_BINS 6
+#define AUDIO_QUALITY_LOBE_BINS 5
+#define AUDIO_QUALITY_HARMONICS 10
+
+/**
+ * @brief Block based THD+N / SNR / frequency / DC measurement of decoded samples.
+ *
+ * Each channel collects a fixed size block of normalised samples. A full block is windowed (4 term Blackman-Harris) and run through
+ * an in-place radix-2 FFT, see Fft.
+ */
+class AudioQualityAnalysis
+{
+  public:
+    struct Result
+    {
+        U32 mChannel;
+        U64 mFirstSample;
+        U64 mLastSample;
+        double mFrequencyHz;
+        double mThdNDb;
+        double mSnrDb;
+        double mDcOffset; // fraction of full scale
+    };
+
+    AudioQualityAnalysis() : mBlockSize( 0 ), mSampleRateHz( 0 )
+    {
+    }
+
+    /**
+     * @param blockSize power of two, 0 disables the analysis
+     */
+    void setup( U32 channelCount, U32 blockSize, U64 sampleRateHz )
+    {
+        mBlockSize = blockSize;
+        mSampleRateHz = sampleRateHz;
+        mChannels.assign( channelCount, ChannelBlock() );
+
+        if( mBlockSize == 0 )
+        {
+            return;
+        }
+
+        for( U32 i = 0; i < channelCount; i++ )
+        {
+            mChannels[ i ].mSamples.reserve( mBlockSize );
+        }
+
+        const double pi = 3.14159265358979323846;
+
+        mWindow.resize( mBlockSize );
+        for( U32 i = 0; i < mBlockSize; i++ )
+        {
+            double x = 2.0 * pi * double( i ) / double( mBlockSize );
+            mWindow[ i ] = 0.35875 - 0.48829 * cos( x ) + 0.14128 * cos( 2.0 * x ) - 0.01168 * cos( 3.0 * x );
+        }
+
+        mFft.setup( mBlockSize );
+        mPower.resize( mBlockSize / 2 + 1 );
+    }
+
+    bool enabled() const
+    {
+        return mBlockSize != 0;
+    }
+
+    /**
+     * @brief Add one sample, normalised to -1.0 .. 1.0.
+     *
+     * @return true if this sample completed a block, with the block's measurements in result
+     */
+    bool push( U32 channel, double value, U64 sampleNumber, Result& result )
+    {
+        ChannelBlock& block = mChannels.at( channel );
+        if( block.mSamples.empty() )
+        {
+            block.mFirstSample = sampleNumber;
+        }
+        block.mSamples.push_back( value );
+
+        if( block.mSamples.size() < mBlockSize )
+        {
+            return false;
+        }
+
+        result.mChannel = channel;
+        result.mFirstSample = block.mFirstSample;
+        result.mLastSample = sampleNumber;
+        analyse( block, result );
+
+        block.mSamples.clear();
+        return true;
+    }
+
+  protected:
+    struct ChannelBlock
+    {
+        std::vector<double> mSamples;
+        U64 mFirstSample;
+    };
+
+    void analyse( const ChannelBlock& block, Result& result )
+    {
+        double sum = 0.0;
+        for( U32 i = 0; i < mBlockSize; i++ )
+        {
+            sum += block.mSamples[ i ];
+        }
+        double mean = sum / double( mBlockSize );
+        result.mDcOffset = mean;
+
+        // Remove DC before windowing, so a large offset can't leak into the low bins.
+        for( U32 i = 0; i < mBlockSize; i++ )
+        {
+            mFft.set( i, ( block.mSamples[ i ] - mean ) * mWindow[ i ] );
+        }
+
+        mFft.transform();
+
+        U32 half = mBlockSize / 2;
+        for( U32 i = 0; i <= half; i++ )
+        {
+            mPower[ i ] = mFft.power( i );
+        }
+
+        U32 peak = AUDIO_QUALITY_DC_BINS;
+        double total = 0.0;
+        for( U32 i = AUDIO_QUALITY_DC_BINS; i <= half; i++ )
+        {
+            total += mPower[ i ];
+            if( mPower[ i ] > mPower[ peak ] )
+            {
+                peak = i;
+            }
+        }
+
+        // Parabolic interpolation on the log magnitude gives a sub-bin estimate of the fundamental.
+        double offset = 0.0;
+        if( peak > 0 && peak < half && mPower[ peak ] > 0.0 )
+        {
+            double a = log( mPower[ peak - 1 ] + 1e-300 );
+            double b = log( mPower[ peak ] );
+            double c = log( mPower[ peak + 1 ] + 1e-300 );
+            double denominator = a - 2.0 * b + c;
+            if( denominator != 0.0 )
+            {
+                offset = 0.5 * ( a - c ) / denominator;
+            }
+        }
+        double peakBin = double( peak ) + offset;
+
+        // Audio sample rate from the sample numbers of the first and last word of the block.
+        double spanSamples = double( result.mLastSample - block.mFirstSample );
+        double audioRateHz = spanSamples > 0.0 ? double( mSampleRateHz ) * double( mBlockSize - 1 ) / spanSamples : 0.0;
+        result.mFrequencyHz = peakBin * audioRateHz / double( mBlockSize );
+
+        double fundamental = lobePower( peak );
+        double harmonics = 0.0;
+        for( U32 h = 2; h <= AUDIO_QUALITY_HARMONICS; h++ )
+        {
+            U32 bin = U32( peakBin * double( h ) + 0.5 );
+            if( bin + AUDIO_QUALITY_LOBE_BINS > half )
+            {
+                break;
+            }
+            harmonics += lobePower( bin );
+        }
+
+        double noiseAndDistortion = std::max( total - fundamental, 1e-300 );
+        double noise = std::max( noiseAndDistortion - harmonics, 1e-300 );
+        fundamental = std::max( fundamental, 1e-300 );
+
+        result.mThdNDb = 10.0 * log10( noiseAndDistortion / fundamental );
+        result.mSnrDb = 10.0 * log10( fundamental / noise );
+    }
+
+    double lobePower( U32 centre ) const
+    {
+        U32 half = mBlockSize / 2;
+        U32 first = centre > AUDIO_QUALITY_LOBE_BINS ? centre - AUDIO_QUALITY_LOBE_BINS : 0;
+        first = std::max<U32>( first, AUDIO_QUALITY_DC_BINS );
+        U32 last = std::min<U32>( centre + AUDIO_QUALITY_LOBE_BINS, half );
+
+        double power = 0.0;
+        for( U32 i = first; i <= last; i++ )
+        {
+            power += mPower[ i ];
+        }
+        return power;
+    }
+
+    U32 mBlockSize;
+    U64 mSampleRateHz;
+    std::vector<ChannelBlock> mChannels;
+
+    std::vector<double> mWindow;
+    Fft mFft;
+    std::vector<double> mPower;
+};
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#define BIT_FAULT_MAP_MAX_BITS 64
+#define BIT_FAULT_MAP_MAX_SLIP 2
+#define BIT_FAULT_MAP_STUCK_THRESHOLD 4
+
+/**
+ * @brief Per-channel, per-bit-position record of test mismatches.
+ *
+ * Every failed sample is folded in as expected XOR received, so a stuck data bit, swapped lines or a word that
+ * slipped by a bit or two can be told apart without exporting the decoded values.
+ */
+class BitFaultMap
+{
+  public:
+    struct ChannelFaults
+    {
+        U64 mErrorCount;
+        U64 mMismatchMask;
+        U64 mBitErrors[ BIT_FAULT_MAP_MAX_BITS ];
+        U64 mBitErrorsReceivedHigh[ BIT_FAULT_MAP_MAX_BITS ];
+        // Index 0..1 are left shifts by 1..2 bits, 2..3 are right shifts by 1..2 bits.
+        U64 mSlipCounts[ BIT_FAULT_MAP_MAX_SLIP * 2 ];
+    };
+
+    BitFaultMap() : mBitsPerWord( 16 ), mWordMask( 0xFFFF )
+    {
+    }
+
+    void setup( U32 channelCount, U32 bitsPerWord )
+    {
+        mBitsPerWord = std::min<U32>( bitsPerWord, BIT_FAULT_MAP_MAX_BITS );
+        mWordMask = ( mBitsPerWord >= 64 ) ? ~0ULL : ( ( 1ULL << mBitsPerWord ) - 1 );
+
+        ChannelFaults empty = {};
+        mChannels.assign( channelCount, empty );
+        mLastDiagnosis.assign( channelCount, std::string() );
+    }
+
+    /**
+     * @brief Fold a failed sample into the map.
+     *
+     * @return the detected bit slip: +1..+2 if the received word is the expected word shifted left, -1..-2 if shifted right, 0 if none.
+     */
+    int record( U32 channel, U64 expected, U64 received )
+    {
+        ChannelFaults& faults = mChannels.at( channel );
+
+        expected &= mWordMask;
+        received &= mWordMask;
+        U64 diff = expected ^ received;
+        U64 diffHigh = diff & received;
+
+        faults.mErrorCount++;
+        faults.mMismatchMask |= diff;
+
+        // Fixed trip count and no branches, so the compiler can vectorise the whole update.
+        for( U32 bit = 0; bit < BIT_FAULT_MAP_MAX_BITS; bit++ )
+        {
+            faults.mBitErrors[ bit ] += ( diff >> bit ) & 1;
+            faults.mBitErrorsReceivedHigh[ bit ] += ( diffHigh >> bit ) & 1;
+        }
+
+        int slip = detectSlip( expected, received );
+        if( slip > 0 )
+        {
+            faults.mSlipCounts[ slip - 1 ]++;
+        }
+        else if( slip < 0 )
+        {
+            faults.mSlipCounts[ BIT_FAULT_MAP_MAX_SLIP - slip - 1 ]++;
+        }
+
+        return slip;
+    }
+
+    /**
+     * @brief Compare the received word against the expected word shifted by 1..2 bits.
+     *        The bits shifted in from the neighbouring word are unknown, so they are masked out of the comparison.
+     *        A shift that leaves the compared bits of the expected word unchanged, as with 0 or all ones, can't be told apart
+     *        from a stuck end bit, so it isn't reported as a slip.
+     */
+    int detectSlip( U64 expected, U64 received ) const
+    {
+        if( expected == received )
+        {
+            return 0;
+        }
+
+        for( int shift = 1; shift <= BIT_FAULT_MAP_MAX_SLIP; shift++ )
+        {
+            U64 leftMask = mWordMask & ~( ( 1ULL << shift ) - 1 );
+            U64 rightMask = mWordMask >> shift;
+
+            if( ( ( ( expected << shift ) ^ expected ) & leftMask ) != 0 && ( ( received ^ ( expected << shift ) ) & leftMask ) == 0 )
+            {
+                return shift;
+            }
+
+            if( ( ( ( expected >> shift ) ^ expected ) & rightMask ) != 0 && ( ( received ^ ( expected >> shift ) ) & rightMask ) == 0 )
+            {
+                return -shift;
+            }
+        }
+
+        return 0;
+    }
+
+    /**
+     * @brief Bits that only ever mismatched in one direction, with enough errors to call them stuck.
+     */
+    U64 stuckHighMask( U32 channel ) const
+    {
+        const ChannelFaults& faults = mChannels.at( channel );
+        U64 mask = 0;
+        for( U32 bit = 0; bit < mBitsPerWord; bit++ )
+        {
+            if( faults.mBitErrors[ bit ] >= BIT_FAULT_MAP_STUCK_THRESHOLD && faults.mBitErrorsReceivedHigh[ bit ] == faults.mBitErrors[ bit ] )
+            {
+                mask |= 1ULL << bit;
+            }
+        }
+        return mask;
+    }
+
+    U64 stuckLowMask( U32 channel ) const
+    {
+        const ChannelFaults& faults = mChannels.at( channel );
+        U64 mask = 0;
+        for( U32 bit = 0; bit < mBitsPerWord; bit++ )
+        {
+            if( faults.mBitErrors[ bit ] >= BIT_FAULT_MAP_STUCK_THRESHOLD && faults.mBitErrorsReceivedHigh[ bit ] == 0 )
+            {
+                mask |= 1ULL << bit;
+            }
+        }
+        return mask;
+    }
+
+    /**
+     * @brief Short human readable classification of the faults seen so far on a channel.
+     */
+    std::string diagnosis( U32 channel ) const
+    {
+        const ChannelFaults& faults = mChannels.at( channel );
+        if( faults.mErrorCount == 0 )
+        {
+            return "none";
+        }
+
+        // A slip explains the error if it accounts for the majority of them.
+        for( int i = 0; i < BIT_FAULT_MAP_MAX_SLIP * 2; i++ )
+        {
+            if( faults.mSlipCounts[ i ] * 2 > faults.mErrorCount )
+            {
+                char str[ 64 ];
+                snprintf( str, sizeof( str ), "bit slip %s %d", i < BIT_FAULT_MAP_MAX_SLIP ? "left" : "right", ( i % BIT_FAULT_MAP_MAX_SLIP ) + 1 );
+                return str;
+            }
+        }
+
+        // Carries in the expected value can drag neighbouring bits into the map, so any stuck bit wins.
+        if( ( stuckHighMask( channel ) | stuckLowMask( channel ) ) != 0 )
+        {
+            return "stuck bits";
+        }
+
+        return "random";
+    }
+
+    /**
+     * @brief Per-bit mismatch counts, e.g. "b0:12 b7:3". Only bits with errors are listed.
+     */
+    std::string bitErrorString( U32 channel ) const
+    {
+        const ChannelFaults& faults = mChannels.at( channel );
+        std::string result;
+        char str[ 32 ];
+        for( U32 bit = 0; bit < mBitsPerWord; bit++ )
+        {
+            if( faults.mBitErrors[ bit ] != 0 )
+            {
+                snprintf( str, sizeof( str ), "%sb%u:%llu", result.empty() ? "" : " ", bit, ( unsigned long long )faults.mBitErrors[ bit ] );
+                result += str;
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Returns true once each time the diagnosis or the set of failing bits of a channel changes,
+     *        so summaries are only emitted when there is something new to say.
+     */
+    bool takeChanged( U32 channel )
+    {
+        const ChannelFaults& faults = mChannels.at( channel );
+        char mask[ 24 ];
+        snprintf( mask, sizeof( mask ), "%llx:", ( unsigned long long )faults.mMismatchMask );
+        std::string current = std::string( mask ) + diagnosis( channel );
+
+        if( current == mLastDiagnosis.at( channel ) )
+        {
+            return false;
+        }
+        mLastDiagnosis.at( channel ) = current;
+        return true;
+    }
+
+    const ChannelFaults& faults( U32 channel ) const
+    {
+        return mChannels.at( channel );
+    }
+
+    U32 channelCount() const
+    {
+        return mChannels.size();
+    }
+
+    U32 bitsPerWord() const
+    {
+        return mBitsPerWord;
+    }
+
+  protected:
+    U32 mBitsPerWord;
+    U64 mWordMask;
+    std::vector<ChannelFaults> mChannels;
+    std::vector<std::string> mLastDiagnosis;
+};
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#define CLOCK_PULSE_REPORT_PULSES 524288 // CLOCK pulses between duty cycle reports, 262144 bits
+
+/**
+ * @brief Measures every CLOCK high and low pulse as the decode walks the edges: glitches, and the duty cycle.
+ *
+ * A pulse shorter than a fraction of the nominal bit period is a glitch. A runt pulse splits a pulse into three short ones, so
+ * the short pulses in a row make one glitch, from the start of the first to the end of the last. The pulses that aren't glitches
+ * go into the width statistics of their level, and each high pulse with the low pulse next to it into the duty cycle.
+ */
+class ClockPulseMonitor
+{
+  public:
+    struct Glitch
+    {
+        U64 mStartSample; // first edge of the first short pulse
+        U64 mEndSample;   // last edge of the last one
+        U32 mPulses;      // short pulses in a row
+        U64 mShortest;    // samples
+        bool mShortestHigh;
+    };
+
+    struct PulseStatistics
+    {
+        U64 mCount;
+        double mMean; // samples
+        U64 mMin;
+        U64 mMax;
+    };
+
+    struct Report
+    {
+        U64 mFirstSample;
+        U64 mLastSample;
+        U64 mGlitches;
+        U64 mGlitchPulses;
+        PulseStatistics mHigh;
+        PulseStatistics mLow;
+        double mDutyCycle; // of the mean widths, negative without both levels
+        double mDutyMin;   // of single clock periods
+        double mDutyMax;
+    };
+
+    ClockPulseMonitor() : mThreshold( 0.0 )
+    {
+        mHaveEdge = false;
+        mGlitch.mPulses = 0;
+        startReport( 0 );
+    }
+
+    /**
+     * @param threshold fraction of the bit period a pulse has to be shorter than to be a glitch, 0 disables the monitor
+     */
+    void setup( double threshold )
+    {
+        mThreshold = threshold;
+        mHaveEdge = false;
+        mLastPulse = 0;
+        mGlitch.mPulses = 0;
+        startReport( 0 );
+    }
+
+    bool enabled() const
+    {
+        return mThreshold > 0.0;
+    }
+
+    /**
+     * @brief The clock stopped: the next edge starts a pulse. A glitch in progress ends at the last edge. The report period carries
+     *        on.
+     */
+    void restart( std::vector<Glitch>& glitches )
+    {
+        endGlitch( glitches );
+        mHaveEdge = false;
+        mLastPulse = 0;
+    }
+
+    /**
+     * @brief A CLOCK edge, it ends the pulse since the last one.
+     *
+     * @param rising the pulse was low
+     * @param bitPeriod nominal, in samples, 0 while it isn't known
+     * @param glitches a glitch is added once a pulse is long enough again
+     * @return true when a report period ended, with the report in report
+     */
+    bool edge( U64 sample, bool rising, double bitPeriod, std::vector<Glitch>& glitches, Report& report )
+    {
+        if( mThreshold <= 0.0 )
+            return false;
+        if( !mHaveEdge )
+        {
+            mHaveEdge = true;
+            mLastEdge = sample;
+            if( mReportStart == 0 )
+                mReportStart = sample;
+            return false;
+        }
+
+        U64 width = sample - mLastEdge;
+        U64 start = mLastEdge;
+        mLastEdge = sample;
+        bool high = !rising;
+        if( bitPeriod > 0.0 && double( width ) < bitPeriod * mThreshold )
+        {
+            if( mGlitch.mPulses == 0 )
+            {
+                mGlitch.mStartSample = start;
+                mGlitch.mShortest = width;
+                mGlitch.mShortestHigh = high;
+            }
+            else if( width < mGlitch.mShortest )
+            {
+                mGlitch.mShortest = width;
+                mGlitch.mShortestHigh = high;
+            }
+            mGlitch.mEndSample = sample;
+            mGlitch.mPulses++;
+            mGlitchPulses++;
+            mLastPulse = 0;
+            return reportDue( sample, report );
+        }
+
+        endGlitch( glitches );
+        addPulse( high ? mHigh : mLow, width );
+
+        // the duty cycle of the clock period made of this pulse and the one before it, of the other level.
+        if( mLastPulse != 0 )
+        {
+            double high_width = double( high ? width : mLastPulse );
+            double duty = high_width / double( width + mLastPulse );
+            mDutyMin = mDutyCount == 0 ? duty : std::min( mDutyMin, duty );
+            mDutyMax = mDutyCount == 0 ? duty : std::max( mDutyMax, duty );
+            mDutyCount++;
+        }
+        mLastPulse = width;
+        return reportDue( sample, report );
+    }
+
+    /**
+     * @brief The last edge ended a glitch pulse.
+     */
+    bool inGlitch() const
+    {
+        return mGlitch.mPulses != 0;
+    }
+
+    /**
+     * @brief Report the period so far, e.g. when the data ran out. The period carries on, it is reported again, from its start,
+     *        when it ends.
+     *
+     * @return false if no pulse was measured since the period was last reported
+     */
+    bool flush( U64 sampleNumber, Report& report )
+    {
+        U64 pulses = mHigh.mCount + mLow.mCount + mGlitchPulses;
+        if( mThreshold <= 0.0 || pulses == mReportedPulses )
+            return false;
+        makeReport( sampleNumber, report );
+        mReportedPulses = pulses;
+        return true;
+    }
+
+  protected:
+    struct Pulses
+    {
+        U64 mCount;
+        U64 mSum;
+        U64 mMin;
+        U64 mMax;
+    };
+
+    bool reportDue( U64 sampleNumber, Report& report )
+    {
+        if( mHigh.mCount + mLow.mCount + mGlitchPulses < CLOCK_PULSE_REPORT_PULSES )
+            return false;
+        makeReport( sampleNumber, report );
+        startReport( sampleNumber );
+        return true;
+    }
+
+    void endGlitch( std::vector<Glitch>& glitches )
+    {
+        if( mGlitch.mPulses == 0 )
+            return;
+        glitches.push_back( mGlitch );
+        mGlitches++;
+        mGlitch.mPulses = 0;
+    }
+
+    static void addPulse( Pulses& pulses, U64 width )
+    {
+        pulses.mMin = pulses.mCount == 0 ? width : std::min( pulses.mMin, width );
+        pulses.mMax = pulses.mCount == 0 ? width : std::max( pulses.mMax, width );
+        pulses.mSum += width;
+        pulses.mCount++;
+    }
+
+    static PulseStatistics pulseStatistics( const Pulses& pulses )
+    {
+        PulseStatistics statistics = { pulses.mCount, 0.0, pulses.mMin, pulses.mMax };
+        if( pulses.mCount != 0 )
+            statistics.mMean = double( pulses.mSum ) / double( pulses.mCount );
+        return statistics;
+    }
+
+    void startReport( U64 sampleNumber )
+    {
+        mReportStart = sampleNumber;
+        mReportedPulses = 0;
+        mGlitches = 0;
+        mGlitchPulses = 0;
+        mHigh = Pulses();
+        mLow = Pulses();
+        mDutyCount = 0;
+        mDutyMin = 0.0;
+        mDutyMax = 0.0;
+    }
+
+    void makeReport( U64 sampleNumber, Report& report )
+    {
+        report.mFirstSample = mReportStart;
+        report.mLastSample = sampleNumber;
+        report.mGlitches = mGlitches;
+        report.mGlitchPulses = mGlitchPulses;
+        report.mHigh = pulseStatistics( mHigh );
+        report.mLow = pulseStatistics( mLow );
+        report.mDutyCycle = -1.0;
+        if( mHigh.mCount != 0 && mLow.mCount != 0 )
+            report.mDutyCycle = report.mHigh.mMean / ( report.mHigh.mMean + report.mLow.mMean );
+        report.mDutyMin = mDutyMin;
+        report.mDutyMax = mDutyMax;
+    }
+
+    double mThreshold;
+
+    bool mHaveEdge;
+    U64 mLastEdge;
+    U64 mLastPulse; // width of the last pulse that wasn't a glitch, 0 when the one before this isn't usable
+    Glitch mGlitch; // in progress while mPulses != 0
+
+    U64 mReportStart;
+    U64 mReportedPulses; // pulses when the period was last flushed
+    U64 mGlitches;       // ended in the report period
+    U64 mGlitchPulses;
+    Pulses mHigh;
+    Pulses mLow;
+    U64 mDutyCount;
+    double mDutyMin;
+    double mDutyMax;
+};
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+
+#include <math.h>
+#include <algorithm>
+
+#define CLOCK_RECOVERY_PHASE_GAIN 0.125          // fraction of an edge's phase error the recovered phase moves by
+#define CLOCK_RECOVERY_PERIOD_GAIN ( 1.0 / 512 ) // fraction of an edge's phase error integrated into the bit period
+#define CLOCK_RECOVERY_FRAME_GAIN 0.25           // fraction of the difference to a measured FRAME period taken into the bit period
+#define CLOCK_RECOVERY_LOCK_FRAMES 4             // FRAME periods in a row with the expected bit count to lock
+#define CLOCK_RECOVERY_REPORT_FRAMES 4096        // FRAME periods between reports
+#define CLOCK_RECOVERY_MIN_BIT_PERIOD 2.0        // samples, shorter bits can't be sampled at their centre
+
+/**
+ * @brief Recovers the bit clock from the DATA and FRAME edges, for probe points that have no CLOCK.
+ *
+ * A FRAME period divided by the bits in it gives the bit period to start from, and a FRAME rising edge gives the phase. From there a
+ * second order loop tracks the clock. Every DATA and FRAME edge is on a bit boundary, and its distance from the recovered
+ * boundary is the phase error. The phase error pulls the phase in and is integrated into the period. Each FRAME period also
+ * corrects the period directly, so the loop mostly follows the phase. DATA is read at the centre between two boundaries.
+ *
+ * The caller walks the edges, and the work is a few multiplications per edge and per bit. The phase is kept as a fraction of a
+ * sample past a whole sample number, so it keeps its precision over hours of capture.
+ *
+ * The clock is locked after CLOCK_RECOVERY_LOCK_FRAMES FRAME periods in a row that hold the expected number of bits. A FRAME
+ * period with more or fewer bits is a slip: it loses lock, and the clock is taken from that FRAME period again. Jitter is the time
+ * interval error of the edges against the recovered clock.
+ */
+class ClockRecovery
+{
+  public:
+    struct Report
+    {
+        bool mLocked;
+        bool mLockChanged;        // reported because lock was gained or lost, rather than at the end of a report period
+        U64 mFirstSample;         // of the report period
+        U64 mLastSample;
+        U64 mFrames;              // FRAME periods in the report period
+        U64 mBadFrames;           // FRAME periods that didn't hold the expected number of bits
+        U64 mEdges;               // DATA and FRAME edges measured
+        double mBitPeriod;        // samples
+        double mJitterRms;        // samples, about the mean
+        double mJitterPeakToPeak; // samples
+    };
+
+    ClockRecovery() : mBitsPerFrame( 1 )
+    {
+        reset();
+    }
+
+    /**
+     * @param bitsPerFrame bit clocks in a FRAME period, from one FRAME rising edge to the next
+     */
+    void setup( U32 bitsPerFrame )
+    {
+        mBitsPerFrame = std::max<U32>( bitsPerFrame, 1 );
+        reset();
+    }
+
+    /**
+     * @brief The clock stopped: forget it, and acquire it again from the next two FRAME rising edges.
+     *
+     * @return true if it was locked, with the lock loss in report
+     */
+    bool stop( U64 sampleNumber, Report& report )
+    {
+        bool was_locked = mAcquired && mLocked;
+        if( was_locked )
+        {
+            mLocked = false;
+            makeReport( sampleNumber, true, report );
+        }
+        reset();
+        return was_locked;
+    }
+
+    bool acquired() const
+    {
+        return mAcquired;
+    }
+
+    bool locked() const
+    {
+        return mLocked;
+    }
+
+    double bitPeriod() const
+    {
+        return mPeriod;
+    }
+
+    U32 bitsPerFrame() const
+    {
+        return mBitsPerFrame;
+    }
+
+    /**
+     * @brief Sample DATA and FRAME are read at for the current bit, the edges up to it have to be fed in first.
+     */
+    U64 centre() const
+    {
+        return mOrigin + U64( mPhase + mPeriod / 2.0 );
+    }
+
+    /**
+     * @brief Move on to the next bit, once the current one was read.
+     */
+    void nextBit()
+    {
+        mPhase += mPeriod;
+        double whole = floor( mPhase );
+        mOrigin += U64( whole );
+        mPhase -= whole;
+        mBits++;
+    }
+
+    /**
+     * @brief A DATA edge, or a FRAME falling edge, up to the centre() of the current bit.
+     */
+    void edge( U64 sampleNumber )
+    {
+        if( mAcquired )
+            track( phaseError( sampleNumber ) );
+    }
+
+    /**
+     * @brief A FRAME rising edge, it starts a FRAME period. Before the clock is acquired, any FRAME rising edge.
+     *
+     * @return true when lock was gained or lost, or a report period ended, with the report in report
+     */
+    bool frameStart( U64 sampleNumber, Report& report )
+    {
+        if( !mHaveFrameStart )
+        {
+            mFrameStart = sampleNumber;
+            mHaveFrameStart = true;
+            return false;
+        }
+
+        double measured = double( sampleNumber - mFrameStart ) / double( mBitsPerFrame );
+        mFrameStart = sampleNumber;
+        if( !mAcquired )
+        {
+            if( measured < CLOCK_RECOVERY_MIN_BIT_PERIOD )
+                return false;
+            mAcquired = true;
+            mPeriod = measured;
+            restartAt( sampleNumber );
+            startReport( sampleNumber );
+            return false;
+        }
+
+        mFrames++;
+        double error = phaseError( sampleNumber );
+        bool lock_changed = false;
+        if( mBits == mBitsPerFrame )
+        {
+            track( error );
+            mPeriod += ( measured - mPeriod ) * CLOCK_RECOVERY_FRAME_GAIN;
+            mGoodFrames++;
+            lock_changed = !mLocked && mGoodFrames >= CLOCK_RECOVERY_LOCK_FRAMES;
+            mLocked = mLocked || lock_changed;
+        }
+        else
+        {
+            // a bit slipped, or the clock changed: start again from this FRAME period.
+            mBadFrames++;
+            mGoodFrames = 0;
+            lock_changed = mLocked;
+            mLocked = false;
+            if( measured >= CLOCK_RECOVERY_MIN_BIT_PERIOD )
+                mPeriod = measured;
+            restartAt( sampleNumber );
+        }
+        mBits = 0;
+
+        if( !lock_changed && mFrames < CLOCK_RECOVERY_REPORT_FRAMES )
+            return false;
+        makeReport( sampleNumber, lock_changed, report );
+        return true;
+    }
+
+  protected:
+    void reset()
+    {
+        mAcquired = false;
+        mHaveFrameStart = false;
+        mFrameStart = 0;
+        mOrigin = 0;
+        mPhase = 0.0;
+        mPeriod = 0.0;
+        mBits = 0;
+        mLocked = false;
+        mGoodFrames = 0;
+        startReport( 0 );
+    }
+
+    /**
+     * @brief Distance of an edge from the boundary at the start of the current bit, negative when it is early.
+     */
+    double phaseError( U64 sampleNumber ) const
+    {
+        return double( S64( sampleNumber - mOrigin ) ) - mPhase;
+    }
+
+    void track( double error )
+    {
+        // the time interval error against the recovered clock, before the loop corrects for it.
+        mErrorMin = mEdges == 0 ? error : std::min( mErrorMin, error );
+        mErrorMax = mEdges == 0 ? error : std::max( mErrorMax, error );
+        mErrorSum += error;
+        mErrorSquares += error * error;
+        mEdges++;
+
+        mPhase += error * CLOCK_RECOVERY_PHASE_GAIN;
+        mPeriod += error * CLOCK_RECOVERY_PERIOD_GAIN;
+    }
+
+    void restartAt( U64 sampleNumber )
+    {
+        mOrigin = sampleNumber;
+        mPhase = 0.0;
+        mBits = 0;
+    }
+
+    void startReport( U64 sampleNumber )
+    {
+        mReportStart = sampleNumber;
+        mFrames = 0;
+        mBadFrames = 0;
+        mEdges = 0;
+        mErrorSum = 0.0;
+        mErrorSquares = 0.0;
+        mErrorMin = 0.0;
+        mErrorMax = 0.0;
+    }
+
+    void makeReport( U64 sampleNumber, bool lockChanged, Report& report )
+    {
+        double mean = mEdges != 0 ? mErrorSum / double( mEdges ) : 0.0;
+        double variance = mEdges != 0 ? mErrorSquares / double( mEdges ) - mean * mean : 0.0;
+
+        report.mLocked = mLocked;
+        report.mLockChanged = lockChanged;
+        report.mFirstSample = mReportStart;
+        report.mLastSample = sampleNumber;
+        report.mFrames = mFrames;
+        report.mBadFrames = mBadFrames;
+        report.mEdges = mEdges;
+        report.mBitPeriod = mPeriod;
+        report.mJitterRms = sqrt( std::max( variance, 0.0 ) );
+        report.mJitterPeakToPeak = mErrorMax - mErrorMin;
+        startReport( sampleNumber );
+    }
+
+    U32 mBitsPerFrame;
+
+    bool mAcquired;
+    bool mHaveFrameStart;
+    U64 mFrameStart; // sample of the last FRAME rising edge
+    U64 mOrigin;     // whole sample of the boundary at the start of the current bit
+    double mPhase;   // the boundary is this many samples past mOrigin
+    double mPeriod;  // samples per bit
+    U32 mBits;       // bits since the last FRAME rising edge
+
+    bool mLocked;
+    U32 mGoodFrames;
+
+    U64 mReportStart;
+    U64 mFrames;
+    U64 mBadFrames;
+    U64 mEdges;
+    double mErrorSum;
+    double mErrorSquares;
+    double mErrorMin;
+    double mErrorMax;
+};
@@ -0,0 +1,322 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#define CLOCK_TREE_PHASE_TOLERANCE 0.25 // periods a FRAME edge may move against BCLK or MCLK before it is a phase slip
+#define CLOCK_TREE_MIN_PERIOD 4.0       // samples, a shorter clock period can't resolve the phase
+#define CLOCK_TREE_REPORT_FRAMES 4096   // FRAME periods between stability reports
+
+/**
+ * @brief Watches the clock tree at each FRAME rising edge: the MCLK periods and bit clocks in each FRAME period, and the phase of
+ *        the FRAME edge against MCLK and the bit clock.
+ *
+ * The counts are of whole clock periods from one FRAME edge to the next. The clock edges are counted one by one, from the
+ * first one after a FRAME edge to the first one after the next, and the phases at both ends correct the count to the FRAME
+ * edges. A FRAME edge right on a clock edge can fall either side of it from one FRAME period to the next; that moves a period
+ * between the edge count and the phase, and the count stays the same. A count is established once two FRAME periods in a row
+ * agree, and a ratio change is reported when a FRAME period doesn't match it.
+ *
+ * The phase is the time from the FRAME edge to the next MCLK rising edge, and to the next data valid bit clock edge, in periods
+ * of that clock. It is measured against the phase of the first FRAME period, with wrap around, and moving more than
+ * CLOCK_TREE_PHASE_TOLERANCE from it is a phase slip. The phase after a slip is the new reference.
+ */
+class ClockTreeMonitor
+{
+  public:
+    enum Kind
+    {
+        KIND_MCLK_RATIO, // MCLK periods per FRAME period
+        KIND_BCLK_RATIO, // bit clocks per FRAME period
+        KIND_MCLK_PHASE,
+        KIND_BCLK_PHASE
+    };
+
+    struct Event
+    {
+        Kind mKind;
+        U64 mSample;      // FRAME edge that ends the FRAME period the change was seen in
+        double mPrevious; // count, or phase in periods
+        double mCurrent;
+    };
+
+    struct PhaseStatistics
+    {
+        double mMean;       // periods, negative when it wasn't measured
+        double mRms;        // periods, about the mean
+        double mPeakToPeak; // periods
+    };
+
+    struct Report
+    {
+        U64 mFirstSample;
+        U64 mLastSample;
+        U64 mFrames;       // FRAME periods measured
+        U64 mMclkPerFrame; // established counts, 0 while there is none
+        U64 mBclkPerFrame;
+        U64 mRatioChanges;
+        U64 mPhaseSlips;
+        PhaseStatistics mMclkPhase;
+        PhaseStatistics mBclkPhase;
+    };
+
+    ClockTreeMonitor() : mEnabled( false )
+    {
+        restart();
+        startReport( 0 );
+    }
+
+    void setup( bool enabled )
+    {
+        mEnabled = enabled;
+        restart();
+        startReport( 0 );
+    }
+
+    bool enabled() const
+    {
+        return mEnabled;
+    }
+
+    /**
+     * @brief The clocks stopped: forget the established counts and phases. The report period carries on.
+     */
+    void restart()
+    {
+        mHaveEdge = false;
+        mMclkRatio = Ratio();
+        mBclkRatio = Ratio();
+        mMclkPhase.mKnown = false;
+        mBclkPhase.mKnown = false;
+    }
+
+    /**
+     * @brief A FRAME rising edge.
+     *
+     * @param bclkEdge the first data valid bit clock edge after it, 0 when the bit clock is recovered
+     * @param mclkEdge the first MCLK rising edge after it, 0 when MCLK has none
+     * @param mclkTransitions MCLK transitions walked up to just before mclkEdge, an even number of them between mclkEdges
+     * @param bits bit clocks since the last FRAME rising edge
+     * @return true when a report period ended, with the report in report
+     */
+    bool frameEdge( U64 sample, U64 bclkEdge, U64 mclkEdge, U64 mclkTransitions, U64 bits, std::vector<Event>& events, Report& report )
+    {
+        if( !mEnabled )
+            return false;
+        if( !mHaveEdge )
+        {
+            setEdge( sample, bclkEdge, mclkEdge, mclkTransitions );
+            if( mReportStart == 0 )
+                mReportStart = sample;
+            return false;
+        }
+
+        // both MCLK edges are rising edges, so the transitions between them are two per period.
+        U64 mclk_count = 0;
+        if( mclkEdge != 0 && mLastMclkEdge != 0 && mclkEdge > mLastMclkEdge )
+            mclk_count = ( mclkTransitions - mLastMclkTransitions ) / 2;
+        if( mclk_count != 0 )
+        {
+            double mclk_period = double( mclkEdge - mLastMclkEdge ) / double( mclk_count );
+            double phase = double( mclkEdge - sample ) / mclk_period;
+            mclk_count = periods( mclk_count, phase, double( mLastMclkEdge - mLastSample ) / mclk_period );
+            if( mclk_period >= CLOCK_TREE_MIN_PERIOD )
+                checkPhase( mMclkPhase, KIND_MCLK_PHASE, phase, sample, events );
+        }
+
+        // the bits were counted by the decode from one FRAME edge to the next, the bit clock edges are the same ones.
+        if( bclkEdge != 0 && mLastBclkEdge != 0 && bits != 0 )
+        {
+            double bit_period = double( sample - mLastSample ) / double( bits );
+            double phase = double( bclkEdge - sample ) / bit_period;
+            bits = periods( bits, phase, double( mLastBclkEdge - mLastSample ) / bit_period );
+            if( bit_period >= CLOCK_TREE_MIN_PERIOD )
+                checkPhase( mBclkPhase, KIND_BCLK_PHASE, phase, sample, events );
+        }
+
+        checkRatio( mMclkRatio, KIND_MCLK_RATIO, mclk_count, sample, events );
+        checkRatio( mBclkRatio, KIND_BCLK_RATIO, bits, sample, events );
+
+        mFrames++;
+        setEdge( sample, bclkEdge, mclkEdge, mclkTransitions );
+        if( mFrames < CLOCK_TREE_REPORT_FRAMES )
+            return false;
+        makeReport( sample, report );
+        startReport( sample );
+        return true;
+    }
+
+    /**
+     * @brief Report the period so far, e.g. when the data ran out. The period carries on, it is reported again, from its start,
+     *        when it ends.
+     *
+     * @return false if no FRAME period was measured since the period was last reported
+     */
+    bool flush( U64 sampleNumber, Report& report )
+    {
+        if( !mEnabled || mFrames == mReportedFrames )
+            return false;
+        makeReport( sampleNumber, report );
+        mReportedFrames = mFrames;
+        return true;
+    }
+
+  protected:
+    struct Ratio
+    {
+        Ratio() : mKnown( false ), mHaveCandidate( false ), mCount( 0 )
+        {
+        }
+
+        bool mKnown;
+        bool mHaveCandidate; // a count seen once while there is no established one
+        U64 mCount;          // established, or the candidate
+    };
+
+    struct Phase
+    {
+        bool mKnown;
+        double mReference;
+        double mSum; // of the deviations from the reference, over the report period
+        double mSquares;
+        double mMin;
+        double mMax;
+        U64 mCount;
+    };
+
+    void setEdge( U64 sample, U64 bclkEdge, U64 mclkEdge, U64 mclkTransitions )
+    {
+        mHaveEdge = true;
+        mLastSample = sample;
+        mLastBclkEdge = bclkEdge;
+        mLastMclkEdge = mclkEdge;
+        mLastMclkTransitions = mclkTransitions;
+    }
+
+    /**
+     * @brief Clock periods between two FRAME edges, from the clock edges counted between the first clock edges after each of them
+     *        and the phases of those clock edges, in periods after their FRAME edge.
+     */
+    static U64 periods( U64 edges, double phase, double lastPhase )
+    {
+        return U64( std::max( floor( double( edges ) - phase + lastPhase + 0.5 ), 0.0 ) );
+    }
+
+    void checkRatio( Ratio& ratio, Kind kind, U64 count, U64 sample, std::vector<Event>& events )
+    {
+        if( !ratio.mKnown )
+        {
+            ratio.mKnown = ratio.mHaveCandidate && ratio.mCount == count;
+            ratio.mHaveCandidate = true;
+            ratio.mCount = count;
+            return;
+        }
+
+        if( count != ratio.mCount )
+        {
+            addEvent( kind, sample, double( ratio.mCount ), double( count ), events );
+            mRatioChanges++;
+            ratio.mCount = count;
+        }
+    }
+
+    void checkPhase( Phase& phase, Kind kind, double value, U64 sample, std::vector<Event>& events )
+    {
+        value -= floor( value );
+        if( !phase.mKnown )
+        {
+            phase.mKnown = true;
+            phase.mReference = value;
+        }
+
+        double deviation = value - phase.mReference;
+        deviation -= floor( deviation + 0.5 );
+        if( fabs( deviation ) > CLOCK_TREE_PHASE_TOLERANCE )
+        {
+            addEvent( kind, sample, phase.mReference, value, events );
+            mPhaseSlips++;
+            phase.mReference = value;
+        }
+
+        // the deviation of a slip is kept in the statistics, so the peak to peak shows how far it went.
+        phase.mMin = phase.mCount == 0 ? deviation : std::min( phase.mMin, deviation );
+        phase.mMax = phase.mCount == 0 ? deviation : std::max( phase.mMax, deviation );
+        phase.mSum += deviation;
+        phase.mSquares += deviation * deviation;
+        phase.mCount++;
+    }
+
+    void addEvent( Kind kind, U64 sample, double previous, double current, std::vector<Event>& events )
+    {
+        Event event = { kind, sample, previous, current };
+        events.push_back( event );
+    }
+
+    static void startPhase( Phase& phase )
+    {
+        phase.mSum = 0.0;
+        phase.mSquares = 0.0;
+        phase.mMin = 0.0;
+        phase.mMax = 0.0;
+        phase.mCount = 0;
+    }
+
+    static PhaseStatistics phaseStatistics( const Phase& phase )
+    {
+        PhaseStatistics statistics = { -1.0, 0.0, 0.0 };
+        if( phase.mCount == 0 )
+            return statistics;
+        double mean = phase.mSum / double( phase.mCount );
+        double variance = phase.mSquares / double( phase.mCount ) - mean * mean;
+        statistics.mMean = phase.mReference + mean - floor( phase.mReference + mean );
+        statistics.mRms = sqrt( std::max( variance, 0.0 ) );
+        statistics.mPeakToPeak = phase.mMax - phase.mMin;
+        return statistics;
+    }
+
+    void startReport( U64 sampleNumber )
+    {
+        mReportStart = sampleNumber;
+        mFrames = 0;
+        mReportedFrames = 0;
+        mRatioChanges = 0;
+        mPhaseSlips = 0;
+        startPhase( mMclkPhase );
+        startPhase( mBclkPhase );
+    }
+
+    void makeReport( U64 sampleNumber, Report& report )
+    {
+        report.mFirstSample = mReportStart;
+        report.mLastSample = sampleNumber;
+        report.mFrames = mFrames;
+        report.mMclkPerFrame = mMclkRatio.mKnown ? mMclkRatio.mCount : 0;
+        report.mBclkPerFrame = mBclkRatio.mKnown ? mBclkRatio.mCount : 0;
+        report.mRatioChanges = mRatioChanges;
+        report.mPhaseSlips = mPhaseSlips;
+        report.mMclkPhase = phaseStatistics( mMclkPhase );
+        report.mBclkPhase = phaseStatistics( mBclkPhase );
+    }
+
+    bool mEnabled;
+
+    bool mHaveEdge;
+    U64 mLastSample;          // last FRAME rising edge
+    U64 mLastBclkEdge;        // the first data valid bit clock edge after it, 0 without one
+    U64 mLastMclkEdge;        // the first MCLK rising edge after it, 0 when there was none
+    U64 mLastMclkTransitions; // MCLK transitions walked up to just before mLastMclkEdge
+
+    Ratio mMclkRatio;
+    Ratio mBclkRatio;
+    Phase mMclkPhase;
+    Phase mBclkPhase;
+
+    U64 mReportStart;
+    U64 mFrames;
+    U64 mReportedFrames; // mFrames when the period was last flushed
+    U64 mRatioChanges;
+    U64 mPhaseSlips;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+
+#include <cmath>
+#include <vector>
+
+/**
+ * @brief In-place radix-2 FFT of a real block.
+ *
+ * Real and imaginary parts are kept in separate arrays and the twiddle and bit reversal tables are precomputed, so the butterfly
+ * loops are plain strided arithmetic the compiler can vectorise. The input is written straight to its bit reversed position.
+ */
+class Fft
+{
+  public:
+    Fft() : mSize( 0 )
+    {
+    }
+
+    /**
+     * @param size power of two
+     */
+    void setup( U32 size )
+    {
+        mSize = size;
+        const double pi = 3.14159265358979323846;
+
+        mTwiddleRe.resize( mSize / 2 );
+        mTwiddleIm.resize( mSize / 2 );
+        for( U32 i = 0; i < mSize / 2; i++ )
+        {
+            mTwiddleRe[ i ] = cos( -2.0 * pi * double( i ) / double( mSize ) );
+            mTwiddleIm[ i ] = sin( -2.0 * pi * double( i ) / double( mSize ) );
+        }
+
+        U32 bits = 0;
+        while( ( 1U << bits ) < mSize )
+        {
+            bits++;
+        }
+        mBitReverse.resize( mSize );
+        for( U32 i = 0; i < mSize; i++ )
+        {
+            U32 reversed = 0;
+            for( U32 b = 0; b < bits; b++ )
+            {
+                reversed |= ( ( i >> b ) & 1 ) << ( bits - 1 - b );
+            }
+            mBitReverse[ i ] = reversed;
+        }
+
+        mRe.resize( mSize );
+        mIm.resize( mSize );
+    }
+
+    U32 size() const
+    {
+        return mSize;
+    }
+
+    /**
+     * @brief Input sample i of the next transform().
+     */
+    void set( U32 i, double value )
+    {
+        U32 j = mBitReverse[ i ];
+        mRe[ j ] = value;
+        mIm[ j ] = 0.0;
+    }
+
+    // Iterative radix-2 decimation in time, the input is already in bit reversed order.
+    void transform()
+    {
+        for( U32 size = 2; size <= mSize; size <<= 1 )
+        {
+            U32 halfSize = size >> 1;
+            U32 twiddleStep = mSize / size;
+            for( U32 start = 0; start < mSize; start += size )
+            {
+                double* re0 = &mRe[ start ];
+                double* im0 = &mIm[ start ];
+                double* re1 = &mRe[ start + halfSize ];
+                double* im1 = &mIm[ start + halfSize ];
+                for( U32 k = 0; k < halfSize; k++ )
+                {
+                    double wr = mTwiddleRe[ k * twiddleStep ];
+                    double wi = mTwiddleIm[ k * twiddleStep ];
+                    double tr = re1[ k ] * wr - im1[ k ] * wi;
+                    double ti = re1[ k ] * wi + im1[ k ] * wr;
+                    re1[ k ] = re0[ k ] - tr;
+                    im1[ k ] = im0[ k ] - ti;
+                    re0[ k ] += tr;
+                    im0[ k ] += ti;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Squared magnitude of a bin of the last transform().
+     */
+    double power( U32 bin ) const
+    {
+        return mRe[ bin ] * mRe[ bin ] + mIm[ bin ] * mIm[ bin ];
+    }
+
+  protected:
+    U32 mSize;
+    std::vector<double> mTwiddleRe;
+    std::vector<double> mTwiddleIm;
+    std::vector<U32> mBitReverse;
+    std::vector<double> mRe;
+    std::vector<double> mIm;
+};
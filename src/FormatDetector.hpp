@@ -0,0 +1,293 @@
+#pragma once
+
+#include <AnalyzerChannelData.h>
+#include <AnalyzerTypes.h>
+#include "I2sTestalyserSettings.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#define FORMAT_DETECTOR_MIN_PERIODS 8
+#define FORMAT_DETECTOR_TOGGLE_TOLERANCE 0.1
+#define FORMAT_DETECTOR_IDLE_RATE 0.02
+
+/**
+ * @brief Guesses the bus format from a short stretch of captured edges, before the main decode starts.
+ *
+ * The DATA transition phase against CLOCK gives the data valid edge, CLOCK edges per FRAME period and the FRAME duty cycle give
+ * the frame type candidates. Candidates are scored on the per-bit toggle rate across consecutive frames: in a correctly
+ * framed MSB first word the rate never drops from one bit to the next, so a drop marks a word border that the candidate misses.
+ * Bits that hardly toggle (the sign of a slow signal, a counter's top bits) blur the word borders, so a near tie goes to the candidate
+ * whose words are exactly a standard bit depth long, and then to the current setting.
+ */
+class FormatDetector
+{
+  public:
+    struct Edges
+    {
+        BitState mInitial;
+        std::vector<U64> mSamples;
+    };
+
+    struct Result
+    {
+        bool mValid;
+        const char* mReason; // why detection failed, when !mValid
+        U32 mBitsPerPeriod;  // data valid CLOCK edges per FRAME period
+        double mDutyCycle;   // FRAME high time / period
+        AnalyzerEnums::EdgeDirection mDataValidEdge;
+        PcmFrameType mFrameType;
+        PcmBitAlignment mBitAlignment;
+        U32 mSlotBits;
+        U32 mBitsPerWord;
+        double mScore; // sum of toggle rate drops inside words, 0 for a clean fit
+    };
+
+    /**
+     * @brief Record the edges of a channel up to end_sample, leaving the channel at end_sample.
+     *        Stops early at the end of the data that is currently available.
+     */
+    static void collect( AnalyzerChannelData* channel, U64 end_sample, Edges& edges )
+    {
+        edges.mInitial = channel->GetBitState();
+        edges.mSamples.clear();
+        while( channel->DoMoreTransitionsExistInCurrentData() && channel->GetSampleOfNextEdge() <= end_sample )
+        {
+            channel->AdvanceToNextEdge();
+            edges.mSamples.push_back( channel->GetSampleNumber() );
+        }
+        channel->AdvanceToAbsPosition( end_sample );
+    }
+
+    Result detect( const Edges& clock, const Edges& frame, const Edges& data, const I2sFrameFormat& current ) const
+    {
+        Result result = {};
+        result.mValid = false;
+
+        if( clock.mSamples.size() < 4 || data.mSamples.empty() )
+        {
+            result.mReason = clock.mSamples.size() < 4 ? "no CLOCK activity" : "no DATA activity";
+            return result;
+        }
+
+        // DATA changes on the launch edge, so it is read on the opposite one.
+        U64 launched_on_falling = 0;
+        U64 launched_on_rising = 0;
+        size_t c = 0;
+        for( U64 sample : data.mSamples )
+        {
+            while( c < clock.mSamples.size() && clock.mSamples[ c ] <= sample )
+                c++;
+            if( c == 0 )
+                continue;
+            if( levelAfter( clock, c - 1 ) == BIT_LOW )
+                launched_on_falling++;
+            else
+                launched_on_rising++;
+        }
+        result.mDataValidEdge = launched_on_falling >= launched_on_rising ? AnalyzerEnums::PosEdge : AnalyzerEnums::NegEdge;
+
+        // FRAME and DATA as the decoder will see them, one entry per data valid edge.
+        std::vector<U8> frame_bits;
+        std::vector<U8> data_bits;
+        size_t f = 0;
+        size_t d = 0;
+        for( size_t i = 0; i < clock.mSamples.size(); i++ )
+        {
+            BitState level = levelAfter( clock, i );
+            if( ( level == BIT_HIGH ) != ( result.mDataValidEdge == AnalyzerEnums::PosEdge ) )
+                continue;
+
+            U64 sample = clock.mSamples[ i ];
+            while( f < frame.mSamples.size() && frame.mSamples[ f ] <= sample )
+                f++;
+            while( d < data.mSamples.size() && data.mSamples[ d ] <= sample )
+                d++;
+            frame_bits.push_back( levelAt( frame, f ) == BIT_HIGH );
+            data_bits.push_back( levelAt( data, d ) == BIT_HIGH );
+        }
+
+        // Frames start where FRAME is first read high, like the decoder.
+        std::vector<size_t> starts;
+        U64 high_bits = 0;
+        for( size_t i = 1; i < frame_bits.size(); i++ )
+        {
+            if( frame_bits[ i ] && !frame_bits[ i - 1 ] )
+                starts.push_back( i );
+        }
+
+        std::map<U32, U32> period_votes;
+        for( size_t i = 1; i < starts.size(); i++ )
+            period_votes[ U32( starts[ i ] - starts[ i - 1 ] ) ]++;
+
+        U32 period = 0;
+        U32 period_count = 0;
+        for( auto& vote : period_votes )
+        {
+            if( vote.second > period_count )
+            {
+                period = vote.first;
+                period_count = vote.second;
+            }
+        }
+        if( period_count < FORMAT_DETECTOR_MIN_PERIODS || period < 4 )
+        {
+            result.mReason = "too few FRAME periods";
+            return result;
+        }
+        result.mBitsPerPeriod = period;
+
+        // Toggle rate of every bit position between consecutive frames of the usual length.
+        std::vector<double> toggle_rate( period, 0.0 );
+        U32 frames_compared = 0;
+        for( size_t i = 0; i + 1 < starts.size(); i++ )
+        {
+            if( starts[ i + 1 ] - starts[ i ] != period || starts[ i + 1 ] + period > data_bits.size() )
+                continue;
+            for( U32 k = 0; k < period; k++ )
+            {
+                toggle_rate[ k ] += data_bits[ starts[ i ] + k ] != data_bits[ starts[ i + 1 ] + k ];
+                high_bits += frame_bits[ starts[ i ] + k ];
+            }
+            frames_compared++;
+        }
+        if( frames_compared < FORMAT_DETECTOR_MIN_PERIODS - 1 )
+        {
+            result.mReason = "too few FRAME periods";
+            return result;
+        }
+        for( U32 k = 0; k < period; k++ )
+            toggle_rate[ k ] /= double( frames_compared );
+        result.mDutyCycle = double( high_bits ) / double( U64( frames_compared ) * period );
+
+        // A square FRAME is one word per half, a pulse is one or four words per period.
+        std::vector<PcmFrameType> frame_types;
+        if( result.mDutyCycle > 0.4 && result.mDutyCycle < 0.6 )
+        {
+            frame_types.push_back( FRAME_TRANSITION_ONCE_EVERY_WORD );
+        }
+        else
+        {
+            frame_types.push_back( FRAME_TRANSITION_TWICE_EVERY_WORD );
+            frame_types.push_back( FRAME_TRANSITION_TWICE_EVERY_FOUR_WORDS );
+            if( current.mFrameType == FRAME_TRANSITION_TWICE_EVERY_FOUR_WORDS )
+                std::swap( frame_types[ 0 ], frame_types[ 1 ] );
+        }
+
+        PcmBitAlignment bit_alignments[ 2 ] = { current.mBitAlignment, current.mBitAlignment == NO_SHIFT ? BITS_SHIFTED_RIGHT_1 : NO_SHIFT };
+
+        bool found = false;
+        bool found_standard = false;
+        for( PcmFrameType frame_type : frame_types )
+        {
+            U32 words = wordsPerFrame( frame_type );
+            if( period % words != 0 )
+                continue;
+
+            for( PcmBitAlignment bit_alignment : bit_alignments )
+            {
+                U32 shift = bit_alignment == BITS_SHIFTED_RIGHT_1 ? 1 : 0;
+                U32 used_bits = 0;
+                double score = scoreCandidate( toggle_rate, words, shift, used_bits );
+
+                if( used_bits == 0 )
+                    continue;
+
+                // the first candidate is the current setting, anything else has to be clearly better.
+                bool standard = isStandardDepth( used_bits ) || used_bits == period / words;
+                bool better = score < result.mScore - FORMAT_DETECTOR_TOGGLE_TOLERANCE;
+                bool tie = !better && score <= result.mScore + FORMAT_DETECTOR_TOGGLE_TOLERANCE;
+                if( !found || better || ( tie && standard && !found_standard ) )
+                {
+                    found = true;
+                    found_standard = standard;
+                    result.mScore = score;
+                    result.mFrameType = frame_type;
+                    result.mBitAlignment = bit_alignment;
+                    result.mSlotBits = period / words;
+                    result.mBitsPerWord = standardDepth( used_bits, result.mSlotBits );
+                }
+            }
+        }
+
+        if( !found )
+        {
+            result.mReason = "no DATA activity";
+            return result;
+        }
+
+        result.mValid = true;
+        result.mReason = "";
+        return result;
+    }
+
+    static U32 wordsPerFrame( PcmFrameType frame_type )
+    {
+        switch( frame_type )
+        {
+        case FRAME_TRANSITION_TWICE_EVERY_WORD:
+            return 1;
+        case FRAME_TRANSITION_TWICE_EVERY_FOUR_WORDS:
+            return 4;
+        default:
+            return 2;
+        }
+    }
+
+  protected:
+    static BitState levelAfter( const Edges& edges, size_t edge_index )
+    {
+        // every edge toggles, the level after edge n is the initial level flipped n + 1 times.
+        return ( ( edge_index + 1 ) & 1 ) ? ( edges.mInitial == BIT_HIGH ? BIT_LOW : BIT_HIGH ) : edges.mInitial;
+    }
+
+    static BitState levelAt( const Edges& edges, size_t edges_passed )
+    {
+        return edges_passed == 0 ? edges.mInitial : levelAfter( edges, edges_passed - 1 );
+    }
+
+    /**
+     * @return the sum of toggle rate drops inside the candidate's words, with the most bits in use by any word in used_bits.
+     */
+    static double scoreCandidate( const std::vector<double>& toggle_rate, U32 words, U32 shift, U32& used_bits )
+    {
+        U32 period = toggle_rate.size();
+        U32 slot_bits = period / words;
+        double score = 0.0;
+        used_bits = 0;
+
+        for( U32 w = 0; w < words; w++ )
+        {
+            U32 first = shift + w * slot_bits;
+
+            // trailing bits that never toggle are padding, not part of the word.
+            U32 used = slot_bits;
+            while( used > 0 && toggle_rate[ ( first + used - 1 ) % period ] < FORMAT_DETECTOR_IDLE_RATE )
+                used--;
+            used_bits = std::max( used_bits, used );
+
+            for( U32 j = 0; j + 1 < used; j++ )
+            {
+                double drop = toggle_rate[ ( first + j ) % period ] - toggle_rate[ ( first + j + 1 ) % period ];
+                score += std::max( 0.0, drop - FORMAT_DETECTOR_TOGGLE_TOLERANCE );
+            }
+        }
+        return score;
+    }
+
+    static bool isStandardDepth( U32 bits )
+    {
+        return bits == 8 || bits == 16 || bits == 20 || bits == 24 || bits == 32;
+    }
+
+    static U32 standardDepth( U32 used_bits, U32 slot_bits )
+    {
+        for( U32 depth : { 8, 16, 20, 24, 32 } )
+        {
+            if( used_bits <= depth )
+                return std::max<U32>( std::min( depth, slot_bits ), 2 );
+        }
+        return std::min<U32>( slot_bits, 64 );
+    }
+};
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+
+#include <vector>
+
+#define FRAME_LENGTH_LOCK_FRAMES 4      // FRAME periods in a row with the same bit count to establish it
+#define FRAME_LENGTH_REPORT_FRAMES 4096 // FRAME periods between summaries
+#define FRAME_LENGTH_MAX_RUNS 32        // runs kept per summary, the rest only go into the histogram
+#define FRAME_LENGTH_MAX_LENGTHS 16     // bit counts in the histogram of a summary, the rest are counted together
+#define FRAME_LENGTH_MAX_SLIPS 16       // slip positions kept per summary
+
+/**
+ * @brief Bit counts of the FRAME periods, as runs of equal counts and a histogram, and the slips among them.
+ *
+ * A bit count is established once FRAME_LENGTH_LOCK_FRAMES FRAME periods in a row have it. A FRAME period with another count is a
+ * slip. Should the other count hold for FRAME_LENGTH_LOCK_FRAMES FRAME periods, it is established in turn. Nothing is kept per
+ * FRAME period, a period that continues the current run only counts it.
+ */
+class FrameLengthTracker
+{
+  public:
+    struct Run
+    {
+        U32 mBits;
+        U64 mFrames;
+    };
+
+    struct Slip
+    {
+        U64 mSample; // first bit of the FRAME period
+        U32 mBits;
+        U32 mNominal; // established bit count
+    };
+
+    struct Report
+    {
+        U64 mFirstSample;
+        U64 mLastSample;
+        U64 mFrames;
+        U32 mNominal; // established bit count, 0 while there is none
+        U64 mSlips;
+        U64 mTotalSlips; // since the decode started
+        std::vector<Run> mRuns;
+        bool mRunsTruncated;       // later runs only went into the histogram
+        std::vector<Run> mLengths; // frames per bit count
+        U64 mOtherFrames;          // frames with bit counts that didn't fit in mLengths
+        std::vector<U64> mSlipSamples; // the first FRAME_LENGTH_MAX_SLIPS
+    };
+
+    FrameLengthTracker() : mEnabled( false )
+    {
+        setup( false );
+    }
+
+    void setup( bool enabled )
+    {
+        mEnabled = enabled;
+        mNominal = 0;
+        mCandidate = 0;
+        mCandidateFrames = 0;
+        mTotalSlips = 0;
+        startReport( 0 );
+    }
+
+    bool enabled() const
+    {
+        return mEnabled;
+    }
+
+    /**
+     * @brief A FRAME period was read.
+     *
+     * @param sample its first bit
+     * @return true when a report period ended, with the summary in report
+     */
+    bool frame( U64 sample, U32 bits, std::vector<Slip>& slips, Report& report )
+    {
+        if( !mEnabled )
+            return false;
+        if( mReportStart == 0 )
+            mReportStart = sample;
+
+        // the run in progress is the last one, unless the list is full.
+        if( !mRuns.empty() && mRuns.back().mBits == bits && !mRunsTruncated )
+            mRuns.back().mFrames++;
+        else if( mRuns.size() < FRAME_LENGTH_MAX_RUNS )
+            mRuns.push_back( Run{ bits, 1 } );
+        else
+            mRunsTruncated = true;
+        addLength( bits );
+        mFrames++;
+
+        if( mNominal != 0 && bits != mNominal )
+        {
+            Slip slip = { sample, bits, mNominal };
+            slips.push_back( slip );
+            if( mSlipSamples.size() < FRAME_LENGTH_MAX_SLIPS )
+                mSlipSamples.push_back( sample );
+            mSlips++;
+            mTotalSlips++;
+        }
+
+        mCandidateFrames = bits == mCandidate ? mCandidateFrames + 1 : 1;
+        mCandidate = bits;
+        if( mCandidateFrames >= FRAME_LENGTH_LOCK_FRAMES )
+            mNominal = bits;
+
+        if( mFrames < FRAME_LENGTH_REPORT_FRAMES )
+            return false;
+        makeReport( sample, report );
+        startReport( sample );
+        return true;
+    }
+
+    /**
+     * @brief Report the period so far, e.g. when the data ran out. The period carries on, it is reported again, from its start,
+     *        when it ends.
+     *
+     * @return false if no FRAME period was read since the period was last reported
+     */
+    bool flush( U64 sampleNumber, Report& report )
+    {
+        if( !mEnabled || mFrames == mReportedFrames )
+            return false;
+        makeReport( sampleNumber, report );
+        mReportedFrames = mFrames;
+        return true;
+    }
+
+  protected:
+    void addLength( U32 bits )
+    {
+        for( Run& length : mLengths )
+        {
+            if( length.mBits == bits )
+            {
+                length.mFrames++;
+                return;
+            }
+        }
+        if( mLengths.size() < FRAME_LENGTH_MAX_LENGTHS )
+            mLengths.push_back( Run{ bits, 1 } );
+        else
+            mOtherFrames++;
+    }
+
+    void startReport( U64 sampleNumber )
+    {
+        mReportStart = sampleNumber;
+        mFrames = 0;
+        mReportedFrames = 0;
+        mSlips = 0;
+        mRuns.clear();
+        mRunsTruncated = false;
+        mLengths.clear();
+        mOtherFrames = 0;
+        mSlipSamples.clear();
+    }
+
+    void makeReport( U64 sampleNumber, Report& report )
+    {
+        report.mFirstSample = mReportStart;
+        report.mLastSample = sampleNumber;
+        report.mFrames = mFrames;
+        report.mNominal = mNominal;
+        report.mSlips = mSlips;
+        report.mTotalSlips = mTotalSlips;
+        report.mRuns = mRuns;
+        report.mRunsTruncated = mRunsTruncated;
+        report.mLengths = mLengths;
+        report.mOtherFrames = mOtherFrames;
+        report.mSlipSamples = mSlipSamples;
+    }
+
+    bool mEnabled;
+
+    U32 mNominal; // established bit count, 0 while there is none
+    U32 mCandidate;
+    U32 mCandidateFrames; // FRAME periods in a row with mCandidate bits
+    U64 mTotalSlips;
+
+    U64 mReportStart;
+    U64 mFrames;
+    U64 mReportedFrames; // mFrames when the period was last flushed
+    U64 mSlips;
+    std::vector<Run> mRuns;
+    bool mRunsTruncated;
+    std::vector<Run> mLengths;
+    U64 mOtherFrames;
+    std::vector<U64> mSlipSamples;
+};
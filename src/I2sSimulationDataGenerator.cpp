@@ -23,10 +23,15 @@ void I2sSimulationTestDataGenerator::Initialize( U32 simulation_sample_rate, I2s
     mSimulationSampleRateHz = simulation_sample_rate;
     mSettings = settings;
 
-    if( mSettings->mDataValidEdge == AnalyzerEnums::NegEdge )
-        mClock = mSimulationChannels.Add( mSettings->mClockChannel, mSimulationSampleRateHz, BIT_LOW );
-    else
-        mClock = mSimulationChannels.Add( mSettings->mClockChannel, mSimulationSampleRateHz, BIT_HIGH );
+    // TEST_EXTENSION: no CLOCK channel when the analyzer recovers the bit clock.
+    mClock = NULL;
+    if( mSettings->mClockChannel != UNDEFINED_CHANNEL )
+    {
+        if( mSettings->mDataValidEdge == AnalyzerEnums::NegEdge )
+            mClock = mSimulationChannels.Add( mSettings->mClockChannel, mSimulationSampleRateHz, BIT_LOW );
+        else
+            mClock = mSimulationChannels.Add( mSettings->mClockChannel, mSimulationSampleRateHz, BIT_HIGH );
+    }
 
     mFrame = mSimulationChannels.Add( mSettings->mFrameChannel, mSimulationSampleRateHz, BIT_LOW );
     mData = mSimulationChannels.Add( mSettings->mDataChannel, mSimulationSampleRateHz, BIT_LOW );
@@ -39,6 +44,12 @@ void I2sSimulationTestDataGenerator::Initialize( U32 simulation_sample_rate, I2s
     mCurrentAudioChannel = Left;
     mPaddingCount = 0;
 
+    // TEST_EXTENSION
+    mSequencePattern = mSettings->mTestSettings.mTestMode == TEST_SEQUENCE && mSequenceCrc.setup( mSettings->mBitsPerWord );
+    mSequenceNumber = 0;
+    mSequenceSubframe = 0;
+    mSequenceFrame.assign( mSettings->GetChannelsCount(), 0 );
+
     U64 audio_bit_depth = mSettings->mBitsPerWord;
 
     if( mSettings->mShiftOrder == AnalyzerEnums::MsbFirst )
@@ -238,6 +249,9 @@ S64 I2sSimulationTestDataGenerator::GetNextAudioWord()
 {
     S64 value;
 
+    if( mSequencePattern )
+        return GetNextSequenceWord();
+
     // return 0xFFFF;
 
     if( mCurrentAudioChannel == Left )
@@ -257,6 +271,31 @@ S64 I2sSimulationTestDataGenerator::GetNextAudioWord()
     return value;
 }
 
+// TEST_EXTENSION
+S64 I2sSimulationTestDataGenerator::GetNextSequenceWord()
+{
+    // words are sent in subframe order, starting with subframe 0. The Channel 1 word is channel 0 of the test frame, and carries
+    // the CRC of the channels after it, so the whole frame is made up when it starts.
+    U32 channel_count = mSettings->GetChannelsCount();
+    U32 channel = ( mSequenceSubframe + channel_count - mSettings->GetChannel1Subframe() ) % channel_count;
+    mSequenceSubframe = ( mSequenceSubframe + 1 ) % channel_count;
+
+    if( channel == 0 )
+    {
+        U64 word_mask = ( mSettings->mBitsPerWord >= 64 ) ? ~0ULL : ( ( 1ULL << mSettings->mBitsPerWord ) - 1 );
+        for( U32 i = 1; i < channel_count; i++ )
+            mSequenceFrame[ i ] = U64( mSineWaveSamplesLeft[ mCurrentAudioWordIndex ] ) & word_mask;
+        mSequenceFrame[ 0 ] = mSequenceCrc.header( mSequenceNumber, &mSequenceFrame[ 0 ] + 1, channel_count - 1 );
+        mSequenceNumber++;
+
+        mCurrentAudioWordIndex++;
+        if( mCurrentAudioWordIndex >= mSineWaveSamplesLeft.size() )
+            mCurrentAudioWordIndex = 0;
+    }
+
+    return S64( mSequenceFrame[ channel ] );
+}
+
 void I2sSimulationTestDataGenerator::InitSineWave()
 {
     U32 sine_freq = 220;
@@ -281,7 +320,8 @@ inline void I2sSimulationTestDataGenerator::WriteBit( BitState data, BitState fr
     mSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( 1.0 ) );
 
     //'posedge' on clock, write update data lines:
-    mClock->Transition();
+    if( mClock != NULL )
+        mClock->Transition();
 
     mFrame->TransitionIfNeeded( frame );
 
@@ -290,5 +330,6 @@ inline void I2sSimulationTestDataGenerator::WriteBit( BitState data, BitState fr
     mSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByHalfPeriod( 1.0 ) );
 
     //'negedge' on clock, data is valid.
-    mClock->Transition();
+    if( mClock != NULL )
+        mClock->Transition();
 }
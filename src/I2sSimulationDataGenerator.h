@@ -39,6 +39,7 @@ class I2sSimulationTestDataGenerator
     void InitSineWave();
     void WriteBit( BitState data, BitState frame );
     S64 GetNextAudioWord();
+    S64 GetNextSequenceWord();
     BitState GetNextAudioBit();
     BitState GetNextFrameBit();
 
@@ -59,6 +60,13 @@ class I2sSimulationTestDataGenerator
     U32 mPaddingCount;
     BitGenerarionState mBitGenerationState;
 
+    // TEST_EXTENSION: the sequence test pattern, when that test is selected.
+    bool mSequencePattern;
+    SequenceCrc mSequenceCrc;
+    U64 mSequenceNumber;
+    U32 mSequenceSubframe;           // of the next word
+    std::vector<U64> mSequenceFrame; // words of the frame being sent, in channel order
+
     // Fake data settings:
     double mAudioSampleRate;
     bool mUseShortFrames;
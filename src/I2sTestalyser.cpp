@@ -1,9 +1,13 @@
 #include "I2sTestalyser.h"
 #include "I2sTestalyserSettings.h"
+#include "FormatDetector.hpp"
 #include <AnalyzerChannelData.h>
+#include <math.h>
+#include <algorithm>
 
 I2sTestalyser::I2sTestalyser() : Analyzer2(), mSettings( new I2sTestalyserSettings() ), mSimulationInitilized( false )
 {
+    mFormat = mSettings->GetFrameFormat();
     SetAnalyzerSettings( mSettings.get() );
     UseFrameV2();
 }
@@ -22,18 +26,140 @@ void I2sTestalyser::SetupResults()
 
 void I2sTestalyser::WorkerThread()
 {
+    mFormat = mSettings->GetFrameFormat();
+
+    // TEST_EXTENSION: without a CLOCK, the bit clock is recovered from DATA and FRAME.
+    mClock = NULL;
+    if( mSettings->mClockChannel != UNDEFINED_CHANNEL )
+        mClock = GetAnalyzerChannelData( mSettings->mClockChannel );
+    mFrame = GetAnalyzerChannelData( mSettings->mFrameChannel );
+    mData = GetAnalyzerChannelData( mSettings->mDataChannel );
+    mTimebase = mClock != NULL ? mClock : mFrame;
+
+    // TEST_EXTENSION: clock tree monitor.
+    mMasterClock = NULL;
+    if( mSettings->mMasterClockChannel != UNDEFINED_CHANNEL )
+        mMasterClock = GetAnalyzerChannelData( mSettings->mMasterClockChannel );
+
+    // TEST_EXTENSION: loopback output stream, sampled at the CLOCK edges unless it has a CLOCK and FRAME of its own.
+    mOutputClock = NULL;
+    mOutputFrame = NULL;
+    mOutputData = NULL;
+    if( mSettings->mTestSettings.mLoopbackReportInterval != 0 && mSettings->mOutputDataChannel != UNDEFINED_CHANNEL )
+    {
+        mOutputData = GetAnalyzerChannelData( mSettings->mOutputDataChannel );
+        if( mSettings->mOutputClockChannel != UNDEFINED_CHANNEL )
+        {
+            mOutputClock = GetAnalyzerChannelData( mSettings->mOutputClockChannel );
+            mOutputFrame = GetAnalyzerChannelData( mSettings->mOutputFrameChannel );
+        }
+    }
+
+    mErrorMergeGapSamples = U64( mSettings->mTestSettings.mErrorMergeGapUs ) * GetSampleRate() / 1000000;
+    mErrorRange.mCount = 0;
+
+    SetupDecodeRange();
+    if( mDecodeStartSample != 0 )
+    {
+        // seek straight to the window, without walking the edges before it.
+        if( mClock != NULL )
+            mClock->AdvanceToAbsPosition( mDecodeStartSample );
+        mFrame->AdvanceToAbsPosition( mDecodeStartSample );
+        mData->AdvanceToAbsPosition( mDecodeStartSample );
+        if( mMasterClock != NULL )
+            mMasterClock->AdvanceToAbsPosition( mDecodeStartSample );
+        if( mOutputData != NULL )
+            mOutputData->AdvanceToAbsPosition( mDecodeStartSample );
+        if( mOutputClock != NULL )
+        {
+            mOutputClock->AdvanceToAbsPosition( mDecodeStartSample );
+            mOutputFrame->AdvanceToAbsPosition( mDecodeStartSample );
+        }
+    }
+
+    // may change the format of this run, so before anything that depends on it. It needs the CLOCK.
+    if( mSettings->mTestSettings.mFormatDetectionMs != 0 && mClock != NULL )
+        DetectFormat();
+
     // TEST_EXTENSION
-    mTest.setup(mSettings->GetChannelsCount(), mSettings->mTestSettings);
+    mTest.setup(mFormat.GetChannelsCount(), mFormat.mBitsPerWord, GetSampleRate(), mSettings->mTestSettings);
+    if( mSettings->mTestSettings.mTestMode == TestMode::TEST_REFERENCE && !mTest.referenceEnabled() )
+    {
+        ReferenceCompare::Event event = { ReferenceCompare::EVENT_ERROR, mTimebase->GetSampleNumber(), 0, 0, 0, 0, 0 };
+        AddReferenceFrame( event, mTimebase->GetSampleNumber() );
+        mResults->CommitResults();
+    }
+    if( mSettings->mTestSettings.mTestMode == TestMode::TEST_SEQUENCE && !mTest.sequenceEnabled() )
+    {
+        SequenceCheck::Event event = { SequenceCheck::KIND_ERROR, 0, 0, 0, mTimebase->GetSampleNumber(), 0, 0 };
+        AddSequenceFrame( event, mTimebase->GetSampleNumber() );
+        mResults->CommitResults();
+    }
+    mStartupReportPending = false;
+    if( mTest.startupEnabled() )
+    {
+        // the first power cycle is timed from the start of the decode.
+        StartupTiming::Cycle finished;
+        mTest.startupStart( mTimebase->GetSampleNumber(), mTimebase->GetSampleOfNextEdge(), finished );
+    }
+    if( mOutputClock != NULL )
+        mOutputDecoder.setup( mOutputClock, mOutputFrame, mOutputData, mFormat );
+    mLevelWordsSinceTotals = 0;
+    mLastAnalyzedSample = 0;
+    mReportsFlushed = false;
+    mReportsFlushedSample = 0;
+    mBitPeriod = 0;
+    mLastDataValidSample = 0;
+    mClockGapPending = false;
 
     // UpArrow, DownArrow
-    if( mSettings->mDataValidEdge == AnalyzerEnums::NegEdge )
+    if( mFormat.mDataValidEdge == AnalyzerEnums::NegEdge )
         mArrowMarker = AnalyzerResults::DownArrow;
     else
         mArrowMarker = AnalyzerResults::UpArrow;
 
-    mClock = GetAnalyzerChannelData( mSettings->mClockChannel );
-    mFrame = GetAnalyzerChannelData( mSettings->mFrameChannel );
-    mData = GetAnalyzerChannelData( mSettings->mDataChannel );
+    mTransitions = 0;
+    mBitTransitions = 0;
+    mCacheTransitions = 0;
+    mReplayPosition = REPLAY_NONE;
+    mCacheFrameStartPending = false;
+    mCache.close();
+    if( !mSettings->mTestSettings.mResultCacheDirectory.empty() )
+    {
+        ResultCacheBlocker blocker;
+        if( !CanUseResultCache( blocker ) )
+        {
+            AddResultCacheUnusedFrame( blocker, mTimebase->GetSampleNumber() );
+            mResults->CommitResults();
+        }
+        else if( mCache.open( mSettings->mTestSettings.mResultCacheDirectory, GetResultCacheKey(), mFormat.mBitsPerWord ) )
+            ReplayResultCache();
+    }
+
+    // TEST_EXTENSION
+    U32 recovered_bits_per_frame = mSettings->mTestSettings.mRecoveredBitsPerFrame;
+    if( recovered_bits_per_frame == 0 )
+        recovered_bits_per_frame = mFormat.mBitsPerWord * mFormat.GetChannelsCount();
+    mRecovery.setup( recovered_bits_per_frame );
+    mRecoveryReports.clear();
+    mClockTree.setup( mMasterClock != NULL );
+    mMasterClockTransitions = 0;
+    mClockTreeBits = 0;
+    mClockTreeEvents.clear();
+    mClockTreeReports.clear();
+    // the recovered clock's bits are placed by the recovery loop, they have no edges of their own to measure.
+    mJitter.setup( mClock != NULL ? mSettings->mTestSettings.mJitterSpectrumBlockSize : 0, GetSampleRate(),
+                   mSettings->mTestSettings.mJitterSpectrumCsvFile );
+    mJitterReports.clear();
+    mClockPulses.setup( mClock != NULL ? mSettings->mTestSettings.mClockGlitchPercent / 100.0 : 0.0 );
+    mClockGlitches.clear();
+    mClockPulseReports.clear();
+    mFrameLengths.setup( mSettings->mTestSettings.mFrameLengthTracking );
+    mFrameSlips.clear();
+    mFrameLengthReports.clear();
+    mSampleRates.setup( mSettings->mTestSettings.mSampleRateSegments, GetSampleRate() );
+    mRateSegments.clear();
+    mRateChanges.clear();
 
     SetupForGettingFirstBit();
     SetupForGettingFirstFrame();
@@ -41,10 +167,39 @@ void I2sTestalyser::WorkerThread()
     for( ;; )
     {
         GetFrame();
-        AnalyzeFrame();
+
+        if( !mClockGapPending && mDataValidEdges.front() > mDecodeEndSample )
+        {
+            // past the end of the window, the frame started outside of it.
+            FlushReports();
+            mResults->CommitResults();
+            SkipToEndOfCapture();
+        }
+
+        if( mClockGapPending )
+        {
+            // the frame was cut by the gap, drop it and find the start of the next one.
+            AddClockGapFrame();
+            SetupForGettingFirstFrame();
+        }
+        else
+        {
+            FlushStaleErrorRange( mDataValidEdges.front() );
+            AnalyzeFrame();
+            mCache.endFrame();
+            mLastAnalyzedSample = mDataValidEdges.back();
+        }
+
+        // TEST_EXTENSION
+        AddClockRecoveryFrames( mLastAnalyzedSample );
+        AddClockTreeFrames( mLastAnalyzedSample );
+        AddJitterSpectrumFrames( mLastAnalyzedSample );
+        AddClockPulseFrames( mLastAnalyzedSample );
+        AddFrameLengthFrames( mLastAnalyzedSample );
+        AddSampleRateFrames( mLastAnalyzedSample );
 
         mResults->CommitResults();
-        ReportProgress( mClock->GetSampleNumber() );
+        ReportProgress( mTimebase->GetSampleNumber() );
         CheckIfThreadShouldExit();
     }
 }
@@ -54,8 +209,28 @@ void I2sTestalyser::AnalyzeFrame()
 {
     U32 num_bits = mDataBits.size();
 
+    // TEST_EXTENSION: every FRAME period, including the ones with errors. Slips go to the test server straight away.
+    FrameLengthTracker::Report length_report;
+    if( mFrameLengths.frame( mDataValidEdges.front(), num_bits, mFrameSlips, length_report ) )
+        mFrameLengthReports.push_back( length_report );
+    for( const FrameLengthTracker::Slip& slip : mFrameSlips )
+        mTest.sendFrameSlip( slip );
+    mFrameSlips.clear();
+
+    // TEST_EXTENSION: a new rate is established on its SAMPLE_RATE_LOCK_FRAMES-th FRAME period, the restart is before its words.
+    SampleRateTracker::Segment rate_segment;
+    if( mSampleRates.frame( mDataValidEdges.front(), mDataValidEdges.back() - mDataValidEdges.front(), num_bits, mRateChanges,
+                            rate_segment ) )
+    {
+        mRateSegments.push_back( rate_segment );
+        StartRateSegment();
+    }
+
+    // the first record of the frame also holds its first bit, the replay checks the edges up to there before it takes anything.
+    mCacheFrameStartPending = true;
+
     U32 num_frames = 0;
-    switch( mSettings->mFrameType )
+    switch( mFormat.mFrameType )
     {
     case FRAME_TRANSITION_TWICE_EVERY_WORD:
         num_frames = 1;
@@ -78,15 +253,13 @@ void I2sTestalyser::AnalyzeFrame()
         frame.mFlags = DISPLAY_AS_ERROR_FLAG;
         frame.mStartingSampleInclusive = mDataValidEdges.front();
         frame.mEndingSampleInclusive = mDataValidEdges.back();
-        mResults->AddFrame( frame );
-        FrameV2 frame_v2;
-        frame_v2.AddString( "error", "invalid number of bits" );
-        mResults->AddFrameV2( frame_v2, "error", frame.mStartingSampleInclusive, frame.mEndingSampleInclusive );
+        AddResultCacheRecord( ResultCache::RECORD_FRAME_ERROR, frame, 0, mDataValidTransitions.back() );
+        ReportError( frame, 0, 0 );
         return;
     }
 
     U32 bits_per_frame = num_bits / num_frames;
-    U32 num_audio_bits = mSettings->mBitsPerWord;
+    U32 num_audio_bits = mFormat.mBitsPerWord;
 
     if( bits_per_frame < num_audio_bits )
     {
@@ -96,17 +269,19 @@ void I2sTestalyser::AnalyzeFrame()
         frame.mFlags = DISPLAY_AS_ERROR_FLAG;
         frame.mStartingSampleInclusive = mDataValidEdges.front();
         frame.mEndingSampleInclusive = mDataValidEdges.back();
-        mResults->AddFrame( frame );
-        FrameV2 frame_v2;
-        frame_v2.AddString( "error", "not enough bits" );
-        mResults->AddFrameV2( frame_v2, "error", frame.mStartingSampleInclusive, frame.mEndingSampleInclusive );
+        AddResultCacheRecord( ResultCache::RECORD_FRAME_ERROR, frame, 0, mDataValidTransitions.back() );
+        ReportError( frame, 0, 0 );
         return;
     }
 
+    // TEST_EXTENSION
+    if( mTest.startupEnabled() && mTest.startupValidFrame( mDataValidEdges.front(), mStartupCycle ) )
+        mStartupReportPending = true;
+
     U32 num_unused_bits = bits_per_frame - num_audio_bits;
     U32 starting_offset;
 
-    if( mSettings->mWordAlignment == LEFT_ALIGNED )
+    if( mFormat.mWordAlignment == LEFT_ALIGNED )
         starting_offset = 0;
     else
         starting_offset = num_unused_bits;
@@ -115,6 +290,13 @@ void I2sTestalyser::AnalyzeFrame()
     {
         AnalyzeSubFrame( i * bits_per_frame + starting_offset, num_audio_bits, i );
     }
+
+    // TEST_EXTENSION
+    if( mStartupReportPending )
+    {
+        mStartupReportPending = false;
+        AddStartupFrame( mStartupCycle, mDataValidEdges.back() );
+    }
 }
 
 void I2sTestalyser::AnalyzeSubFrame( U32 starting_index, U32 num_bits, U32 subframe_index )
@@ -122,7 +304,7 @@ void I2sTestalyser::AnalyzeSubFrame( U32 starting_index, U32 num_bits, U32 subfr
     U64 result = 0;
     U32 target_count = starting_index + num_bits;
 
-    if( mSettings->mShiftOrder == AnalyzerEnums::LsbFirst )
+    if( mFormat.mShiftOrder == AnalyzerEnums::LsbFirst )
     {
         U64 bit_value = 1ULL;
         for( U32 i = starting_index; i < target_count; i++ )
@@ -145,23 +327,110 @@ void I2sTestalyser::AnalyzeSubFrame( U32 starting_index, U32 num_bits, U32 subfr
         }
     }
 
+    Frame word;
+    word.mType = U8( subframe_index );
+    word.mData1 = result;
+    word.mStartingSampleInclusive = mDataValidEdges[ starting_index ];
+    word.mEndingSampleInclusive = mDataValidEdges[ target_count - 1 ];
+    AddResultCacheRecord( ResultCache::RECORD_WORD, word, subframe_index, mDataValidTransitions[ target_count - 1 ] );
+
+    ProcessWord( result, word.mStartingSampleInclusive, word.mEndingSampleInclusive, subframe_index );
+
+    // TEST_EXTENSION
+    if( subframe_index == mFormat.GetChannel1Subframe() && mTest.latencyEnabled() )
+        ProcessLatency( result, starting_index, num_bits );
+}
+
+U64 I2sTestalyser::ReadOutputWord( U32 starting_index, U32 num_bits )
+{
+    // the output DATA shares CLOCK and FRAME, so its bits are at the same data valid edges.
+    U64 result = 0;
+    for( U32 i = 0; i < num_bits; i++ )
+    {
+        mOutputData->AdvanceToAbsPosition( mDataValidEdges[ starting_index + i ] );
+        if( mOutputData->GetBitState() == BIT_HIGH )
+            result |= 1ULL << ( mFormat.mShiftOrder == AnalyzerEnums::LsbFirst ? i : num_bits - 1 - i );
+    }
+    return result;
+}
+
+void I2sTestalyser::ProcessLatency( U64 result, U32 starting_index, U32 num_bits )
+{
+    // the Channel 1 word of every frame is the marker, on both streams.
+    U64 ending_sample = mDataValidEdges[ starting_index + num_bits - 1 ];
+    mTest.processLatencyInput( result, ending_sample );
+
+    mOutputWords.clear();
+    if( mOutputClock == NULL )
+    {
+        U64 value = ReadOutputWord( starting_index, num_bits );
+        OutputStreamDecoder::Word word = { value, ending_sample, mFormat.GetChannel1Subframe() };
+        mOutputWords.push_back( word );
+    }
+    else
+    {
+        mOutputDecoder.decodeUntil( ending_sample, mOutputWords );
+    }
+
+    LoopbackLatency::Summary summary;
+    for( const OutputStreamDecoder::Word& word : mOutputWords )
+    {
+        if( word.mSubframe == mFormat.GetChannel1Subframe() && mTest.processLatencyOutput( word.mValue, word.mEndingSample, summary ) )
+            AddLatencyFrame( summary, ending_sample );
+    }
+}
+
+void I2sTestalyser::AddLatencyFrame( const LoopbackLatency::Summary& summary, U64 sample_number )
+{
+    double ns_per_sample = 1e9 / double( GetSampleRate() );
+    FrameV2 frame_v2;
+    frame_v2.AddInteger( "latency_samples", summary.mLatency );
+    frame_v2.AddDouble( "latency_ns", double( summary.mLatency ) * ns_per_sample );
+    frame_v2.AddDouble( "latency_frames", summary.mFramePeriod > 0.0 ? double( summary.mLatency ) / summary.mFramePeriod : 0.0 );
+    frame_v2.AddDouble( "min_ns", double( summary.mMin ) * ns_per_sample );
+    frame_v2.AddDouble( "max_ns", double( summary.mMax ) * ns_per_sample );
+    frame_v2.AddDouble( "mean_ns", summary.mMean * ns_per_sample );
+    frame_v2.AddDouble( "jitter_ns", summary.mJitter * ns_per_sample );
+    frame_v2.AddDouble( "total_min_ns", double( summary.mTotalMin ) * ns_per_sample );
+    frame_v2.AddDouble( "total_max_ns", double( summary.mTotalMax ) * ns_per_sample );
+    frame_v2.AddInteger( "matches", summary.mMatches );
+    frame_v2.AddInteger( "unmatched", summary.mUnmatched );
+    frame_v2.AddInteger( "first_sample", summary.mFirstSample );
+
+    // enum I2sResultType { ..., LatencyReport }: mData1 is the last latency, mData2 its peak to peak over the report, in samples.
+    AddReportFrame( LatencyReport, 0, summary.mLatency, summary.mMax - summary.mMin, sample_number, frame_v2, "latency" );
+}
+
+void I2sTestalyser::ProcessWord( U64 result, U64 starting_sample, U64 ending_sample, U32 subframe_index )
+{
     // TEST_EXTENSION
     if(mSettings->mTestSettings.mTestMode == TestMode::TEST_CONTIGUOUS)
     {
-        if(mTest.process(mSettings->mTestSettings, subframe_index & 0x0001, result))
+        U32 channel = subframe_index & 0x0001;
+        if(mTest.process(mSettings->mTestSettings, channel, result))
         {
             Frame frame;
             frame.mType = U8( TestError );
             frame.mFlags = DISPLAY_AS_ERROR_FLAG;
-            frame.mStartingSampleInclusive = mDataValidEdges[ starting_index ];
-            frame.mEndingSampleInclusive = mDataValidEdges[ starting_index + num_bits - 1 ];
-            mResults->AddFrame( frame );
-            FrameV2 frame_v2;
-            frame_v2.AddString( "error", "Not contiguous!" );
-            mResults->AddFrameV2( frame_v2, "error", frame.mStartingSampleInclusive, frame.mEndingSampleInclusive );
-            return;
+            frame.mData1 = result;
+            frame.mData2 = mTest.lastExpected();
+            frame.mStartingSampleInclusive = starting_sample;
+            frame.mEndingSampleInclusive = ending_sample;
+            ReportError( frame, channel, mTest.lastSlip() );
         }
     }
+    else if( mSettings->mTestSettings.mTestMode == TestMode::TEST_REFERENCE )
+    {
+        ProcessReference( result, starting_sample, ending_sample, subframe_index );
+    }
+    else if( mSettings->mTestSettings.mTestMode == TestMode::TEST_LOCKSTEP )
+    {
+        ProcessLockStep( result, starting_sample, ending_sample, subframe_index );
+    }
+    else if( mSettings->mTestSettings.mTestMode == TestMode::TEST_SEQUENCE )
+    {
+        ProcessSequence( result, starting_sample, ending_sample, subframe_index );
+    }
     else
     {
         // enum I2sResultType { Channel1, Channel2, ErrorTooFewBits, ErrorDoesntDivideEvenly };
@@ -170,7 +439,7 @@ void I2sTestalyser::AnalyzeSubFrame( U32 starting_index, U32 num_bits, U32 subfr
         frame.mData1 = result;
 
         U32 channel_1_polarity = 1;
-        if( mSettings->mWordSelectInverted == WS_INVERTED )
+        if( mFormat.mWordSelectInverted == WS_INVERTED )
             channel_1_polarity = 0;
 
         if( ( subframe_index & 0x1 ) == channel_1_polarity )
@@ -179,158 +448,1586 @@ void I2sTestalyser::AnalyzeSubFrame( U32 starting_index, U32 num_bits, U32 subfr
             frame.mType = U8( Channel2 );
 
         frame.mFlags = 0;
-        frame.mStartingSampleInclusive = mDataValidEdges[ starting_index ];
-        frame.mEndingSampleInclusive = mDataValidEdges[ starting_index + num_bits - 1 ];
+        frame.mStartingSampleInclusive = starting_sample;
+        frame.mEndingSampleInclusive = ending_sample;
 
-        mResults->AddFrame( frame );
         FrameV2 frame_v2;
         frame_v2.AddInteger( "channel", frame.mType );
         S64 adjusted_value = result;
         if( mSettings->mSigned == AnalyzerEnums::SignedInteger )
         {
-            adjusted_value = AnalyzerHelpers::ConvertToSignedNumber( frame.mData1, mSettings->mBitsPerWord );
+            adjusted_value = AnalyzerHelpers::ConvertToSignedNumber( frame.mData1, mFormat.mBitsPerWord );
         }
         frame_v2.AddInteger( "data", adjusted_value );
-        mResults->AddFrameV2( frame_v2, "data", frame.mStartingSampleInclusive, frame.mEndingSampleInclusive );
+        AddOrderedFrame( frame, frame_v2, "data" );
+    }
+
+    // TEST_EXTENSION: the first word the test passes in a power cycle, reported at the end of the frame.
+    if( mTest.takeTestPassed() && mTest.startupEnabled() && mTest.startupTestPass( ending_sample, mStartupCycle ) )
+        mStartupReportPending = true;
+
+    // TEST_EXTENSION: the audio analysis and level statistics see the word centred on zero, unsigned words are treated as offset
+    // binary.
+    if( !mTest.audioAnalysisEnabled() && !mTest.levelStatisticsEnabled() )
+        return;
+    S64 centred;
+    if( mSettings->mSigned == AnalyzerEnums::SignedInteger )
+        centred = AnalyzerHelpers::ConvertToSignedNumber( result, mFormat.mBitsPerWord );
+    else
+        centred = S64( result - ( U64( 1 ) << ( mFormat.mBitsPerWord - 1 ) ) );
+
+    if( mTest.audioAnalysisEnabled() )
+    {
+        // normalise to -1.0 .. 1.0.
+        double value = double( centred ) / ldexp( 1.0, mFormat.mBitsPerWord - 1 );
+
+        AudioQualityAnalysis::Result quality;
+        if( mTest.processAudio( subframe_index, value, starting_sample, quality ) )
+            AddAudioQualityFrame( quality, ending_sample );
     }
 
+    if( mTest.levelStatisticsEnabled() )
+    {
+        mLevelWordsSinceTotals++;
+        LevelStatistics::Summary block;
+        if( mTest.processLevel( subframe_index, centred, starting_sample, block ) )
+            AddLevelFrame( block, "block", ending_sample );
+    }
 }
 
-void I2sTestalyser::SetupForGettingFirstFrame()
+void I2sTestalyser::ProcessReference( U64 result, U64 starting_sample, U64 ending_sample, U32 subframe_index )
 {
-    GetNextBit( mLastData, mLastFrame, mLastSample ); // we have to throw away one bit to get enough history on the FRAME line.
+    if( !mTest.referenceEnabled() )
+        return;
 
-    for( ;; )
-    {
-        GetNextBit( mCurrentData, mCurrentFrame, mCurrentSample );
+    // reference channel 0 is the Channel 1 word, so rotate the subframes to keep the reference channels in the order the words are
+    // on the wire.
+    U32 channel_count = mFormat.GetChannelsCount();
+    U32 reference_channel = ( subframe_index + channel_count - mFormat.GetChannel1Subframe() ) % channel_count;
 
-        if( mCurrentFrame == BIT_HIGH && mLastFrame == BIT_LOW )
+    // events can be about frames a little way back, they are added here so the frames stay in order.
+    mReferenceEvents.clear();
+    mTest.processReference( reference_channel, result, starting_sample, mReferenceEvents );
+    for( const ReferenceCompare::Event& event : mReferenceEvents )
+    {
+        if( event.mKind != ReferenceCompare::EVENT_MISMATCH )
         {
-            if( mSettings->mBitAlignment == BITS_SHIFTED_RIGHT_1 )
-            {
-                // we need to advance to the next bit past the frame.
-                mLastFrame = mCurrentFrame;
-                mLastData = mCurrentData;
-                mLastSample = mCurrentSample;
-
-                GetNextBit( mCurrentData, mCurrentFrame, mCurrentSample );
-            }
-            return;
+            AddReferenceFrame( event, ending_sample );
+            continue;
         }
 
-        mLastFrame = mCurrentFrame;
-        mLastData = mCurrentData;
-        mLastSample = mCurrentSample;
+        Frame frame;
+        frame.mType = U8( TestError );
+        frame.mFlags = DISPLAY_AS_ERROR_FLAG;
+        frame.mData1 = event.mReceived;
+        frame.mData2 = event.mExpected;
+        frame.mStartingSampleInclusive = starting_sample;
+        frame.mEndingSampleInclusive = ending_sample;
+        ReportError( frame, event.mChannel, mTest.recordMismatch( event.mChannel, event.mExpected, event.mReceived ) );
     }
 }
 
-void I2sTestalyser::GetFrame()
+void I2sTestalyser::AddReferenceFrame( const ReferenceCompare::Event& event, U64 sample_number )
 {
-    // on entering this function:
-    // mCurrentFrame and mCurrentData are the values of the first bit -- that belongs to us -- in the frame.
-    // mLastFrame and mLastData are the values from the bit just before.
+    static const char* kinds[] = { "locked", "mismatch", "drop", "repeat", "lock lost", "reference end", "error" };
 
-    mDataBits.clear();
-    mDataValidEdges.clear();
+    FrameV2 frame_v2;
+    frame_v2.AddString( "kind", kinds[ event.mKind ] );
+    if( event.mKind == ReferenceCompare::EVENT_ERROR )
+    {
+        frame_v2.AddString( "error", mTest.referenceError().c_str() );
+    }
+    else
+    {
+        const ReferenceCompare::Totals& totals = mTest.referenceTotals();
+        frame_v2.AddInteger( "position", event.mPosition );
+        frame_v2.AddInteger( "frames", event.mFrames );
+        frame_v2.AddInteger( "first_sample", event.mFirstSample );
+        frame_v2.AddInteger( "compared", totals.mFrames );
+        U64 mismatches = 0;
+        for( U32 channel = 0; channel < REFERENCE_MAX_CHANNELS; channel++ )
+            mismatches += totals.mMismatches[ channel ];
+        frame_v2.AddInteger( "mismatches", mismatches );
+        frame_v2.AddInteger( "dropped", totals.mDropped );
+        frame_v2.AddInteger( "repeated", totals.mRepeated );
+        frame_v2.AddInteger( "lock_losses", totals.mLockLosses );
+    }
 
+    // enum I2sResultType { ..., ReferenceEvent }: mData1 is the reference frame, mData2 the kind and the frames dropped or repeated.
+    U8 flags = ( event.mKind == ReferenceCompare::EVENT_LOCKED || event.mKind == ReferenceCompare::EVENT_REFERENCE_END )
+                   ? 0
+                   : ( event.mKind == ReferenceCompare::EVENT_ERROR ? DISPLAY_AS_WARNING_FLAG : DISPLAY_AS_ERROR_FLAG );
+    AddReportFrame( ReferenceEvent, flags, event.mPosition, ( U64( event.mKind ) << 32 ) | ( event.mFrames & 0xFFFFFFFF ), sample_number,
+                    frame_v2, "reference" );
+}
 
-    mDataBits.push_back( mCurrentData );
-    mDataValidEdges.push_back( mCurrentSample );
+void I2sTestalyser::ProcessLockStep( U64 result, U64 starting_sample, U64 ending_sample, U32 subframe_index )
+{
+    if( !mTest.lockStepEnabled() )
+        return;
 
-    mLastFrame = mCurrentFrame;
-    mLastData = mCurrentData;
-    mLastSample = mCurrentSample;
+    // channel 0 is the Channel 1 word, as for the reference test.
+    U32 channel_count = mFormat.GetChannelsCount();
+    U32 channel = ( subframe_index + channel_count - mFormat.GetChannel1Subframe() ) % channel_count;
 
-    for( ;; )
+    mLockStepEvents.clear();
+    mLockStepMismatches.clear();
+    mTest.processLockStep( channel, result, starting_sample, mLockStepEvents, mLockStepMismatches );
+    for( const LockStepCheck::Event& event : mLockStepEvents )
+        AddLockStepFrame( event, ending_sample );
+
+    // the frame is complete with this word, the mismatches are marked on it.
+    for( const LockStepCheck::Mismatch& mismatch : mLockStepMismatches )
     {
-        GetNextBit( mCurrentData, mCurrentFrame, mCurrentSample );
+        Frame frame;
+        frame.mType = U8( TestError );
+        frame.mFlags = DISPLAY_AS_ERROR_FLAG;
+        frame.mData1 = mismatch.mReceived;
+        frame.mData2 = mismatch.mExpected;
+        frame.mStartingSampleInclusive = starting_sample;
+        frame.mEndingSampleInclusive = ending_sample;
+        ReportError( frame, mismatch.mChannel, mTest.recordMismatch( mismatch.mChannel, mismatch.mExpected, mismatch.mReceived ) );
+    }
+}
 
-        if( mCurrentFrame == BIT_HIGH && mLastFrame == BIT_LOW )
-        {
-            if( mSettings->mBitAlignment == BITS_SHIFTED_RIGHT_1 )
-            {
-                // this bit belongs to us:
-                mDataBits.push_back( mCurrentData );
-                mDataValidEdges.push_back( mCurrentSample );
+void I2sTestalyser::AddLockStepFrame( const LockStepCheck::Event& event, U64 sample_number )
+{
+    static const char* states[] = { "in step", "skewed", "swapped", "mismatch" };
 
-                // we need to advance to the next bit past the frame.
-                mLastFrame = mCurrentFrame;
-                mLastData = mCurrentData;
-                mLastSample = mCurrentSample;
+    FrameV2 frame_v2;
+    frame_v2.AddInteger( "channel", event.mChannel );
+    frame_v2.AddString( "state", states[ event.mState ] );
+    if( event.mState == LockStepCheck::STATE_SKEWED )
+        frame_v2.AddInteger( "skew", event.mValue );
+    if( event.mState == LockStepCheck::STATE_SWAPPED )
+        frame_v2.AddInteger( "carries", event.mValue );
+    frame_v2.AddString( "previous_state", states[ event.mPreviousState ] );
+    frame_v2.AddInteger( "previous_frames", event.mFrames );
+    frame_v2.AddInteger( "first_sample", event.mFirstSample );
 
-                GetNextBit( mCurrentData, mCurrentFrame, mCurrentSample );
-            }
+    // enum I2sResultType { ..., LockStepEvent }: mData1 is the channel above the state, mData2 the skew or the channel carried.
+    AddReportFrame( LockStepEvent, event.mState == LockStepCheck::STATE_IN_STEP ? 0 : DISPLAY_AS_ERROR_FLAG,
+                    ( U64( event.mChannel ) << 32 ) | U32( event.mState ), U64( event.mValue ), sample_number, frame_v2, "lockstep" );
+}
 
-            return;
-        }
+void I2sTestalyser::ProcessSequence( U64 result, U64 starting_sample, U64 ending_sample, U32 subframe_index )
+{
+    if( !mTest.sequenceEnabled() )
+        return;
 
-        mDataBits.push_back( mCurrentData );
-        mDataValidEdges.push_back( mCurrentSample );
+    // channel 0, the Channel 1 word, carries the sequence number and CRC.
+    U32 channel_count = mFormat.GetChannelsCount();
+    U32 channel = ( subframe_index + channel_count - mFormat.GetChannel1Subframe() ) % channel_count;
 
-        mLastFrame = mCurrentFrame;
-        mLastData = mCurrentData;
-        mLastSample = mCurrentSample;
+    mSequenceEvents.clear();
+    mTest.processSequence( channel, result, starting_sample, mSequenceEvents );
+    for( const SequenceCheck::Event& event : mSequenceEvents )
+    {
+        if( event.mKind != SequenceCheck::KIND_CORRUPTION )
+        {
+            AddSequenceFrame( event, ending_sample );
+            continue;
+        }
+
+        // the frame is complete with this word, the corruption is marked on it against the channel 0 word.
+        Frame frame;
+        frame.mType = U8( TestError );
+        frame.mFlags = DISPLAY_AS_ERROR_FLAG;
+        frame.mData1 = event.mReceived;
+        frame.mData2 = event.mHeader;
+        frame.mStartingSampleInclusive = starting_sample;
+        frame.mEndingSampleInclusive = ending_sample;
+        ReportError( frame, 0, mTest.recordMismatch( 0, event.mHeader, event.mReceived ) );
     }
 }
 
-void I2sTestalyser::SetupForGettingFirstBit()
+void I2sTestalyser::AddSequenceFrame( const SequenceCheck::Event& event, U64 sample_number )
 {
-    if( mSettings->mDataValidEdge == AnalyzerEnums::PosEdge )
+    static const char* kinds[] = { "drop", "duplicate", "reorder", "corruption", "error" };
+
+    FrameV2 frame_v2;
+    frame_v2.AddString( "kind", kinds[ event.mKind ] );
+    if( event.mKind == SequenceCheck::KIND_ERROR )
     {
-        // we want to start out low, so the next time we advance, it'll be a rising edge.
-        if( mClock->GetBitState() == BIT_HIGH )
-            mClock->AdvanceToNextEdge(); // now we're low.
+        frame_v2.AddString( "error", "words are too narrow for the sequence test, it needs 12 or more bits" );
     }
     else
     {
-        // we want to start out low, so the next time we advance, it'll be a falling edge.
-        if( mClock->GetBitState() == BIT_LOW )
-            mClock->AdvanceToNextEdge(); // now we're high.
+        const SequenceCheck::Totals& totals = mTest.sequenceTotals();
+        frame_v2.AddInteger( "sequence", event.mSequence );
+        frame_v2.AddInteger( "expected", event.mExpected );
+        frame_v2.AddInteger( "frames", event.mFrames );
+        frame_v2.AddInteger( "first_sample", event.mFirstSample );
+        frame_v2.AddInteger( "checked", totals.mFrames );
+        frame_v2.AddInteger( "dropped", totals.mCounts[ SequenceCheck::KIND_DROP ] );
+        frame_v2.AddInteger( "duplicated", totals.mCounts[ SequenceCheck::KIND_DUPLICATE ] );
+        frame_v2.AddInteger( "reordered", totals.mCounts[ SequenceCheck::KIND_REORDER ] );
+        frame_v2.AddInteger( "corrupted", totals.mCounts[ SequenceCheck::KIND_CORRUPTION ] );
     }
+
+    // enum I2sResultType { ..., SequenceEvent }: mData1 is the sequence number, mData2 the kind above the frames dropped or late.
+    AddReportFrame( SequenceEvent, event.mKind == SequenceCheck::KIND_ERROR ? DISPLAY_AS_WARNING_FLAG : DISPLAY_AS_ERROR_FLAG,
+                    event.mSequence, ( U64( event.mKind ) << 32 ) | ( event.mFrames & 0xFFFFFFFF ), sample_number, frame_v2, "sequence" );
 }
 
-void I2sTestalyser::GetNextBit( BitState& data, BitState& frame, U64& sample_number )
+void I2sTestalyser::AddStartupFrame( const StartupTiming::Cycle& cycle, U64 sample_number )
 {
-    // we always start off here so that the next edge is where the data is valid.
-    mClock->AdvanceToNextEdge();
-    U64 data_valid_sample = mClock->GetSampleNumber();
+    static const char* milestones[] = { "clock", "frame_edge", "valid_frame", "test_pass" };
 
-    mData->AdvanceToAbsPosition( data_valid_sample );
-    data = mData->GetBitState();
+    // the last milestone reached, all of them once the cycle is complete.
+    U32 reached = StartupTiming::MILESTONE_CLOCK;
+    for( U32 milestone = 0; milestone < StartupTiming::MILESTONE_COUNT; milestone++ )
+    {
+        if( cycle.mSamples[ milestone ] != STARTUP_NOT_REACHED )
+            reached = milestone;
+    }
+    U64 first_clock = cycle.mSamples[ StartupTiming::MILESTONE_CLOCK ];
 
-    mFrame->AdvanceToAbsPosition( data_valid_sample );
-    frame = mFrame->GetBitState();
+    // the CLOCK is timed from the anchor, the other milestones from the first CLOCK edge.
+    double ms_per_sample = 1000.0 / double( GetSampleRate() );
+    FrameV2 frame_v2;
+    frame_v2.AddInteger( "cycle", cycle.mIndex );
+    frame_v2.AddBoolean( "complete", cycle.mComplete );
+    frame_v2.AddInteger( "anchor_sample", cycle.mAnchor );
+    frame_v2.AddDouble( "clock_ms", double( first_clock - cycle.mAnchor ) * ms_per_sample );
+    frame_v2.AddInteger( "clock_sample", first_clock );
+    for( U32 milestone = StartupTiming::MILESTONE_FRAME_EDGE; milestone < StartupTiming::MILESTONE_COUNT; milestone++ )
+    {
+        if( cycle.mSamples[ milestone ] == STARTUP_NOT_REACHED )
+            continue;
+        std::string name = milestones[ milestone ];
+        frame_v2.AddDouble( ( name + "_ms" ).c_str(), double( cycle.mSamples[ milestone ] - first_clock ) * ms_per_sample );
+        frame_v2.AddInteger( ( name + "_sample" ).c_str(), cycle.mSamples[ milestone ] );
+    }
 
-    sample_number = data_valid_sample;
+    // enum I2sResultType { ..., StartupReport }: mData1 is the time to the last milestone reached, mData2 the cycle above the
+    // complete flag.
+    AddReportFrame( StartupReport, cycle.mComplete ? 0 : DISPLAY_AS_WARNING_FLAG, cycle.mSamples[ reached ] - first_clock,
+                    ( U64( cycle.mIndex ) << 32 ) | ( cycle.mComplete ? 1 : 0 ), sample_number, frame_v2, "startup" );
+}
 
-    mResults->AddMarker( data_valid_sample, mArrowMarker, mSettings->mClockChannel );
+void I2sTestalyser::AddClockRecoveryFrames( U64 sample_number )
+{
+    for( const ClockRecovery::Report& report : mRecoveryReports )
+    {
+        mTest.sendClockRecovery( report );
 
-    mClock->AdvanceToNextEdge(); // advance one more, so we're ready for next this function is called.
+        double ns_per_sample = 1e9 / double( GetSampleRate() );
+        double bit_rate = report.mBitPeriod > 0.0 ? double( GetSampleRate() ) / report.mBitPeriod : 0.0;
 
-    // TEST_EXTENSION
-    mTest.setDataValidEdge(data_valid_sample);
-    mTest.setDataTransitionEdge(mClock->GetSampleNumber());
+        const char* event = report.mLockChanged ? ( report.mLocked ? "locked" : "lock lost" ) : "report";
+        FrameV2 frame_v2;
+        frame_v2.AddString( "event", event );
+        frame_v2.AddBoolean( "locked", report.mLocked );
+        frame_v2.AddDouble( "bit_rate_hz", bit_rate );
+        frame_v2.AddDouble( "bit_period_ns", report.mBitPeriod * ns_per_sample );
+        frame_v2.AddDouble( "jitter_rms_ns", report.mJitterRms * ns_per_sample );
+        frame_v2.AddDouble( "jitter_pp_ns", report.mJitterPeakToPeak * ns_per_sample );
+        frame_v2.AddInteger( "frames", report.mFrames );
+        frame_v2.AddInteger( "bad_frames", report.mBadFrames );
+        frame_v2.AddInteger( "edges", report.mEdges );
+        frame_v2.AddInteger( "first_sample", report.mFirstSample );
+        frame_v2.AddInteger( "last_sample", report.mLastSample );
+
+        // enum I2sResultType { ..., ClockRecoveryReport }: mData1 is the recovered bit rate in Hz, mData2 the rms jitter in ps.
+        AddReportFrame( ClockRecoveryReport, report.mLocked ? 0 : DISPLAY_AS_WARNING_FLAG, U64( bit_rate + 0.5 ),
+                        U64( report.mJitterRms * ns_per_sample * 1000.0 + 0.5 ), sample_number, frame_v2, "clock_recovery" );
+    }
+    mRecoveryReports.clear();
 }
 
-U32 I2sTestalyser::GenerateSimulationData( U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels )
+void I2sTestalyser::MonitorClockTree( U64 frame_edge, U64 bclk_edge, U64 limit )
 {
-    if( mSimulationInitilized == false )
+    // the first MCLK rising edge after the FRAME edge. MCLK is only walked up to a bit past the FRAME edge, so a stopped MCLK
+    // can't hold up the decode.
+    if( frame_edge > mMasterClock->GetSampleNumber() )
+        mMasterClockTransitions += mMasterClock->AdvanceToAbsPosition( frame_edge );
+    if( mMasterClock->GetBitState() == BIT_HIGH && mMasterClock->WouldAdvancingToAbsPositionCauseTransition( limit ) )
     {
-        mSimulationDataGenerator.Initialize( GetSimulationSampleRate(), mSettings.get() );
-        mSimulationInitilized = true;
+        mMasterClock->AdvanceToNextEdge();
+        mMasterClockTransitions++;
     }
+    U64 mclk_edge = 0;
+    if( mMasterClock->GetBitState() == BIT_LOW && mMasterClock->WouldAdvancingToAbsPositionCauseTransition( limit ) )
+        mclk_edge = mMasterClock->GetSampleOfNextEdge();
 
-    return mSimulationDataGenerator.GenerateSimulationData( newest_sample_requested, sample_rate, simulation_channels );
+    ClockTreeMonitor::Report report;
+    if( mClockTree.frameEdge( frame_edge, bclk_edge, mclk_edge, mMasterClockTransitions, mClockTreeBits, mClockTreeEvents, report ) )
+        mClockTreeReports.push_back( report );
+    mClockTreeBits = 0;
 }
 
-U32 I2sTestalyser::GetMinimumSampleRateHz()
+void I2sTestalyser::AddClockTreeFrames( U64 sample_number )
 {
-    return 4000000; // just enough for our simulation.  Ideally we would be smarter about this but we don't know the bit rate in advance.
+    static const char* kinds[] = { "mclk_ratio", "clock_ratio", "mclk_phase", "clock_phase" };
+
+    for( const ClockTreeMonitor::Event& event : mClockTreeEvents )
+    {
+        mTest.sendClockTreeEvent( event );
+
+        bool ratio = event.mKind == ClockTreeMonitor::KIND_MCLK_RATIO || event.mKind == ClockTreeMonitor::KIND_BCLK_RATIO;
+        double scale = ratio ? 1.0 : 1e6;
+
+        FrameV2 frame_v2;
+        frame_v2.AddString( "event", kinds[ event.mKind ] );
+        frame_v2.AddDouble( "previous", event.mPrevious );
+        frame_v2.AddDouble( "current", event.mCurrent );
+        frame_v2.AddInteger( "sample", event.mSample );
+
+        // enum I2sResultType { ..., ClockTreeEvent }: mData1 is the kind, mData2 the previous above the current count, or phase in
+        // millionths of a period.
+        AddReportFrame( ClockTreeEvent, DISPLAY_AS_ERROR_FLAG, event.mKind,
+                        ( U64( U32( event.mPrevious * scale + 0.5 ) ) << 32 ) | U32( event.mCurrent * scale + 0.5 ), sample_number,
+                        frame_v2, "clock_tree_event" );
+    }
+    mClockTreeEvents.clear();
+
+    for( const ClockTreeMonitor::Report& report : mClockTreeReports )
+    {
+        mTest.sendClockTreeReport( report );
+
+        FrameV2 frame_v2;
+        frame_v2.AddInteger( "frames", report.mFrames );
+        frame_v2.AddInteger( "mclk_per_frame", report.mMclkPerFrame );
+        frame_v2.AddInteger( "clock_per_frame", report.mBclkPerFrame );
+        if( report.mBclkPerFrame != 0 )
+            frame_v2.AddDouble( "mclk_per_clock", double( report.mMclkPerFrame ) / double( report.mBclkPerFrame ) );
+        frame_v2.AddInteger( "ratio_changes", report.mRatioChanges );
+        frame_v2.AddInteger( "phase_slips", report.mPhaseSlips );
+        const char* phase_names[] = { "mclk_phase", "clock_phase" };
+        const ClockTreeMonitor::PhaseStatistics* phases[] = { &report.mMclkPhase, &report.mBclkPhase };
+        for( U32 i = 0; i < 2; i++ )
+        {
+            // a phase that wasn't measured has no fields.
+            if( phases[ i ]->mMean < 0.0 )
+                continue;
+            std::string name = phase_names[ i ];
+            frame_v2.AddDouble( name.c_str(), phases[ i ]->mMean );
+            frame_v2.AddDouble( ( name + "_rms" ).c_str(), phases[ i ]->mRms );
+            frame_v2.AddDouble( ( name + "_pp" ).c_str(), phases[ i ]->mPeakToPeak );
+        }
+        frame_v2.AddInteger( "first_sample", report.mFirstSample );
+        frame_v2.AddInteger( "last_sample", report.mLastSample );
+
+        // enum I2sResultType { ..., ClockTreeReport }: mData1 is the MCLK above the CLOCK periods per FRAME period, mData2 the ratio
+        // changes above the phase slips.
+        AddReportFrame( ClockTreeReport, ( report.mRatioChanges != 0 || report.mPhaseSlips != 0 ) ? DISPLAY_AS_WARNING_FLAG : 0,
+                        ( report.mMclkPerFrame << 32 ) | U32( report.mBclkPerFrame ),
+                        ( report.mRatioChanges << 32 ) | U32( report.mPhaseSlips ), sample_number, frame_v2, "clock_tree" );
+    }
+    mClockTreeReports.clear();
 }
 
-bool I2sTestalyser::NeedsRerun()
+void I2sTestalyser::AddJitterSpectrumFrames( U64 sample_number )
 {
-    return false;
+    for( const JitterSpectrum::Report& report : mJitterReports )
+    {
+        mTest.sendJitterSpectrum( report );
+
+        double ns_per_sample = 1e9 / double( GetSampleRate() );
+
+        FrameV2 frame_v2;
+        frame_v2.AddDouble( "bit_rate_hz", report.mBitPeriod > 0.0 ? double( GetSampleRate() ) / report.mBitPeriod : 0.0 );
+        frame_v2.AddDouble( "jitter_rms_ns", report.mRms * ns_per_sample );
+        for( U32 band = 0; band < JITTER_SPECTRUM_BANDS; band++ )
+        {
+            std::string name = std::string( "jitter_" ) + JitterSpectrum::bandName( band ) + "_ns";
+            frame_v2.AddDouble( name.c_str(), report.mBandRms[ band ] * ns_per_sample );
+        }
+        frame_v2.AddInteger( "spurs", report.mSpurCount );
+        for( U32 spur = 0; spur < report.mSpurCount; spur++ )
+        {
+            std::string name = "spur_" + std::to_string( spur + 1 );
+            frame_v2.AddDouble( ( name + "_hz" ).c_str(), report.mSpurs[ spur ].mFrequencyHz );
+            frame_v2.AddDouble( ( name + "_rms_ns" ).c_str(), report.mSpurs[ spur ].mRms * ns_per_sample );
+        }
+        frame_v2.AddInteger( "blocks", report.mBlocks );
+        frame_v2.AddInteger( "first_sample", report.mFirstSample );
+        frame_v2.AddInteger( "last_sample", report.mLastSample );
+
+        // enum I2sResultType { ..., JitterSpectrumReport }: mData1 is the rms jitter in ps, mData2 the frequency of the largest spur
+        // in Hz.
+        AddReportFrame( JitterSpectrumReport, report.mSpurCount != 0 ? DISPLAY_AS_WARNING_FLAG : 0,
+                        U64( report.mRms * ns_per_sample * 1000.0 + 0.5 ),
+                        report.mSpurCount != 0 ? U64( report.mSpurs[ 0 ].mFrequencyHz + 0.5 ) : 0, sample_number, frame_v2,
+                        "jitter_spectrum" );
+    }
+    mJitterReports.clear();
+}
+
+void I2sTestalyser::MeasureClockPulse()
+{
+    // the edge the CLOCK is at ends the pulse since the edge before it. A glitch pulse is marked at its end on CLOCK, the glitch
+    // frame follows once it is over.
+    U64 sample = mClock->GetSampleNumber();
+    ClockPulseMonitor::Report report;
+    if( mClockPulses.edge( sample, mClock->GetBitState() == BIT_HIGH, double( mBitPeriod ), mClockGlitches, report ) )
+        mClockPulseReports.push_back( report );
+    if( mClockPulses.inGlitch() )
+        mResults->AddMarker( sample, AnalyzerResults::ErrorX, mSettings->mClockChannel );
+}
+
+void I2sTestalyser::AddClockPulseFrames( U64 sample_number )
+{
+    double ns_per_sample = 1e9 / double( GetSampleRate() );
+
+    for( const ClockPulseMonitor::Glitch& glitch : mClockGlitches )
+    {
+        mTest.sendClockGlitch( glitch );
+
+        FrameV2 frame_v2;
+        frame_v2.AddInteger( "pulses", glitch.mPulses );
+        frame_v2.AddDouble( "shortest_ns", double( glitch.mShortest ) * ns_per_sample );
+        frame_v2.AddString( "shortest_level", glitch.mShortestHigh ? "high" : "low" );
+        frame_v2.AddDouble( "duration_ns", double( glitch.mEndSample - glitch.mStartSample ) * ns_per_sample );
+        frame_v2.AddInteger( "start_sample", glitch.mStartSample );
+        frame_v2.AddInteger( "end_sample", glitch.mEndSample );
+
+        // enum I2sResultType { ..., ClockGlitch }: mData1 is the shortest pulse in ps, mData2 its level above the short pulses.
+        AddReportFrame( ClockGlitch, DISPLAY_AS_ERROR_FLAG, U64( double( glitch.mShortest ) * ns_per_sample * 1000.0 + 0.5 ),
+                        ( U64( glitch.mShortestHigh ) << 32 ) | glitch.mPulses, sample_number, frame_v2, "clock_glitch" );
+    }
+    mClockGlitches.clear();
+
+    for( const ClockPulseMonitor::Report& report : mClockPulseReports )
+    {
+        mTest.sendClockPulses( report );
+
+        FrameV2 frame_v2;
+        if( report.mDutyCycle >= 0.0 )
+        {
+            frame_v2.AddDouble( "duty_cycle", report.mDutyCycle );
+            frame_v2.AddDouble( "duty_cycle_min", report.mDutyMin );
+            frame_v2.AddDouble( "duty_cycle_max", report.mDutyMax );
+        }
+        const char* level_names[] = { "high", "low" };
+        const ClockPulseMonitor::PulseStatistics* levels[] = { &report.mHigh, &report.mLow };
+        for( U32 i = 0; i < 2; i++ )
+        {
+            // a level with no pulses has no fields.
+            if( levels[ i ]->mCount == 0 )
+                continue;
+            std::string name = level_names[ i ];
+            frame_v2.AddInteger( ( name + "_pulses" ).c_str(), levels[ i ]->mCount );
+            frame_v2.AddDouble( ( name + "_mean_ns" ).c_str(), levels[ i ]->mMean * ns_per_sample );
+            frame_v2.AddDouble( ( name + "_min_ns" ).c_str(), double( levels[ i ]->mMin ) * ns_per_sample );
+            frame_v2.AddDouble( ( name + "_max_ns" ).c_str(), double( levels[ i ]->mMax ) * ns_per_sample );
+        }
+        frame_v2.AddInteger( "glitches", report.mGlitches );
+        frame_v2.AddInteger( "glitch_pulses", report.mGlitchPulses );
+        frame_v2.AddInteger( "first_sample", report.mFirstSample );
+        frame_v2.AddInteger( "last_sample", report.mLastSample );
+
+        // enum I2sResultType { ..., ClockPulseReport }: mData1 is the duty cycle in millionths, mData2 the glitches.
+        AddReportFrame( ClockPulseReport, report.mGlitches != 0 ? DISPLAY_AS_WARNING_FLAG : 0,
+                        report.mDutyCycle >= 0.0 ? U64( report.mDutyCycle * 1e6 + 0.5 ) : 0, report.mGlitches, sample_number, frame_v2,
+                        "clock_pulses" );
+    }
+    mClockPulseReports.clear();
+}
+
+void I2sTestalyser::AddFrameLengthFrames( U64 sample_number )
+{
+    for( const FrameLengthTracker::Report& report : mFrameLengthReports )
+    {
+        mTest.sendFrameLengths( report );
+
+        // "4095 x 64, 1 x 63, 4000 x 64" and "64: 8095, 63: 1".
+        std::string runs;
+        for( const FrameLengthTracker::Run& run : report.mRuns )
+            runs += ( runs.empty() ? "" : ", " ) + std::to_string( run.mFrames ) + " x " + std::to_string( run.mBits );
+        if( report.mRunsTruncated )
+            runs += ", ...";
+        std::string lengths;
+        for( const FrameLengthTracker::Run& length : report.mLengths )
+            lengths += ( lengths.empty() ? "" : ", " ) + std::to_string( length.mBits ) + ": " + std::to_string( length.mFrames );
+        if( report.mOtherFrames != 0 )
+            lengths += ", other: " + std::to_string( report.mOtherFrames );
+        std::string slips;
+        for( U64 slip_sample : report.mSlipSamples )
+            slips += ( slips.empty() ? "" : ", " ) + std::to_string( slip_sample );
+        if( report.mSlips > report.mSlipSamples.size() )
+            slips += ", ...";
+
+        FrameV2 frame_v2;
+        frame_v2.AddInteger( "frames", report.mFrames );
+        frame_v2.AddInteger( "nominal_bits", report.mNominal );
+        frame_v2.AddInteger( "slips", report.mSlips );
+        frame_v2.AddInteger( "total_slips", report.mTotalSlips );
+        frame_v2.AddString( "runs", runs.c_str() );
+        frame_v2.AddString( "lengths", lengths.c_str() );
+        frame_v2.AddString( "slip_samples", slips.c_str() );
+        frame_v2.AddInteger( "first_sample", report.mFirstSample );
+        frame_v2.AddInteger( "last_sample", report.mLastSample );
+
+        // enum I2sResultType { ..., FrameLengthReport }: mData1 is the established bit count, mData2 the slips.
+        AddReportFrame( FrameLengthReport, report.mSlips != 0 ? DISPLAY_AS_WARNING_FLAG : 0, report.mNominal, report.mSlips, sample_number,
+                        frame_v2, "frame_length" );
+    }
+    mFrameLengthReports.clear();
+}
+
+void I2sTestalyser::StartRateSegment()
+{
+    // TEST_EXTENSION: expected values and clock statistics of the old rate don't apply to the new one, as after a clock gap.
+    mTest.startSegment();
+    mClockTree.restart();
+    mJitter.restart();
+    mClockPulses.restart( mClockGlitches );
+    mClockTreeBits = 0;
+}
+
+void I2sTestalyser::AddSampleRateFrames( U64 sample_number )
+{
+    // the segment a change ends comes before the change.
+    for( const SampleRateTracker::Segment& segment : mRateSegments )
+    {
+        mTest.sendRateSegment( segment );
+
+        FrameV2 frame_v2;
+        frame_v2.AddInteger( "segment", segment.mIndex );
+        frame_v2.AddDouble( "rate_hz", segment.mRate );
+        frame_v2.AddDouble( "nominal_hz", segment.mNominal );
+        frame_v2.AddDouble( "ppm", segment.mPpm );
+        frame_v2.AddDouble( "min_rate_hz", segment.mMinRate );
+        frame_v2.AddDouble( "max_rate_hz", segment.mMaxRate );
+        frame_v2.AddInteger( "frames", segment.mFrames );
+        frame_v2.AddInteger( "off_rate_frames", segment.mOffRateFrames );
+        frame_v2.AddInteger( "errors", segment.mErrors );
+        frame_v2.AddInteger( "clock_gaps", segment.mClockGaps );
+        frame_v2.AddDouble( "duration", double( segment.mLastSample - segment.mFirstSample ) / double( GetSampleRate() ) );
+        frame_v2.AddInteger( "first_sample", segment.mFirstSample );
+        frame_v2.AddInteger( "last_sample", segment.mLastSample );
+
+        // enum I2sResultType { ..., SampleRateSegment }: mData1 is the segment, mData2 its rate in mHz.
+        AddReportFrame( SampleRateSegment, segment.mErrors != 0 ? DISPLAY_AS_WARNING_FLAG : 0, segment.mIndex,
+                        U64( segment.mRate * 1000.0 + 0.5 ), sample_number, frame_v2, "rate_segment" );
+    }
+    mRateSegments.clear();
+
+    for( const SampleRateTracker::Change& change : mRateChanges )
+    {
+        mTest.sendSampleRate( change );
+
+        FrameV2 frame_v2;
+        frame_v2.AddInteger( "segment", change.mSegment );
+        frame_v2.AddDouble( "rate_hz", change.mRate );
+        frame_v2.AddDouble( "nominal_hz", change.mNominal );
+        frame_v2.AddDouble( "previous_hz", change.mPrevious );
+        frame_v2.AddInteger( "sample", change.mSample );
+
+        // enum I2sResultType { ..., SampleRateChange }: mData1 is the new rate in mHz, mData2 the previous one.
+        AddReportFrame( SampleRateChange, change.mPrevious > 0.0 ? DISPLAY_AS_WARNING_FLAG : 0, U64( change.mRate * 1000.0 + 0.5 ),
+                        U64( change.mPrevious * 1000.0 + 0.5 ), sample_number, frame_v2, "sample_rate" );
+    }
+    mRateChanges.clear();
+}
+
+void I2sTestalyser::AddLevelFrame( const LevelStatistics::Summary& summary, const char* scope, U64 sample_number )
+{
+    FrameV2 frame_v2;
+    frame_v2.AddInteger( "channel", summary.mChannel );
+    frame_v2.AddString( "scope", scope );
+    frame_v2.AddInteger( "words", summary.mCount );
+    frame_v2.AddInteger( "min", summary.mMin );
+    frame_v2.AddInteger( "max", summary.mMax );
+    frame_v2.AddInteger( "peak_to_peak", summary.mMax - summary.mMin );
+    frame_v2.AddDouble( "dc_mean", summary.mMean );
+    frame_v2.AddDouble( "rms_dbfs", summary.mRms > 0.0 ? 20.0 * log10( summary.mRms ) : -999.0 );
+    frame_v2.AddInteger( "clipped", summary.mClipped );
+    frame_v2.AddInteger( "longest_silence", summary.mLongestSilence );
+    frame_v2.AddInteger( "first_sample", summary.mFirstSample );
+    AddReportFrameV2( frame_v2, "level", sample_number );
+}
+
+void I2sTestalyser::CheckForClockGap()
+{
+    U32 threshold = mSettings->mTestSettings.mClockGapThreshold;
+    if( threshold == 0 || mBitPeriod <= 0 )
+        return;
+
+    // look ahead to the next edge without consuming it, the clock normally toggles every half bit period.
+    U64 now = mClock->GetSampleNumber();
+    U64 next_edge = mClock->GetSampleOfNextEdge();
+    if( next_edge - now <= U64( mBitPeriod ) * threshold )
+        return;
+
+    if( !mClockGapPending )
+        mClockGapStart = now;
+    mClockGapEnd = next_edge;
+    mClockGapPending = true;
+
+    // relearn the bit period after the gap, from two edges after it: the gap itself isn't a bit period.
+    mBitPeriod = 0;
+    mLastDataValidSample = 0;
+}
+
+void I2sTestalyser::AddClockGapFrame()
+{
+    mClockGapPending = false;
+
+    Frame frame;
+    frame.mType = U8( ClockGap );
+    frame.mFlags = DISPLAY_AS_WARNING_FLAG;
+    frame.mData1 = mClockGapEnd - mClockGapStart;
+    frame.mStartingSampleInclusive = mClockGapStart;
+    frame.mEndingSampleInclusive = mClockGapEnd;
+
+    FrameV2 frame_v2;
+    frame_v2.AddInteger( "samples", frame.mData1 );
+    frame_v2.AddDouble( "duration", double( frame.mData1 ) / double( GetSampleRate() ) );
+    AddOrderedFrame( frame, frame_v2, "clock_gap" );
+    // DATA isn't read at the end of the gap, so there is no transition count to check there.
+    AddResultCacheRecord( ResultCache::RECORD_CLOCK_GAP, frame, 0, mCacheTransitions );
+    mCache.endFrame();
+
+    mLastAnalyzedSample = mClockGapEnd;
+
+    // TEST_EXTENSION: expected values are meaningless after the gap, and keep the gap out of the clock statistics.
+    mTest.restart();
+    mClockTree.restart();
+    mJitter.restart();
+    mClockPulses.restart( mClockGlitches );
+    mClockTreeBits = 0;
+    mSampleRates.clockGap();
+
+    // a power cycle starts with the CLOCK, timed from where it stopped.
+    StartupTiming::Cycle finished;
+    if( mTest.startupEnabled() && mTest.startupStart( mClockGapStart, mClockGapEnd, finished ) )
+        AddStartupFrame( finished, mClockGapEnd );
+}
+
+bool I2sTestalyser::CanUseResultCache( ResultCacheBlocker& blocker )
+{
+    // the output stream isn't cached, so the loopback measurement always decodes live. So do startup timing, the clock tree
+    // monitor, the jitter spectrum and the CLOCK pulse monitor, which time edges, and clock recovery: the replay walks the CLOCK
+    // edges. Nor frame length tracking or sample rate segments, which time every FRAME period the decode reads.
+    const TestExtensionSettings& settings = mSettings->mTestSettings;
+    if( mOutputData != NULL )
+        blocker = RESULT_CACHE_LOOPBACK_LATENCY;
+    else if( mTest.startupEnabled() )
+        blocker = RESULT_CACHE_STARTUP_TIMING;
+    else if( mClock == NULL )
+        blocker = RESULT_CACHE_NO_CLOCK;
+    else if( mMasterClock != NULL )
+        blocker = RESULT_CACHE_CLOCK_TREE;
+    else if( settings.mJitterSpectrumBlockSize != 0 )
+        blocker = RESULT_CACHE_JITTER_SPECTRUM;
+    else if( settings.mClockGlitchPercent != 0 )
+        blocker = RESULT_CACHE_CLOCK_PULSES;
+    else if( settings.mFrameLengthTracking )
+        blocker = RESULT_CACHE_FRAME_LENGTHS;
+    else if( settings.mSampleRateSegments )
+        blocker = RESULT_CACHE_SAMPLE_RATE_SEGMENTS;
+    else
+        blocker = RESULT_CACHE_USABLE;
+    return blocker == RESULT_CACHE_USABLE;
+}
+
+const char* I2sTestalyser::ResultCacheBlockerString( ResultCacheBlocker blocker )
+{
+    switch( blocker )
+    {
+    case RESULT_CACHE_USABLE:
+        return "usable";
+    case RESULT_CACHE_LOOPBACK_LATENCY:
+        return "loopback latency is measured";
+    case RESULT_CACHE_STARTUP_TIMING:
+        return "startup is timed";
+    case RESULT_CACHE_NO_CLOCK:
+        return "no CLOCK";
+    case RESULT_CACHE_CLOCK_TREE:
+        return "the clock tree is monitored";
+    case RESULT_CACHE_JITTER_SPECTRUM:
+        return "the jitter spectrum is measured";
+    case RESULT_CACHE_CLOCK_PULSES:
+        return "CLOCK pulses are monitored";
+    case RESULT_CACHE_FRAME_LENGTHS:
+        return "frame lengths are tracked";
+    case RESULT_CACHE_SAMPLE_RATE_SEGMENTS:
+        return "sample rate segments are tracked";
+    default:
+        return "unknown";
+    }
+}
+
+void I2sTestalyser::AddResultCacheUnusedFrame( ResultCacheBlocker blocker, U64 sample_number )
+{
+    FrameV2 frame_v2;
+    frame_v2.AddString( "reason", ResultCacheBlockerString( blocker ) );
+    frame_v2.AddString( "directory", mSettings->mTestSettings.mResultCacheDirectory.c_str() );
+
+    // enum I2sResultType { ..., ResultCacheUnused }: mData1 is the ResultCacheBlocker.
+    AddReportFrame( ResultCacheUnused, DISPLAY_AS_WARNING_FLAG, blocker, 0, sample_number, frame_v2, "result_cache" );
+}
+
+U64 I2sTestalyser::GetResultCacheKey()
+{
+    // everything that decides which words come out of the decode, presentation settings are applied at replay.
+    ResultCache::Key key;
+    key.add( GetSampleRate() );
+    key.add( GetTriggerSample() );
+    key.add( mFormat.mShiftOrder );
+    key.add( mFormat.mDataValidEdge );
+    key.add( mFormat.mBitsPerWord );
+    key.add( mFormat.mWordAlignment );
+    key.add( mFormat.mFrameType );
+    key.add( mFormat.mBitAlignment );
+    key.add( mSettings->mTestSettings.mClockGapThreshold );
+    key.add( mSettings->mTestSettings.mDecodeRange );
+    key.add( U64( S64( mSettings->mTestSettings.mDecodeStartUs ) ) );
+    key.add( U64( S64( mSettings->mTestSettings.mDecodeEndUs ) ) );
+    key.add( mSettings->mTestSettings.mFormatDetectionMs );
+
+    // where the capture starts, the records themselves are checked against the rest of it during the replay.
+    AnalyzerChannelData* channels[ 3 ] = { mClock, mFrame, mData };
+    Channel* settings_channels[ 3 ] = { &mSettings->mClockChannel, &mSettings->mFrameChannel, &mSettings->mDataChannel };
+    for( U32 i = 0; i < 3; i++ )
+    {
+        key.add( settings_channels[ i ]->mDeviceId );
+        key.add( settings_channels[ i ]->mChannelIndex );
+        key.add( channels[ i ]->GetSampleNumber() );
+        key.add( channels[ i ]->GetBitState() );
+        key.add( channels[ i ]->DoMoreTransitionsExistInCurrentData() ? channels[ i ]->GetSampleOfNextEdge() : U64( -1 ) );
+    }
+    return key.value();
+}
+
+void I2sTestalyser::AddResultCacheRecord( ResultCache::RecordKind kind, const Frame& frame, U32 subframe_index, U64 transitions )
+{
+    ResultCache::Record record = {};
+    record.mKind = U8( kind );
+    record.mIndex = U8( subframe_index );
+    if( kind != ResultCache::RECORD_CLOCK_GAP )
+    {
+        if( mCacheFrameStartPending )
+        {
+            mCacheFrameStartPending = false;
+            record.mFlags |= ResultCache::RECORD_FRAME_START;
+            record.mFrameStart = mDataValidEdges.front();
+            record.mFrameStartTransitions = mDataValidTransitions.front() - mCacheTransitions;
+            mCacheTransitions = mDataValidTransitions.front();
+        }
+        if( frame.mEndingSampleInclusive == mDataValidEdges.back() )
+            record.mFlags |= ResultCache::RECORD_FRAME_END;
+    }
+    record.mStart = frame.mStartingSampleInclusive;
+    record.mEnd = frame.mEndingSampleInclusive;
+    record.mValue = kind == ResultCache::RECORD_WORD ? frame.mData1 : frame.mType;
+    record.mTransitions = transitions - mCacheTransitions;
+    mCacheTransitions = transitions;
+    mCache.write( record );
+}
+
+bool I2sTestalyser::IsReplayableRecord( const ResultCache::Record& record, U64 position )
+{
+    // a damaged record mustn't move the channels back or take a word the format can't have.
+    switch( record.mKind )
+    {
+    case ResultCache::RECORD_WORD:
+        return record.mFrameStart >= position && record.mStart >= record.mFrameStart && record.mEnd >= record.mStart &&
+               record.mIndex < mFormat.GetChannelsCount() && ( mFormat.mBitsPerWord >= 64 || ( record.mValue >> mFormat.mBitsPerWord ) == 0 );
+    case ResultCache::RECORD_FRAME_ERROR:
+        return record.mFrameStart >= position && record.mStart >= record.mFrameStart && record.mEnd >= record.mStart &&
+               ( record.mValue == ErrorDoesntDivideEvenly || record.mValue == ErrorTooFewBits );
+    case ResultCache::RECORD_CLOCK_GAP:
+        return record.mEnd >= position && record.mEnd >= record.mStart;
+    default:
+        return false;
+    }
+}
+
+bool I2sTestalyser::ReplayToCachedBit( U64 sample_number, U64 transitions, ReplayPosition position )
+{
+    // within twice the longest stretch a matching record moved the channels CLOCK jumps. Further than that it goes one edge at a time
+    // through the data that is there, and no further than the record's transitions: a damaged record that points past the capture
+    // stops it near where it was.
+    U64 stretch = sample_number - mClock->GetSampleNumber();
+    U64 walked = 0;
+    if( stretch <= 2 * mReplayStretch )
+        walked = mClock->AdvanceToAbsPosition( sample_number );
+    else
+    {
+        while( walked <= transitions && mClock->GetSampleNumber() < sample_number && mClock->DoMoreTransitionsExistInCurrentData() &&
+               mClock->GetSampleOfNextEdge() <= sample_number )
+        {
+            mClock->AdvanceToNextEdge();
+            walked++;
+        }
+        if( walked > transitions || mClock->GetSampleNumber() != sample_number )
+        {
+            // DATA and FRAME didn't move, the live decode finds its first frame from CLOCK.
+            mReplayPosition = REPLAY_NONE;
+            return false;
+        }
+    }
+
+    walked += mData->AdvanceToAbsPosition( sample_number );
+    walked += mFrame->AdvanceToAbsPosition( sample_number );
+
+    // it is a data valid edge, the live decode carries on from this bit whether the record matches or not. At the start of a frame
+    // none of it was read yet. Past a word the channels can't go back, so the rest of a differing frame is lost.
+    mLastData = mData->GetBitState();
+    mLastFrame = mFrame->GetBitState();
+    mLastSample = sample_number;
+    mCurrentData = mLastData;
+    mCurrentFrame = mLastFrame;
+    mCurrentSample = mLastSample;
+    mReplayPosition = position;
+    if( walked != transitions )
+        return false;
+    mReplayStretch = std::max( mReplayStretch, stretch );
+    return true;
+}
+
+bool I2sTestalyser::ReplayResultCacheRecord( const ResultCache::Record& record )
+{
+    // the capture has to have the same edges as when the record was written, or the cache belongs to another capture.
+    if( ( record.mFlags & ResultCache::RECORD_FRAME_START ) != 0 &&
+        !ReplayToCachedBit( record.mFrameStart, record.mFrameStartTransitions, REPLAY_AT_FRAME_START ) )
+        return false;
+    if( record.mKind != ResultCache::RECORD_CLOCK_GAP &&
+        !ReplayToCachedBit( record.mEnd, record.mTransitions,
+                            ( record.mFlags & ResultCache::RECORD_FRAME_END ) != 0 ? REPLAY_AT_FRAME_END : REPLAY_AT_BIT ) )
+        return false;
+
+    switch( record.mKind )
+    {
+    case ResultCache::RECORD_WORD:
+        FlushStaleErrorRange( record.mStart );
+        ProcessWord( record.mValue, record.mStart, record.mEnd, record.mIndex );
+        break;
+    case ResultCache::RECORD_FRAME_ERROR:
+    {
+        Frame frame;
+        frame.mType = U8( record.mValue );
+        frame.mFlags = DISPLAY_AS_ERROR_FLAG;
+        frame.mStartingSampleInclusive = record.mStart;
+        frame.mEndingSampleInclusive = record.mEnd;
+        FlushStaleErrorRange( record.mStart );
+        ReportError( frame, 0, 0 );
+    }
+    break;
+    case ResultCache::RECORD_CLOCK_GAP:
+        mClockGapStart = record.mStart;
+        mClockGapEnd = record.mEnd;
+        AddClockGapFrame();
+        break;
+    }
+    mLastAnalyzedSample = record.mEnd;
+    return true;
+}
+
+void I2sTestalyser::ReplayResultCache()
+{
+    // a frame is replayed once all of its records were read and look sound, a frame cut short or damaged ends the replay before it
+    // moves any channel. The file is cut back to the frames replayed and carries on from there.
+    std::vector<ResultCache::Record> frame_records;
+    ResultCache::Record record;
+    U64 position = mClock->GetSampleNumber();
+    U64 replayed = 0;
+    mReplayStretch = 0;
+    while( mCache.read( record ) && IsReplayableRecord( record, position ) )
+    {
+        position = record.mEnd;
+        frame_records.push_back( record );
+        if( ( record.mFlags & ResultCache::RECORD_FRAME_LAST ) == 0 )
+            continue;
+
+        for( const ResultCache::Record& frame_record : frame_records )
+        {
+            if( !ReplayResultCacheRecord( frame_record ) )
+            {
+                mCache.discard();
+                break;
+            }
+        }
+        if( !mCache.isReplaying() )
+            break;
+        frame_records.clear();
+        mCache.replayed();
+
+        if( ( ++replayed & 0xFF ) == 0 )
+        {
+            mResults->CommitResults();
+            ReportProgress( record.mEnd );
+            CheckIfThreadShouldExit();
+        }
+    }
+
+    // decoding carries on from the end of the replayed records, counting transitions from there.
+    mResults->CommitResults();
+    ReportProgress( mClock->GetSampleNumber() );
+    if( mCache.isReplaying() )
+        mCache.resumeWriting();
+}
+
+void I2sTestalyser::SetupDecodeRange()
+{
+    mDecodeStartSample = 0;
+    mDecodeEndSample = U64( -1 );
+
+    TestExtensionSettings& settings = mSettings->mTestSettings;
+    if( settings.mDecodeRange == DECODE_WHOLE_CAPTURE )
+        return;
+
+    S64 origin = ( settings.mDecodeRange == DECODE_FROM_TRIGGER ) ? S64( GetTriggerSample() ) : 0;
+    double samples_per_us = double( GetSampleRate() ) / 1000000.0;
+    S64 start = origin + S64( double( settings.mDecodeStartUs ) * samples_per_us );
+    S64 end = origin + S64( double( settings.mDecodeEndUs ) * samples_per_us );
+
+    mDecodeStartSample = U64( std::max<S64>( start, 0 ) );
+    mDecodeEndSample = U64( std::max<S64>( end, 0 ) );
+}
+
+void I2sTestalyser::DetectFormat()
+{
+    U64 start_sample = mClock->GetSampleNumber();
+    U64 end_sample = start_sample + U64( mSettings->mTestSettings.mFormatDetectionMs ) * GetSampleRate() / 1000;
+
+    FormatDetector::Edges clock_edges;
+    FormatDetector::Edges frame_edges;
+    FormatDetector::Edges data_edges;
+    FormatDetector::collect( mClock, end_sample, clock_edges );
+    FormatDetector::collect( mFrame, end_sample, frame_edges );
+    FormatDetector::collect( mData, end_sample, data_edges );
+
+    FormatDetector detector;
+    FormatDetector::Result format = detector.detect( clock_edges, frame_edges, data_edges, mFormat );
+
+    if( format.mValid )
+    {
+        mFormat.mDataValidEdge = format.mDataValidEdge;
+        mFormat.mFrameType = format.mFrameType;
+        mFormat.mBitAlignment = format.mBitAlignment;
+        mFormat.mBitsPerWord = format.mBitsPerWord;
+        if( format.mBitsPerWord < format.mSlotBits )
+            mFormat.mWordAlignment = LEFT_ALIGNED;
+    }
+
+    Frame frame;
+    frame.mType = U8( FormatDetected );
+    frame.mFlags = format.mValid ? 0 : DISPLAY_AS_WARNING_FLAG;
+    frame.mData1 = format.mValid ? format.mBitsPerWord : 0;
+    frame.mData2 = format.mSlotBits;
+    frame.mStartingSampleInclusive = start_sample;
+    frame.mEndingSampleInclusive = end_sample;
+    mResults->AddFrame( frame );
+
+    FrameV2 frame_v2;
+    frame_v2.AddBoolean( "detected", format.mValid );
+    if( format.mValid )
+    {
+        frame_v2.AddInteger( "bits_per_period", format.mBitsPerPeriod );
+        frame_v2.AddDouble( "frame_duty_cycle", format.mDutyCycle );
+        frame_v2.AddString( "data_valid_edge", format.mDataValidEdge == AnalyzerEnums::PosEdge ? "rising" : "falling" );
+        frame_v2.AddInteger( "words_per_frame", FormatDetector::wordsPerFrame( format.mFrameType ) );
+        frame_v2.AddInteger( "bit_shift", format.mBitAlignment == BITS_SHIFTED_RIGHT_1 ? 1 : 0 );
+        frame_v2.AddInteger( "slot_bits", format.mSlotBits );
+        frame_v2.AddInteger( "bits_per_word", format.mBitsPerWord );
+        frame_v2.AddDouble( "score", format.mScore );
+    }
+    else
+    {
+        frame_v2.AddString( "reason", format.mReason );
+    }
+    mResults->AddFrameV2( frame_v2, "format", start_sample, end_sample );
+    mResults->CommitResults();
+}
+
+void I2sTestalyser::SkipToEndOfCapture()
+{
+    // nothing more to decode, but the worker thread must not return. Step over the rest of the capture a second at a time,
+    // so the progress still reaches the end.
+    for( ;; )
+    {
+        mTimebase->Advance( GetSampleRate() );
+        ReportProgress( mTimebase->GetSampleNumber() );
+        CheckIfThreadShouldExit();
+    }
+}
+
+void I2sTestalyser::OnDataExhausted()
+{
+    // a capture that is complete runs out of data once, at its end. A live capture keeps catching up with the data, so there
+    // the reports are flushed at most once a second of capture, or error ranges would hardly merge and the level totals would
+    // crowd out everything else.
+    if( mReportsFlushed && mLastAnalyzedSample < mReportsFlushedSample + GetSampleRate() )
+        return;
+    mReportsFlushed = true;
+    mReportsFlushedSample = mLastAnalyzedSample;
+    FlushReports();
+}
+
+void I2sTestalyser::FlushReports()
+{
+    // don't sit on an open error range, or on the level totals, while waiting for more data. The report periods carry on.
+    FlushErrorRange();
+    AddLevelTotalFrames( mLastAnalyzedSample );
+    ClockTreeMonitor::Report report;
+    if( mClockTree.flush( mLastAnalyzedSample, report ) )
+        mClockTreeReports.push_back( report );
+    AddClockTreeFrames( mLastAnalyzedSample );
+    JitterSpectrum::Report jitter_report;
+    if( mJitter.flush( mLastAnalyzedSample, jitter_report ) )
+        mJitterReports.push_back( jitter_report );
+    AddJitterSpectrumFrames( mLastAnalyzedSample );
+    ClockPulseMonitor::Report pulse_report;
+    if( mClockPulses.flush( mLastAnalyzedSample, pulse_report ) )
+        mClockPulseReports.push_back( pulse_report );
+    AddClockPulseFrames( mLastAnalyzedSample );
+    FrameLengthTracker::Report length_report;
+    if( mFrameLengths.flush( mLastAnalyzedSample, length_report ) )
+        mFrameLengthReports.push_back( length_report );
+    AddFrameLengthFrames( mLastAnalyzedSample );
+    SampleRateTracker::Segment rate_segment;
+    if( mSampleRates.flush( mLastAnalyzedSample, rate_segment ) )
+        mRateSegments.push_back( rate_segment );
+    AddSampleRateFrames( mLastAnalyzedSample );
+    mCache.flush();
+}
+
+void I2sTestalyser::AddLevelTotalFrames( U64 sample_number )
+{
+    // only when something was decoded since the last totals, so a live capture doesn't repeat them on every frame.
+    if( !mTest.levelStatisticsEnabled() || mLevelWordsSinceTotals == 0 )
+        return;
+    mLevelWordsSinceTotals = 0;
+
+    for( U32 channel = 0; channel < mFormat.GetChannelsCount(); channel++ )
+    {
+        const LevelStatistics::Summary& total = mTest.levelTotal( channel );
+        if( total.mCount != 0 )
+            AddLevelFrame( total, "total", sample_number );
+    }
+}
+
+void I2sTestalyser::AddAudioQualityFrame( const AudioQualityAnalysis::Result& quality, U64 sample_number )
+{
+    FrameV2 frame_v2;
+    frame_v2.AddInteger( "channel", quality.mChannel );
+    frame_v2.AddDouble( "frequency", quality.mFrequencyHz );
+    frame_v2.AddDouble( "thd_n_db", quality.mThdNDb );
+    frame_v2.AddDouble( "snr_db", quality.mSnrDb );
+    frame_v2.AddDouble( "dc_offset", quality.mDcOffset );
+    frame_v2.AddInteger( "first_sample", quality.mFirstSample );
+    AddReportFrameV2( frame_v2, "audio_quality", sample_number );
+}
+
+void I2sTestalyser::ReportError( const Frame& frame, U32 channel, int bit_slip )
+{
+    // TEST_EXTENSION: every error counts to the sample rate segment, merged or not.
+    mSampleRates.error();
+
+    if( mErrorRange.mCount != 0 )
+    {
+        bool same_kind = mErrorRange.mFirst.mType == frame.mType;
+        bool within_gap = U64( frame.mStartingSampleInclusive ) <= mErrorRange.mLastSample + mErrorMergeGapSamples;
+
+        if( same_kind && within_gap )
+        {
+            mErrorRange.mLastSample = frame.mEndingSampleInclusive;
+            mErrorRange.mCount++;
+            AddChannelError( frame, channel );
+            return;
+        }
+
+        FlushErrorRange();
+    }
+
+    // TEST_EXTENSION: the first error of each range is the automation's trigger, send it before anything else.
+    mTest.reportError( frame.mStartingSampleInclusive, frame.mEndingSampleInclusive, channel, frame.mData2, frame.mData1, frame.mType );
+
+    // the SDK Frame has no copy assignment, copy its fields.
+    mErrorRange.mFirst.mStartingSampleInclusive = frame.mStartingSampleInclusive;
+    mErrorRange.mFirst.mEndingSampleInclusive = frame.mEndingSampleInclusive;
+    mErrorRange.mFirst.mType = frame.mType;
+    mErrorRange.mFirst.mFlags = frame.mFlags;
+    mErrorRange.mFirst.mData1 = frame.mData1;
+    mErrorRange.mFirst.mData2 = frame.mData2;
+    mErrorRange.mChannel = channel;
+    mErrorRange.mBitSlip = bit_slip;
+    mErrorRange.mLastSample = frame.mEndingSampleInclusive;
+    mErrorRange.mCount = 1;
+    mErrorRange.mChannels.clear();
+    AddChannelError( frame, channel );
+
+    if( mErrorMergeGapSamples == 0 )
+        FlushErrorRange();
+}
+
+void I2sTestalyser::AddChannelError( const Frame& frame, U32 channel )
+{
+    if( mErrorRange.mChannels.size() <= channel )
+        mErrorRange.mChannels.resize( channel + 1, ChannelErrors() );
+    ChannelErrors& errors = mErrorRange.mChannels[ channel ];
+    if( errors.mCount == 0 )
+        errors.mFirstSample = frame.mStartingSampleInclusive;
+    errors.mLastSample = frame.mEndingSampleInclusive;
+    errors.mCount++;
+}
+
+void I2sTestalyser::FlushStaleErrorRange( U64 sample_number )
+{
+    if( ( mErrorRange.mCount != 0 ) && ( sample_number > mErrorRange.mLastSample + mErrorMergeGapSamples ) )
+        FlushErrorRange();
+}
+
+void I2sTestalyser::FlushErrorRange()
+{
+    if( mErrorRange.mCount == 0 )
+        return;
+
+    const Frame& first = mErrorRange.mFirst;
+    I2sResultType type = I2sResultType( first.mType );
+
+    const char* description = "";
+    switch( type )
+    {
+    case ErrorTooFewBits:
+        description = "not enough bits";
+        break;
+    case ErrorDoesntDivideEvenly:
+        description = "invalid number of bits";
+        break;
+    case TestError:
+        if( mSettings->mTestSettings.mTestMode == TestMode::TEST_REFERENCE )
+            description = "differs from reference";
+        else if( mSettings->mTestSettings.mTestMode == TestMode::TEST_LOCKSTEP )
+            description = "not in lock-step";
+        else if( mSettings->mTestSettings.mTestMode == TestMode::TEST_SEQUENCE )
+            description = "CRC mismatch";
+        else
+            description = "Not contiguous!";
+        break;
+    default:
+        AnalyzerHelpers::Assert( "unexpected" );
+        break;
+    }
+
+    Frame frame = first;
+    if( mErrorRange.mCount > 1 )
+    {
+        // enum I2sResultType { ..., ErrorRange }: mData1 is the number of errors, mData2 the type of the merged errors.
+        frame.mType = U8( ErrorRange );
+        frame.mData1 = mErrorRange.mCount;
+        frame.mData2 = type;
+        frame.mEndingSampleInclusive = mErrorRange.mLastSample;
+    }
+    mResults->AddFrame( frame );
+
+    FrameV2 frame_v2;
+    frame_v2.AddString( "error", description );
+    if( type == TestError )
+    {
+        frame_v2.AddInteger( "channel", mErrorRange.mChannel );
+        frame_v2.AddInteger( "expected", first.mData2 );
+        frame_v2.AddInteger( "received", first.mData1 );
+        frame_v2.AddInteger( "bit_slip", mErrorRange.mBitSlip );
+    }
+    if( mErrorRange.mCount > 1 )
+    {
+        frame_v2.AddInteger( "count", mErrorRange.mCount );
+        frame_v2.AddInteger( "first_sample", first.mStartingSampleInclusive );
+        frame_v2.AddInteger( "last_sample", mErrorRange.mLastSample );
+        for( U32 channel = 0; channel < mErrorRange.mChannels.size(); channel++ )
+        {
+            const ChannelErrors& errors = mErrorRange.mChannels[ channel ];
+            if( type != TestError || errors.mCount == 0 )
+                continue;
+            std::string name = "ch" + std::to_string( channel );
+            frame_v2.AddInteger( ( name + "_count" ).c_str(), errors.mCount );
+            frame_v2.AddInteger( ( name + "_first_sample" ).c_str(), errors.mFirstSample );
+            frame_v2.AddInteger( ( name + "_last_sample" ).c_str(), errors.mLastSample );
+        }
+    }
+    mResults->AddFrameV2( frame_v2, "error", frame.mStartingSampleInclusive, frame.mEndingSampleInclusive );
+
+    mErrorRange.mCount = 0;
+
+    if( type == TestError )
+    {
+        for( U32 channel = 0; channel < mErrorRange.mChannels.size(); channel++ )
+        {
+            if( mErrorRange.mChannels[ channel ].mCount != 0 )
+                AddFaultMapFrame( channel, frame.mEndingSampleInclusive );
+        }
+    }
+}
+
+void I2sTestalyser::AddOrderedFrame( const Frame& frame, const FrameV2& frame_v2, const char* name )
+{
+    // frames must be added in order. An open error range started before this frame, so it is closed first; every frame but the
+    // range's own goes through here.
+    FlushErrorRange();
+    mResults->AddFrame( frame );
+    mResults->AddFrameV2( frame_v2, name, frame.mStartingSampleInclusive, frame.mEndingSampleInclusive );
+}
+
+void I2sTestalyser::AddReportFrame( I2sResultType type, U8 flags, U64 data1, U64 data2, U64 sample_number, const FrameV2& frame_v2,
+                                    const char* name )
+{
+    Frame frame;
+    frame.mType = U8( type );
+    frame.mFlags = flags;
+    frame.mData1 = data1;
+    frame.mData2 = data2;
+    frame.mStartingSampleInclusive = sample_number;
+    frame.mEndingSampleInclusive = sample_number;
+    AddOrderedFrame( frame, frame_v2, name );
+}
+
+void I2sTestalyser::AddReportFrameV2( const FrameV2& frame_v2, const char* name, U64 sample_number )
+{
+    // a report with no frame of its own in the bubbles and table, the same ordering applies.
+    FlushErrorRange();
+    mResults->AddFrameV2( frame_v2, name, sample_number, sample_number );
+}
+
+void I2sTestalyser::AddFaultMapFrame( U32 channel, U64 sample_number )
+{
+    BitFaultMap& fault_map = mTest.faultMap();
+
+    // Only summarise when the set of failing bits or the diagnosis has changed, not on every error.
+    if( !fault_map.takeChanged( channel ) )
+        return;
+
+    const BitFaultMap::ChannelFaults& faults = fault_map.faults( channel );
+
+    FrameV2 frame_v2;
+    frame_v2.AddInteger( "channel", channel );
+    frame_v2.AddString( "diagnosis", fault_map.diagnosis( channel ).c_str() );
+    frame_v2.AddInteger( "errors", faults.mErrorCount );
+    frame_v2.AddInteger( "mismatch_mask", faults.mMismatchMask );
+    frame_v2.AddInteger( "stuck_high_mask", fault_map.stuckHighMask( channel ) );
+    frame_v2.AddInteger( "stuck_low_mask", fault_map.stuckLowMask( channel ) );
+    frame_v2.AddString( "bit_errors", fault_map.bitErrorString( channel ).c_str() );
+    mResults->AddFrameV2( frame_v2, "fault_map", sample_number, sample_number );
+}
+
+void I2sTestalyser::SetupForGettingFirstFrame()
+{
+    // a replay that stopped at the start of a frame already has its first bit, one that stopped in a frame has the history.
+    ReplayPosition replay_position = mReplayPosition;
+    mReplayPosition = REPLAY_NONE;
+    if( replay_position == REPLAY_AT_FRAME_START )
+        return;
+
+    if( replay_position == REPLAY_AT_FRAME_END )
+    {
+        // the bit after the last of a frame is the first of the next, the FRAME edge that says so may have been read already.
+        GetNextBit( mCurrentData, mCurrentFrame, mCurrentSample );
+        if( !mClockGapPending )
+            return;
+        AddClockGapFrame();
+        mLastFrame = mCurrentFrame;
+        mLastData = mCurrentData;
+        mLastSample = mCurrentSample;
+    }
+    else if( replay_position != REPLAY_AT_BIT )
+        GetNextBit( mLastData, mLastFrame, mLastSample ); // we have to throw away one bit to get enough history on the FRAME line.
+
+    for( ;; )
+    {
+        GetNextBit( mCurrentData, mCurrentFrame, mCurrentSample );
+
+        if( mClockGapPending )
+        {
+            // FRAME history from before the gap says nothing about the frame after it.
+            AddClockGapFrame();
+            mLastFrame = mCurrentFrame;
+            mLastData = mCurrentData;
+            mLastSample = mCurrentSample;
+            continue;
+        }
+
+        if( mCurrentFrame == BIT_HIGH && mLastFrame == BIT_LOW )
+        {
+            if( mFormat.mBitAlignment == BITS_SHIFTED_RIGHT_1 )
+            {
+                // we need to advance to the next bit past the frame.
+                mLastFrame = mCurrentFrame;
+                mLastData = mCurrentData;
+                mLastSample = mCurrentSample;
+
+                GetNextBit( mCurrentData, mCurrentFrame, mCurrentSample );
+            }
+            return;
+        }
+
+        mLastFrame = mCurrentFrame;
+        mLastData = mCurrentData;
+        mLastSample = mCurrentSample;
+    }
+}
+
+void I2sTestalyser::GetFrame()
+{
+    // on entering this function:
+    // mCurrentFrame and mCurrentData are the values of the first bit -- that belongs to us -- in the frame.
+    // mLastFrame and mLastData are the values from the bit just before.
+
+    mDataBits.clear();
+    mDataValidEdges.clear();
+    mDataValidTransitions.clear();
+
+
+    mDataBits.push_back( mCurrentData );
+    mDataValidEdges.push_back( mCurrentSample );
+    mDataValidTransitions.push_back( mBitTransitions );
+
+    mLastFrame = mCurrentFrame;
+    mLastData = mCurrentData;
+    mLastSample = mCurrentSample;
+
+    for( ;; )
+    {
+        GetNextBit( mCurrentData, mCurrentFrame, mCurrentSample );
+
+        if( mClockGapPending )
+            return;
+
+        if( mCurrentFrame == BIT_HIGH && mLastFrame == BIT_LOW )
+        {
+            if( mFormat.mBitAlignment == BITS_SHIFTED_RIGHT_1 )
+            {
+                // this bit belongs to us:
+                mDataBits.push_back( mCurrentData );
+                mDataValidEdges.push_back( mCurrentSample );
+                mDataValidTransitions.push_back( mBitTransitions );
+
+                // we need to advance to the next bit past the frame.
+                mLastFrame = mCurrentFrame;
+                mLastData = mCurrentData;
+                mLastSample = mCurrentSample;
+
+                GetNextBit( mCurrentData, mCurrentFrame, mCurrentSample );
+            }
+
+            return;
+        }
+
+        mDataBits.push_back( mCurrentData );
+        mDataValidEdges.push_back( mCurrentSample );
+        mDataValidTransitions.push_back( mBitTransitions );
+
+        mLastFrame = mCurrentFrame;
+        mLastData = mCurrentData;
+        mLastSample = mCurrentSample;
+    }
+}
+
+void I2sTestalyser::SetupForGettingFirstBit()
+{
+    // TEST_EXTENSION: a recovered clock has no edge to line up with.
+    if( mClock == NULL )
+        return;
+
+    if( mFormat.mDataValidEdge == AnalyzerEnums::PosEdge )
+    {
+        // we want to start out low, so the next time we advance, it'll be a rising edge.
+        if( mClock->GetBitState() == BIT_HIGH )
+        {
+            mClock->AdvanceToNextEdge(); // now we're low.
+            mTransitions++;
+        }
+    }
+    else
+    {
+        // we want to start out low, so the next time we advance, it'll be a falling edge.
+        if( mClock->GetBitState() == BIT_LOW )
+        {
+            mClock->AdvanceToNextEdge(); // now we're high.
+            mTransitions++;
+        }
+    }
+}
+
+void I2sTestalyser::GetNextBit( BitState& data, BitState& frame, U64& sample_number )
+{
+    // TEST_EXTENSION
+    if( mClock == NULL )
+    {
+        GetNextRecoveredBit( data, frame, sample_number );
+        return;
+    }
+
+    // about to wait for more data, report what is pending at the end of the last analyzed frame.
+    if( !mClock->DoMoreTransitionsExistInCurrentData() )
+        OnDataExhausted();
+
+    CheckForClockGap();
+
+    // we always start off here so that the next edge is where the data is valid.
+    mClock->AdvanceToNextEdge();
+    U64 data_valid_sample = mClock->GetSampleNumber();
+    mTransitions++;
+
+    // TEST_EXTENSION: every edge the decode consumes ends a CLOCK pulse, measured against the bit period from the edges before it.
+    if( mClockPulses.enabled() && !mClockGapPending )
+        MeasureClockPulse();
+
+    // track the nominal bit period, a slow moving average so a single late edge doesn't move it much.
+    if( !mClockGapPending && mLastDataValidSample != 0 )
+    {
+        S64 bit_period = S64( data_valid_sample - mLastDataValidSample );
+        if( mBitPeriod == 0 )
+            mBitPeriod = bit_period;
+        else
+            mBitPeriod += ( bit_period - mBitPeriod ) / 8;
+    }
+    mLastDataValidSample = data_valid_sample;
+
+    mTransitions += mData->AdvanceToAbsPosition( data_valid_sample );
+    data = mData->GetBitState();
+
+    // TEST_EXTENSION: the clock tree is measured at each FRAME rising edge, from the bit clocks counted since the last one.
+    if( mMasterClock != NULL && !mClockGapPending )
+    {
+        if( mFrame->GetBitState() == BIT_LOW && mFrame->WouldAdvancingToAbsPositionCauseTransition( data_valid_sample ) )
+            MonitorClockTree( mFrame->GetSampleOfNextEdge(), data_valid_sample, data_valid_sample + U64( std::max<S64>( mBitPeriod, 0 ) ) );
+        mClockTreeBits++;
+    }
+
+    mTransitions += mFrame->AdvanceToAbsPosition( data_valid_sample );
+    mBitTransitions = mTransitions;
+    frame = mFrame->GetBitState();
+
+    // TEST_EXTENSION: the bit that ends a clock gap belongs to neither power cycle.
+    if( mTest.startupEnabled() && !mClockGapPending )
+        mTest.startupFrameBit( frame, data_valid_sample );
+
+    // TEST_EXTENSION: the bits after a clock gap wait for the restart, a block of jitter measurements can't span the gap.
+    JitterSpectrum::Report jitter_report;
+    if( !mClockGapPending && mJitter.edge( data_valid_sample, jitter_report ) )
+        mJitterReports.push_back( jitter_report );
+
+    sample_number = data_valid_sample;
+
+    mResults->AddMarker( data_valid_sample, mArrowMarker, mSettings->mClockChannel );
+
+    if( !mClock->DoMoreTransitionsExistInCurrentData() )
+        OnDataExhausted();
+
+    CheckForClockGap();
+
+    mClock->AdvanceToNextEdge(); // advance one more, so we're ready for next this function is called.
+    mTransitions++;
+    if( mClockPulses.enabled() && !mClockGapPending )
+        MeasureClockPulse();
+
+    // TEST_EXTENSION
+    mTest.setDataValidEdge(data_valid_sample);
+    mTest.setDataTransitionEdge(mClock->GetSampleNumber());
+}
+
+void I2sTestalyser::GetNextRecoveredBit( BitState& data, BitState& frame, U64& sample_number )
+{
+    // about to wait for more data, report what is pending at the end of the last analyzed frame.
+    if( !mFrame->DoMoreTransitionsExistInCurrentData() )
+        OnDataExhausted();
+
+    // FRAME toggles at least once per FRAME period, so a gap is also at least two of them.
+    ClockRecovery::Report report;
+    U32 threshold = mSettings->mTestSettings.mClockGapThreshold;
+    if( threshold != 0 )
+        threshold = std::max<U32>( threshold, mRecovery.bitsPerFrame() * 2 );
+
+    for( ;; )
+    {
+        if( !mRecovery.acquired() )
+        {
+            // the bit period and phase come from the FRAME rising edges, DATA before them isn't decoded.
+            mFrame->AdvanceToNextEdge();
+            U64 edge = mFrame->GetSampleNumber();
+            if( mFrame->GetBitState() == BIT_HIGH )
+                mRecovery.frameStart( edge, report );
+            mData->AdvanceToAbsPosition( edge );
+            continue;
+        }
+
+        U64 centre = mRecovery.centre();
+        U64 gap_samples = U64( mRecovery.bitPeriod() * threshold );
+        if( threshold != 0 && !mFrame->WouldAdvancingToAbsPositionCauseTransition( centre + gap_samples ) )
+        {
+            // the clock stopped: acquire it again after the gap.
+            if( !mClockGapPending )
+                mClockGapStart = mFrame->GetSampleNumber();
+            mClockGapEnd = mFrame->GetSampleOfNextEdge();
+            mClockGapPending = true;
+            if( mRecovery.stop( mClockGapStart, report ) )
+                mRecoveryReports.push_back( report );
+            continue;
+        }
+
+        // every edge up to the centre of the bit steers the recovered clock, and with it the centre.
+        bool data_edge = mData->WouldAdvancingToAbsPositionCauseTransition( centre );
+        bool frame_edge = mFrame->WouldAdvancingToAbsPositionCauseTransition( centre );
+        if( !data_edge && !frame_edge )
+            break;
+
+        if( frame_edge && ( !data_edge || mFrame->GetSampleOfNextEdge() <= mData->GetSampleOfNextEdge() ) )
+        {
+            mFrame->AdvanceToNextEdge();
+            if( mFrame->GetBitState() != BIT_HIGH )
+                mRecovery.edge( mFrame->GetSampleNumber() );
+            else
+            {
+                if( mMasterClock != NULL )
+                    MonitorClockTree( mFrame->GetSampleNumber(), 0, centre + U64( mRecovery.bitPeriod() ) );
+                if( mRecovery.frameStart( mFrame->GetSampleNumber(), report ) )
+                    mRecoveryReports.push_back( report );
+            }
+        }
+        else
+        {
+            mData->AdvanceToNextEdge();
+            mRecovery.edge( mData->GetSampleNumber() );
+        }
+    }
+
+    U64 centre = mRecovery.centre();
+    mData->AdvanceToAbsPosition( centre );
+    data = mData->GetBitState();
+    mFrame->AdvanceToAbsPosition( centre );
+    frame = mFrame->GetBitState();
+    mRecovery.nextBit();
+    if( mMasterClock != NULL && !mClockGapPending )
+        mClockTreeBits++;
+
+    // the bit that ends a clock gap belongs to neither power cycle.
+    if( mTest.startupEnabled() && !mClockGapPending )
+        mTest.startupFrameBit( frame, centre );
+
+    sample_number = centre;
+    mResults->AddMarker( centre, AnalyzerResults::Dot, mSettings->mDataChannel );
+    mTest.setDataValidEdge( centre );
+}
+
+U32 I2sTestalyser::GenerateSimulationData( U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels )
+{
+    if( mSimulationInitilized == false )
+    {
+        mSimulationDataGenerator.Initialize( GetSimulationSampleRate(), mSettings.get() );
+        mSimulationInitilized = true;
+    }
+
+    return mSimulationDataGenerator.GenerateSimulationData( newest_sample_requested, sample_rate, simulation_channels );
+}
+
+U32 I2sTestalyser::GetMinimumSampleRateHz()
+{
+    return 4000000; // just enough for our simulation.  Ideally we would be smarter about this but we don't know the bit rate in advance.
+}
+
+bool I2sTestalyser::NeedsRerun()
+{
+    return false;
+}
+
+const I2sFrameFormat& I2sTestalyser::GetFrameFormat() const
+{
+    return mFormat;
 }
 
 const char* I2sTestalyser::GetAnalyzerName() const
@@ -4,6 +4,9 @@
 #include <Analyzer.h>
 #include "I2sTestalyserResults.h"
 #include "I2sSimulationDataGenerator.h"
+#include "ResultCache.hpp"
+#include "OutputStreamDecoder.hpp"
+#include "ClockRecovery.hpp"
 
 class I2sTestalyserSettings;
 class I2sTestalyser : public Analyzer2
@@ -18,6 +21,22 @@ class I2sTestalyser : public Analyzer2
     virtual U32 GetMinimumSampleRateHz();
 
     const char* GetAnalyzerName() const;
+    const I2sFrameFormat& GetFrameFormat() const; // of the last run, the settings unless format detection replaced it
+
+    // what keeps a run with a result cache directory from using the cache, the first that applies.
+    enum ResultCacheBlocker
+    {
+        RESULT_CACHE_USABLE,
+        RESULT_CACHE_LOOPBACK_LATENCY,
+        RESULT_CACHE_STARTUP_TIMING,
+        RESULT_CACHE_NO_CLOCK,
+        RESULT_CACHE_CLOCK_TREE,
+        RESULT_CACHE_JITTER_SPECTRUM,
+        RESULT_CACHE_CLOCK_PULSES,
+        RESULT_CACHE_FRAME_LENGTHS,
+        RESULT_CACHE_SAMPLE_RATE_SEGMENTS
+    };
+    static const char* ResultCacheBlockerString( ResultCacheBlocker blocker );
     virtual bool NeedsRerun();
 
 #pragma warning( push )
@@ -25,22 +44,114 @@ class I2sTestalyser : public Analyzer2
     disable : 4251 ) // warning C4251: 'I2sTestalyser::<...>' : class <...> needs to have dll-interface to be used by clients of class
 
   protected: // functions
+    // where the result cache replay left the channels, so the live decode carries on from there rather than skip a frame.
+    enum ReplayPosition
+    {
+        REPLAY_NONE,
+        REPLAY_AT_BIT,        // mLastData and mLastFrame hold a bit in the middle of a frame
+        REPLAY_AT_FRAME_END,  // the last bit of a frame was read
+        REPLAY_AT_FRAME_START // mCurrentData and mCurrentFrame hold the first bit of a frame
+    };
+
     void AnalyzeSubFrame( U32 starting_index, U32 num_bits, U32 subframe_index );
     void AnalyzeFrame();
+    void ProcessWord( U64 result, U64 starting_sample, U64 ending_sample, U32 subframe_index );
+    void AddOrderedFrame( const Frame& frame, const FrameV2& frame_v2, const char* name );
+    void AddReportFrame( I2sResultType type, U8 flags, U64 data1, U64 data2, U64 sample_number, const FrameV2& frame_v2,
+                         const char* name );
+    void AddReportFrameV2( const FrameV2& frame_v2, const char* name, U64 sample_number );
+    void AddFaultMapFrame( U32 channel, U64 sample_number );
+    void ReportError( const Frame& frame, U32 channel, int bit_slip );
+    void FlushStaleErrorRange( U64 sample_number );
+    void FlushErrorRange();
+    void AddChannelError( const Frame& frame, U32 channel );
+    void AddAudioQualityFrame( const AudioQualityAnalysis::Result& quality, U64 sample_number );
+    void AddLevelFrame( const LevelStatistics::Summary& summary, const char* scope, U64 sample_number );
+    void AddLevelTotalFrames( U64 sample_number );
+    void ProcessReference( U64 result, U64 starting_sample, U64 ending_sample, U32 subframe_index );
+    void AddReferenceFrame( const ReferenceCompare::Event& event, U64 sample_number );
+    void ProcessLockStep( U64 result, U64 starting_sample, U64 ending_sample, U32 subframe_index );
+    void AddLockStepFrame( const LockStepCheck::Event& event, U64 sample_number );
+    void ProcessSequence( U64 result, U64 starting_sample, U64 ending_sample, U32 subframe_index );
+    void AddSequenceFrame( const SequenceCheck::Event& event, U64 sample_number );
+    void AddStartupFrame( const StartupTiming::Cycle& cycle, U64 sample_number );
+    void AddClockRecoveryFrames( U64 sample_number );
+    void MonitorClockTree( U64 frame_edge, U64 bclk_edge, U64 limit );
+    void AddClockTreeFrames( U64 sample_number );
+    void AddJitterSpectrumFrames( U64 sample_number );
+    void MeasureClockPulse();
+    void AddClockPulseFrames( U64 sample_number );
+    void AddFrameLengthFrames( U64 sample_number );
+    void StartRateSegment();
+    void AddSampleRateFrames( U64 sample_number );
+    U64 ReadOutputWord( U32 starting_index, U32 num_bits );
+    void ProcessLatency( U64 result, U32 starting_index, U32 num_bits );
+    void AddLatencyFrame( const LoopbackLatency::Summary& summary, U64 sample_number );
+    bool CanUseResultCache( ResultCacheBlocker& blocker );
+    void AddResultCacheUnusedFrame( ResultCacheBlocker blocker, U64 sample_number );
+    U64 GetResultCacheKey();
+    void AddResultCacheRecord( ResultCache::RecordKind kind, const Frame& frame, U32 subframe_index, U64 transitions );
+    bool IsReplayableRecord( const ResultCache::Record& record, U64 position );
+    bool ReplayToCachedBit( U64 sample_number, U64 transitions, ReplayPosition position );
+    bool ReplayResultCacheRecord( const ResultCache::Record& record );
+    void ReplayResultCache();
+    void SetupDecodeRange();
+    void DetectFormat();
+    void SkipToEndOfCapture();
+    void OnDataExhausted();
+    void FlushReports();
+    void CheckForClockGap();
+    void AddClockGapFrame();
     void SetupForGettingFirstFrame();
     void GetFrame();
     void SetupForGettingFirstBit();
     void GetNextBit( BitState& data, BitState& frame, U64& sample_number );
+    void GetNextRecoveredBit( BitState& data, BitState& frame, U64& sample_number );
 
   protected:
     std::auto_ptr<I2sTestalyserSettings> mSettings;
+    I2sFrameFormat mFormat; // the decoder reads the format from here, not from mSettings
     std::auto_ptr<I2sTestalyserResults> mResults;
     bool mSimulationInitilized;
     I2sSimulationTestDataGenerator mSimulationDataGenerator;
 
-    AnalyzerChannelData* mClock;
+    AnalyzerChannelData* mClock; // NULL when the bit clock is recovered from DATA and FRAME
     AnalyzerChannelData* mFrame;
     AnalyzerChannelData* mData;
+    AnalyzerChannelData* mTimebase; // CLOCK, or FRAME without it: progress, the decode start and startup timing follow it
+
+    ClockRecovery mRecovery;
+    std::vector<ClockRecovery::Report> mRecoveryReports; // made while reading a frame's bits, added after it
+
+    // clock tree monitor, mMasterClock is NULL when it isn't monitored.
+    AnalyzerChannelData* mMasterClock;
+    U64 mMasterClockTransitions;
+    U64 mClockTreeBits; // bits since the last FRAME rising edge
+    ClockTreeMonitor mClockTree;
+    std::vector<ClockTreeMonitor::Event> mClockTreeEvents; // made while reading a frame's bits, added after it
+    std::vector<ClockTreeMonitor::Report> mClockTreeReports;
+
+    JitterSpectrum mJitter;
+    std::vector<JitterSpectrum::Report> mJitterReports; // made while reading a frame's bits, added after it
+
+    ClockPulseMonitor mClockPulses;
+    std::vector<ClockPulseMonitor::Glitch> mClockGlitches; // made while reading a frame's bits, added after it
+    std::vector<ClockPulseMonitor::Report> mClockPulseReports;
+
+    FrameLengthTracker mFrameLengths;
+    std::vector<FrameLengthTracker::Slip> mFrameSlips;
+    std::vector<FrameLengthTracker::Report> mFrameLengthReports; // made while analysing a frame, added after it
+
+    SampleRateTracker mSampleRates;
+    std::vector<SampleRateTracker::Segment> mRateSegments; // ended while analysing a frame, added after it
+    std::vector<SampleRateTracker::Change> mRateChanges;
+
+    // loopback output stream, mOutputClock and mOutputFrame are NULL when it shares CLOCK and FRAME.
+    AnalyzerChannelData* mOutputClock;
+    AnalyzerChannelData* mOutputFrame;
+    AnalyzerChannelData* mOutputData;
+    OutputStreamDecoder mOutputDecoder;
+    std::vector<OutputStreamDecoder::Word> mOutputWords;
 
     AnalyzerResults::MarkerType mArrowMarker;
 
@@ -54,9 +165,59 @@ class I2sTestalyser : public Analyzer2
 
     std::vector<BitState> mDataBits;
     std::vector<U64> mDataValidEdges;
+    std::vector<U64> mDataValidTransitions; // mTransitions at each data valid edge
 
     TestExtension mTest;
 
+    // Errors of the same kind are merged into one range until a gap of mErrorMergeGapSamples, whichever channel they are on: a glitch
+    // usually hits both channels, and their errors alternate.
+    struct ChannelErrors
+    {
+        U64 mCount;
+        U64 mFirstSample;
+        U64 mLastSample;
+    };
+    struct PendingErrorRange
+    {
+        Frame mFirst;
+        U32 mChannel; // of the first error
+        int mBitSlip;
+        U64 mLastSample;
+        U64 mCount;
+        std::vector<ChannelErrors> mChannels; // indexed by channel, mCount 0 for a channel without errors
+    };
+    PendingErrorRange mErrorRange;
+    U64 mErrorMergeGapSamples;
+
+    U64 mLevelWordsSinceTotals;
+    std::vector<ReferenceCompare::Event> mReferenceEvents;
+    std::vector<LockStepCheck::Event> mLockStepEvents;
+    std::vector<LockStepCheck::Mismatch> mLockStepMismatches;
+    std::vector<SequenceCheck::Event> mSequenceEvents;
+    StartupTiming::Cycle mStartupCycle; // completed during the frame being analysed, added at its end
+    bool mStartupReportPending;
+    U64 mLastAnalyzedSample;
+    bool mReportsFlushed; // by OnDataExhausted, at mReportsFlushedSample
+    U64 mReportsFlushedSample;
+
+    // clock gap detection
+    S64 mBitPeriod;
+    U64 mLastDataValidSample;
+    bool mClockGapPending;
+    U64 mClockGapStart;
+    U64 mClockGapEnd;
+
+    U64 mDecodeStartSample;
+    U64 mDecodeEndSample;
+
+    ResultCache mCache;
+    U64 mTransitions;             // CLOCK, DATA and FRAME transitions walked so far
+    U64 mBitTransitions;          // mTransitions at the data valid edge of the last bit
+    U64 mCacheTransitions;        // mBitTransitions at the last cache record
+    bool mCacheFrameStartPending; // the next record is the first of its frame
+    ReplayPosition mReplayPosition;
+    U64 mReplayStretch; // samples, the longest a matching cache record moved the channels
+
 #pragma warning( pop )
 };
 
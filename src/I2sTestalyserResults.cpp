@@ -19,6 +19,170 @@ I2sTestalyserResults::~I2sTestalyserResults()
 {
 }
 
+const char* I2sTestalyserResults::ErrorTypeString( I2sResultType type )
+{
+    switch( type )
+    {
+    case ErrorTooFewBits:
+        return "too few bits";
+    case ErrorDoesntDivideEvenly:
+        return "bits don't divide evenly";
+    case TestError:
+        return "test error";
+    default:
+        return "unknown";
+    }
+}
+
+// ReferenceEvent frames: mData1 is the reference frame, mData2 the ReferenceCompare::EventKind above the frames dropped or repeated.
+void I2sTestalyserResults::ReferenceEventString( const Frame& frame, char* str, U32 size )
+{
+    unsigned long long position = frame.mData1;
+    unsigned long long frames = frame.mData2 & 0xFFFFFFFF;
+    switch( ReferenceCompare::EventKind( frame.mData2 >> 32 ) )
+    {
+    case ReferenceCompare::EVENT_LOCKED:
+        snprintf( str, size, "locked at frame %llu", position );
+        break;
+    case ReferenceCompare::EVENT_DROP:
+        snprintf( str, size, "%llu frames dropped at frame %llu", frames, position );
+        break;
+    case ReferenceCompare::EVENT_REPEAT:
+        snprintf( str, size, "%llu frames repeated at frame %llu", frames, position );
+        break;
+    case ReferenceCompare::EVENT_LOCK_LOST:
+        snprintf( str, size, "lock lost at frame %llu", position );
+        break;
+    case ReferenceCompare::EVENT_REFERENCE_END:
+        snprintf( str, size, "end of reference" );
+        break;
+    default:
+        snprintf( str, size, "file error" );
+        break;
+    }
+}
+
+// LockStepEvent frames: mData1 is the channel above the LockStepCheck::State, mData2 the skew or the channel carried.
+void I2sTestalyserResults::LockStepEventString( const Frame& frame, char* str, U32 size )
+{
+    unsigned channel = unsigned( frame.mData1 >> 32 );
+    long long value = S64( frame.mData2 );
+    switch( LockStepCheck::State( frame.mData1 & 0xFFFFFFFF ) )
+    {
+    case LockStepCheck::STATE_IN_STEP:
+        snprintf( str, size, "ch%u in step", channel );
+        break;
+    case LockStepCheck::STATE_SKEWED:
+        snprintf( str, size, "ch%u %s by %lld frames", channel, value > 0 ? "late" : "early", value > 0 ? value : -value );
+        break;
+    case LockStepCheck::STATE_SWAPPED:
+        snprintf( str, size, "ch%u carries ch%lld", channel, value );
+        break;
+    default:
+        snprintf( str, size, "ch%u mismatch", channel );
+        break;
+    }
+}
+
+// SequenceEvent frames: mData1 is the sequence number, mData2 the SequenceCheck::Kind above the frames dropped or late.
+void I2sTestalyserResults::SequenceEventString( const Frame& frame, char* str, U32 size )
+{
+    unsigned long long sequence = frame.mData1;
+    unsigned long long frames = frame.mData2 & 0xFFFFFFFF;
+    switch( SequenceCheck::Kind( frame.mData2 >> 32 ) )
+    {
+    case SequenceCheck::KIND_DROP:
+        snprintf( str, size, "%llu frames dropped from %llu", frames, sequence );
+        break;
+    case SequenceCheck::KIND_DUPLICATE:
+        snprintf( str, size, "frame %llu duplicated", sequence );
+        break;
+    case SequenceCheck::KIND_REORDER:
+        snprintf( str, size, "frame %llu late by %llu frames", sequence, frames );
+        break;
+    case SequenceCheck::KIND_CORRUPTION:
+        snprintf( str, size, "frame %llu corrupted", sequence );
+        break;
+    default:
+        snprintf( str, size, "words too narrow" );
+        break;
+    }
+}
+
+// ClockTreeEvent frames: mData1 is the ClockTreeMonitor::Kind, mData2 the previous value above the current one. The values are
+// counts, or phases in millionths of a period.
+void I2sTestalyserResults::ClockTreeEventString( const Frame& frame, char* str, U32 size )
+{
+    unsigned previous = unsigned( frame.mData2 >> 32 );
+    unsigned current = unsigned( frame.mData2 & 0xFFFFFFFF );
+    switch( ClockTreeMonitor::Kind( frame.mData1 ) )
+    {
+    case ClockTreeMonitor::KIND_MCLK_RATIO:
+        snprintf( str, size, "MCLK per FRAME %u -> %u", previous, current );
+        break;
+    case ClockTreeMonitor::KIND_BCLK_RATIO:
+        snprintf( str, size, "CLOCK per FRAME %u -> %u", previous, current );
+        break;
+    case ClockTreeMonitor::KIND_MCLK_PHASE:
+        snprintf( str, size, "MCLK phase slip %.3f -> %.3f", previous / 1e6, current / 1e6 );
+        break;
+    default:
+        snprintf( str, size, "CLOCK phase slip %.3f -> %.3f", previous / 1e6, current / 1e6 );
+        break;
+    }
+}
+
+// ClockTreeReport frames: mData1 is the MCLK above the CLOCK periods per FRAME period, mData2 the ratio changes above the phase
+// slips.
+void I2sTestalyserResults::ClockTreeReportString( const Frame& frame, char* str, U32 size )
+{
+    snprintf( str, size, "%u MCLK, %u CLOCK per FRAME, %u ratio changes, %u phase slips", unsigned( frame.mData1 >> 32 ),
+              unsigned( frame.mData1 & 0xFFFFFFFF ), unsigned( frame.mData2 >> 32 ), unsigned( frame.mData2 & 0xFFFFFFFF ) );
+}
+
+// JitterSpectrumReport frames: mData1 is the rms jitter in ps, mData2 the frequency of the largest spur in Hz, 0 without spurs.
+void I2sTestalyserResults::JitterSpectrumString( const Frame& frame, char* str, U32 size )
+{
+    if( frame.mData2 == 0 )
+        snprintf( str, size, "%.3f ns rms", double( frame.mData1 ) / 1000.0 );
+    else
+        snprintf( str, size, "%.3f ns rms, spur at %llu Hz", double( frame.mData1 ) / 1000.0, ( unsigned long long )frame.mData2 );
+}
+
+// ClockGlitch frames: mData1 is the shortest pulse in ps, mData2 its level (1 high) above the number of short pulses.
+void I2sTestalyserResults::ClockGlitchString( const Frame& frame, char* str, U32 size )
+{
+    snprintf( str, size, "%u short pulses, shortest %.3f ns %s", unsigned( frame.mData2 & 0xFFFFFFFF ), double( frame.mData1 ) / 1000.0,
+              ( frame.mData2 >> 32 ) != 0 ? "high" : "low" );
+}
+
+// ClockPulseReport frames: mData1 is the duty cycle in millionths, mData2 the glitches in the report period.
+void I2sTestalyserResults::ClockPulseString( const Frame& frame, char* str, U32 size )
+{
+    snprintf( str, size, "duty cycle %.3f %%, %llu glitches", double( frame.mData1 ) / 1e4, ( unsigned long long )frame.mData2 );
+}
+
+// FrameLengthReport frames: mData1 is the established bit count, mData2 the slips in the report period.
+void I2sTestalyserResults::FrameLengthString( const Frame& frame, char* str, U32 size )
+{
+    snprintf( str, size, "%llu bits, %llu slips", ( unsigned long long )frame.mData1, ( unsigned long long )frame.mData2 );
+}
+
+// SampleRateChange frames: mData1 is the new rate in mHz, mData2 the previous one, 0 for the first rate.
+void I2sTestalyserResults::SampleRateString( const Frame& frame, char* str, U32 size )
+{
+    if( frame.mData2 == 0 )
+        snprintf( str, size, "%.3f Hz", double( frame.mData1 ) / 1000.0 );
+    else
+        snprintf( str, size, "%.3f Hz, was %.3f Hz", double( frame.mData1 ) / 1000.0, double( frame.mData2 ) / 1000.0 );
+}
+
+// SampleRateSegment frames: mData1 is the segment, mData2 its rate in mHz, 0 when no rate was established.
+void I2sTestalyserResults::RateSegmentString( const Frame& frame, char* str, U32 size )
+{
+    snprintf( str, size, "segment %llu at %.3f Hz", ( unsigned long long )frame.mData1, double( frame.mData2 ) / 1000.0 );
+}
+
 void I2sTestalyserResults::GenerateBubbleText( U64 frame_index, Channel& /*channel*/,
                                              DisplayBase display_base ) // unrefereced vars commented out to remove warnings.
 {
@@ -32,14 +196,14 @@ void I2sTestalyserResults::GenerateBubbleText( U64 frame_index, Channel& /*chann
         char number_str[ 128 ];
         if( ( display_base == Decimal ) && ( mSettings->mSigned == AnalyzerEnums::SignedInteger ) )
         {
-            S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber( frame.mData1, mSettings->mBitsPerWord );
+            S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber( frame.mData1, mAnalyzer->GetFrameFormat().mBitsPerWord );
             std::stringstream ss;
             ss << signed_number;
             strcpy( number_str, ss.str().c_str() );
         }
         else
         {
-            AnalyzerHelpers::GetNumberString( frame.mData1, display_base, mSettings->mBitsPerWord, number_str, 128 );
+            AnalyzerHelpers::GetNumberString( frame.mData1, display_base, mAnalyzer->GetFrameFormat().mBitsPerWord, number_str, 128 );
         }
         AddResultString( "1" );
         AddResultString( "Ch 1" );
@@ -51,14 +215,14 @@ void I2sTestalyserResults::GenerateBubbleText( U64 frame_index, Channel& /*chann
         char number_str[ 128 ];
         if( ( display_base == Decimal ) && ( mSettings->mSigned == AnalyzerEnums::SignedInteger ) )
         {
-            S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber( frame.mData1, mSettings->mBitsPerWord );
+            S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber( frame.mData1, mAnalyzer->GetFrameFormat().mBitsPerWord );
             std::stringstream ss;
             ss << signed_number;
             strcpy( number_str, ss.str().c_str() );
         }
         else
         {
-            AnalyzerHelpers::GetNumberString( frame.mData1, display_base, mSettings->mBitsPerWord, number_str, 128 );
+            AnalyzerHelpers::GetNumberString( frame.mData1, display_base, mAnalyzer->GetFrameFormat().mBitsPerWord, number_str, 128 );
         }
         AddResultString( "2" );
         AddResultString( "Ch 2" );
@@ -68,7 +232,7 @@ void I2sTestalyserResults::GenerateBubbleText( U64 frame_index, Channel& /*chann
     case ErrorTooFewBits:
     {
         char bits_per_word[ 32 ];
-        sprintf( bits_per_word, "%d", mSettings->mBitsPerWord );
+        sprintf( bits_per_word, "%d", mAnalyzer->GetFrameFormat().mBitsPerWord );
 
         AddResultString( "!" );
         AddResultString( "Error" );
@@ -86,10 +250,208 @@ void I2sTestalyserResults::GenerateBubbleText( U64 frame_index, Channel& /*chann
     break;
     case TestError:
     {
+        char received_str[ 128 ];
+        char expected_str[ 128 ];
+        AnalyzerHelpers::GetNumberString( frame.mData1, display_base, mAnalyzer->GetFrameFormat().mBitsPerWord, received_str, 128 );
+        AnalyzerHelpers::GetNumberString( frame.mData2, display_base, mAnalyzer->GetFrameFormat().mBitsPerWord, expected_str, 128 );
+
         AddResultString( "!" );
         AddResultString( "Error" );
         AddResultString( "Error: Test error" );
-        AddResultString( "Error: Test error" );
+        AddResultString( "Error: Test error, expected ", expected_str, " got ", received_str );
+    }
+    break;
+    case ErrorRange:
+    {
+        char count_str[ 32 ];
+        sprintf( count_str, "%llu", ( unsigned long long )frame.mData1 );
+
+        AddResultString( "!" );
+        AddResultString( "Errors x", count_str );
+        AddResultString( "Errors x", count_str, ": ", ErrorTypeString( I2sResultType( frame.mData2 ) ) );
+    }
+    break;
+    case ClockGap:
+    {
+        char time_str[ 128 ];
+        AnalyzerHelpers::GetTimeString( frame.mData1, 0, mAnalyzer->GetSampleRate(), time_str, 128 );
+
+        AddResultString( "G" );
+        AddResultString( "Gap" );
+        AddResultString( "Clock gap" );
+        AddResultString( "Clock gap: ", time_str, " s" );
+    }
+    break;
+    case FormatDetected:
+    {
+        char format_str[ 64 ];
+        if( frame.mData1 != 0 )
+            sprintf( format_str, "%llu bits in %llu bit slots", ( unsigned long long )frame.mData1, ( unsigned long long )frame.mData2 );
+        else
+            sprintf( format_str, "not detected" );
+
+        AddResultString( "F" );
+        AddResultString( "Format" );
+        AddResultString( "Format: ", format_str );
+    }
+    break;
+    case ReferenceEvent:
+    {
+        char event_str[ 64 ];
+        ReferenceEventString( frame, event_str, sizeof( event_str ) );
+
+        AddResultString( "R" );
+        AddResultString( "Ref" );
+        AddResultString( "Ref: ", event_str );
+    }
+    break;
+    case LatencyReport:
+    {
+        char latency_str[ 128 ];
+        char jitter_str[ 128 ];
+        AnalyzerHelpers::GetTimeString( frame.mData1, 0, mAnalyzer->GetSampleRate(), latency_str, 128 );
+        AnalyzerHelpers::GetTimeString( frame.mData2, 0, mAnalyzer->GetSampleRate(), jitter_str, 128 );
+
+        AddResultString( "L" );
+        AddResultString( "Latency" );
+        AddResultString( "Latency: ", latency_str, " s" );
+        AddResultString( "Latency: ", latency_str, " s, peak to peak ", jitter_str, " s" );
+    }
+    break;
+    case LockStepEvent:
+    {
+        char event_str[ 64 ];
+        LockStepEventString( frame, event_str, sizeof( event_str ) );
+
+        AddResultString( "S" );
+        AddResultString( "Step" );
+        AddResultString( "Lock-step: ", event_str );
+    }
+    break;
+    case SequenceEvent:
+    {
+        char event_str[ 64 ];
+        SequenceEventString( frame, event_str, sizeof( event_str ) );
+
+        AddResultString( "Q" );
+        AddResultString( "Seq" );
+        AddResultString( "Sequence: ", event_str );
+    }
+    break;
+    case StartupReport:
+    {
+        // mData1 is the time to the last milestone reached, mData2 the cycle above the complete flag.
+        char time_str[ 128 ];
+        AnalyzerHelpers::GetTimeString( frame.mData1, 0, mAnalyzer->GetSampleRate(), time_str, 128 );
+        const char* state = ( frame.mData2 & 1 ) != 0 ? "valid after " : "incomplete after ";
+
+        AddResultString( "B" );
+        AddResultString( "Startup" );
+        AddResultString( "Startup: ", state, time_str, " s" );
+    }
+    break;
+    case ClockRecoveryReport:
+    {
+        // mData1 is the recovered bit rate in Hz, mData2 the rms jitter in ps. Unlocked reports are flagged as warnings.
+        char rate_str[ 64 ];
+        char jitter_str[ 64 ];
+        snprintf( rate_str, sizeof( rate_str ), "%llu Hz", ( unsigned long long )frame.mData1 );
+        snprintf( jitter_str, sizeof( jitter_str ), "%.3f ns", double( frame.mData2 ) / 1000.0 );
+        const char* state = ( frame.mFlags & DISPLAY_AS_WARNING_FLAG ) != 0 ? "unlocked, " : "locked, ";
+
+        AddResultString( "C" );
+        AddResultString( "Clock" );
+        AddResultString( "Clock: ", state, rate_str );
+        AddResultString( "Clock: ", state, rate_str, ", jitter ", jitter_str, " rms" );
+    }
+    break;
+    case ClockTreeEvent:
+    {
+        char event_str[ 64 ];
+        ClockTreeEventString( frame, event_str, sizeof( event_str ) );
+
+        AddResultString( "T" );
+        AddResultString( "Tree" );
+        AddResultString( "Clock tree: ", event_str );
+    }
+    break;
+    case ClockTreeReport:
+    {
+        char report_str[ 128 ];
+        ClockTreeReportString( frame, report_str, sizeof( report_str ) );
+
+        AddResultString( "T" );
+        AddResultString( "Tree" );
+        AddResultString( "Clock tree: ", report_str );
+    }
+    break;
+    case JitterSpectrumReport:
+    {
+        char report_str[ 128 ];
+        JitterSpectrumString( frame, report_str, sizeof( report_str ) );
+
+        AddResultString( "J" );
+        AddResultString( "Jitter" );
+        AddResultString( "Jitter: ", report_str );
+    }
+    break;
+    case ClockGlitch:
+    {
+        char glitch_str[ 128 ];
+        ClockGlitchString( frame, glitch_str, sizeof( glitch_str ) );
+
+        AddResultString( "G" );
+        AddResultString( "Glitch" );
+        AddResultString( "CLOCK glitch: ", glitch_str );
+    }
+    break;
+    case ClockPulseReport:
+    {
+        char report_str[ 128 ];
+        ClockPulseString( frame, report_str, sizeof( report_str ) );
+
+        AddResultString( "D" );
+        AddResultString( "Duty" );
+        AddResultString( "CLOCK: ", report_str );
+    }
+    break;
+    case FrameLengthReport:
+    {
+        char report_str[ 128 ];
+        FrameLengthString( frame, report_str, sizeof( report_str ) );
+
+        AddResultString( "L" );
+        AddResultString( "Length" );
+        AddResultString( "Frame length: ", report_str );
+    }
+    break;
+    case SampleRateChange:
+    {
+        char rate_str[ 128 ];
+        SampleRateString( frame, rate_str, sizeof( rate_str ) );
+
+        AddResultString( "Hz" );
+        AddResultString( "Rate" );
+        AddResultString( "Sample rate: ", rate_str );
+    }
+    break;
+    case SampleRateSegment:
+    {
+        char segment_str[ 128 ];
+        RateSegmentString( frame, segment_str, sizeof( segment_str ) );
+
+        AddResultString( "Seg" );
+        AddResultString( "Segment" );
+        AddResultString( "Rate ", segment_str );
+    }
+    break;
+    case ResultCacheUnused:
+    {
+        const char* reason = I2sTestalyser::ResultCacheBlockerString( I2sTestalyser::ResultCacheBlocker( frame.mData1 ) );
+
+        AddResultString( "C" );
+        AddResultString( "No cache" );
+        AddResultString( "Result cache not used: ", reason );
     }
     break;
     }
@@ -118,14 +480,14 @@ void I2sTestalyserResults::GenerateExportFile( const char* file, DisplayBase dis
             char number_str[ 128 ];
             if( ( display_base == Decimal ) && ( mSettings->mSigned == AnalyzerEnums::SignedInteger ) )
             {
-                S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber( frame.mData1, mSettings->mBitsPerWord );
+                S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber( frame.mData1, mAnalyzer->GetFrameFormat().mBitsPerWord );
                 std::stringstream ss;
                 ss << signed_number;
                 strcpy( number_str, ss.str().c_str() );
             }
             else
             {
-                AnalyzerHelpers::GetNumberString( frame.mData1, display_base, mSettings->mBitsPerWord, number_str, 128 );
+                AnalyzerHelpers::GetNumberString( frame.mData1, display_base, mAnalyzer->GetFrameFormat().mBitsPerWord, number_str, 128 );
             }
 
             ss << time_str << ",1," << number_str << std::endl;
@@ -139,14 +501,14 @@ void I2sTestalyserResults::GenerateExportFile( const char* file, DisplayBase dis
             char number_str[ 128 ];
             if( ( display_base == Decimal ) && ( mSettings->mSigned == AnalyzerEnums::SignedInteger ) )
             {
-                S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber( frame.mData1, mSettings->mBitsPerWord );
+                S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber( frame.mData1, mAnalyzer->GetFrameFormat().mBitsPerWord );
                 std::stringstream ss;
                 ss << signed_number;
                 strcpy( number_str, ss.str().c_str() );
             }
             else
             {
-                AnalyzerHelpers::GetNumberString( frame.mData1, display_base, mSettings->mBitsPerWord, number_str, 128 );
+                AnalyzerHelpers::GetNumberString( frame.mData1, display_base, mAnalyzer->GetFrameFormat().mBitsPerWord, number_str, 128 );
             }
 
 
@@ -180,14 +542,14 @@ void I2sTestalyserResults::GenerateFrameTabularText( U64 frame_index, DisplayBas
         char number_str[ 128 ];
         if( ( display_base == Decimal ) && ( mSettings->mSigned == AnalyzerEnums::SignedInteger ) )
         {
-            S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber( frame.mData1, mSettings->mBitsPerWord );
+            S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber( frame.mData1, mAnalyzer->GetFrameFormat().mBitsPerWord );
             std::stringstream ss;
             ss << signed_number;
             strcpy( number_str, ss.str().c_str() );
         }
         else
         {
-            AnalyzerHelpers::GetNumberString( frame.mData1, display_base, mSettings->mBitsPerWord, number_str, 128 );
+            AnalyzerHelpers::GetNumberString( frame.mData1, display_base, mAnalyzer->GetFrameFormat().mBitsPerWord, number_str, 128 );
         }
 
         AddTabularText( "Ch 1: ", number_str );
@@ -198,14 +560,14 @@ void I2sTestalyserResults::GenerateFrameTabularText( U64 frame_index, DisplayBas
         char number_str[ 128 ];
         if( ( display_base == Decimal ) && ( mSettings->mSigned == AnalyzerEnums::SignedInteger ) )
         {
-            S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber( frame.mData1, mSettings->mBitsPerWord );
+            S64 signed_number = AnalyzerHelpers::ConvertToSignedNumber( frame.mData1, mAnalyzer->GetFrameFormat().mBitsPerWord );
             std::stringstream ss;
             ss << signed_number;
             strcpy( number_str, ss.str().c_str() );
         }
         else
         {
-            AnalyzerHelpers::GetNumberString( frame.mData1, display_base, mSettings->mBitsPerWord, number_str, 128 );
+            AnalyzerHelpers::GetNumberString( frame.mData1, display_base, mAnalyzer->GetFrameFormat().mBitsPerWord, number_str, 128 );
         }
 
         AddTabularText( "Ch 2: ", number_str );
@@ -214,7 +576,7 @@ void I2sTestalyserResults::GenerateFrameTabularText( U64 frame_index, DisplayBas
     case ErrorTooFewBits:
     {
         char bits_per_word[ 32 ];
-        sprintf( bits_per_word, "%d", mSettings->mBitsPerWord );
+        sprintf( bits_per_word, "%d", mAnalyzer->GetFrameFormat().mBitsPerWord );
 
         AddTabularText( "Error: too few bits, expecting ", bits_per_word );
     }
@@ -226,7 +588,166 @@ void I2sTestalyserResults::GenerateFrameTabularText( U64 frame_index, DisplayBas
     break;
     case TestError:
     {
-        AddTabularText( "Error: Test error" );
+        char received_str[ 128 ];
+        char expected_str[ 128 ];
+        AnalyzerHelpers::GetNumberString( frame.mData1, display_base, mAnalyzer->GetFrameFormat().mBitsPerWord, received_str, 128 );
+        AnalyzerHelpers::GetNumberString( frame.mData2, display_base, mAnalyzer->GetFrameFormat().mBitsPerWord, expected_str, 128 );
+
+        AddTabularText( "Error: Test error, expected ", expected_str, " got ", received_str );
+    }
+    break;
+    case ErrorRange:
+    {
+        char count_str[ 32 ];
+        sprintf( count_str, "%llu", ( unsigned long long )frame.mData1 );
+
+        AddTabularText( "Errors x", count_str, ": ", ErrorTypeString( I2sResultType( frame.mData2 ) ) );
+    }
+    break;
+    case ClockGap:
+    {
+        char time_str[ 128 ];
+        AnalyzerHelpers::GetTimeString( frame.mData1, 0, mAnalyzer->GetSampleRate(), time_str, 128 );
+
+        AddTabularText( "Clock gap: ", time_str, " s" );
+    }
+    break;
+    case FormatDetected:
+    {
+        char format_str[ 64 ];
+        if( frame.mData1 != 0 )
+            sprintf( format_str, "%llu bits in %llu bit slots", ( unsigned long long )frame.mData1, ( unsigned long long )frame.mData2 );
+        else
+            sprintf( format_str, "not detected" );
+
+        AddTabularText( "Format: ", format_str );
+    }
+    break;
+    case ReferenceEvent:
+    {
+        char event_str[ 64 ];
+        ReferenceEventString( frame, event_str, sizeof( event_str ) );
+
+        AddTabularText( "Ref: ", event_str );
+    }
+    break;
+    case LatencyReport:
+    {
+        char latency_str[ 128 ];
+        char jitter_str[ 128 ];
+        AnalyzerHelpers::GetTimeString( frame.mData1, 0, mAnalyzer->GetSampleRate(), latency_str, 128 );
+        AnalyzerHelpers::GetTimeString( frame.mData2, 0, mAnalyzer->GetSampleRate(), jitter_str, 128 );
+
+        AddTabularText( "Latency: ", latency_str, " s, peak to peak ", jitter_str, " s" );
+    }
+    break;
+    case LockStepEvent:
+    {
+        char event_str[ 64 ];
+        LockStepEventString( frame, event_str, sizeof( event_str ) );
+
+        AddTabularText( "Lock-step: ", event_str );
+    }
+    break;
+    case SequenceEvent:
+    {
+        char event_str[ 64 ];
+        SequenceEventString( frame, event_str, sizeof( event_str ) );
+
+        AddTabularText( "Sequence: ", event_str );
+    }
+    break;
+    case StartupReport:
+    {
+        char time_str[ 128 ];
+        char cycle_str[ 32 ];
+        AnalyzerHelpers::GetTimeString( frame.mData1, 0, mAnalyzer->GetSampleRate(), time_str, 128 );
+        snprintf( cycle_str, sizeof( cycle_str ), "%u", unsigned( frame.mData2 >> 32 ) );
+        const char* state = ( frame.mData2 & 1 ) != 0 ? " valid after " : " incomplete after ";
+
+        AddTabularText( "Startup cycle ", cycle_str, state, time_str, " s" );
+    }
+    break;
+    case ClockRecoveryReport:
+    {
+        char rate_str[ 64 ];
+        char jitter_str[ 64 ];
+        snprintf( rate_str, sizeof( rate_str ), "%llu Hz", ( unsigned long long )frame.mData1 );
+        snprintf( jitter_str, sizeof( jitter_str ), "%.3f ns", double( frame.mData2 ) / 1000.0 );
+        const char* state = ( frame.mFlags & DISPLAY_AS_WARNING_FLAG ) != 0 ? "unlocked, " : "locked, ";
+
+        AddTabularText( "Recovered clock: ", state, rate_str, ", jitter ", jitter_str, " rms" );
+    }
+    break;
+    case ClockTreeEvent:
+    {
+        char event_str[ 64 ];
+        ClockTreeEventString( frame, event_str, sizeof( event_str ) );
+
+        AddTabularText( "Clock tree: ", event_str );
+    }
+    break;
+    case ClockTreeReport:
+    {
+        char report_str[ 128 ];
+        ClockTreeReportString( frame, report_str, sizeof( report_str ) );
+
+        AddTabularText( "Clock tree: ", report_str );
+    }
+    break;
+    case JitterSpectrumReport:
+    {
+        char report_str[ 128 ];
+        JitterSpectrumString( frame, report_str, sizeof( report_str ) );
+
+        AddTabularText( "Jitter spectrum: ", report_str );
+    }
+    break;
+    case ClockGlitch:
+    {
+        char glitch_str[ 128 ];
+        ClockGlitchString( frame, glitch_str, sizeof( glitch_str ) );
+
+        AddTabularText( "CLOCK glitch: ", glitch_str );
+    }
+    break;
+    case ClockPulseReport:
+    {
+        char report_str[ 128 ];
+        ClockPulseString( frame, report_str, sizeof( report_str ) );
+
+        AddTabularText( "CLOCK pulses: ", report_str );
+    }
+    break;
+    case FrameLengthReport:
+    {
+        char report_str[ 128 ];
+        FrameLengthString( frame, report_str, sizeof( report_str ) );
+
+        AddTabularText( "Frame length: ", report_str );
+    }
+    break;
+    case SampleRateChange:
+    {
+        char rate_str[ 128 ];
+        SampleRateString( frame, rate_str, sizeof( rate_str ) );
+
+        AddTabularText( "Sample rate: ", rate_str );
+    }
+    break;
+    case SampleRateSegment:
+    {
+        char segment_str[ 128 ];
+        RateSegmentString( frame, segment_str, sizeof( segment_str ) );
+
+        AddTabularText( "Rate ", segment_str );
+    }
+    break;
+    case ResultCacheUnused:
+    {
+        const char* reason = I2sTestalyser::ResultCacheBlockerString( I2sTestalyser::ResultCacheBlocker( frame.mData1 ) );
+
+        AddTabularText( "Result cache not used: ", reason );
     }
     break;
     }
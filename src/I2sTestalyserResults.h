@@ -12,7 +12,25 @@ enum I2sResultType
     Channel2,
     ErrorTooFewBits,
     ErrorDoesntDivideEvenly,
-    TestError
+    TestError,
+    ErrorRange,
+    ClockGap,
+    FormatDetected,
+    ReferenceEvent,
+    LatencyReport,
+    LockStepEvent,
+    SequenceEvent,
+    StartupReport,
+    ClockRecoveryReport,
+    ClockTreeEvent,
+    ClockTreeReport,
+    JitterSpectrumReport,
+    ClockGlitch,
+    ClockPulseReport,
+    FrameLengthReport,
+    SampleRateChange,
+    SampleRateSegment,
+    ResultCacheUnused
 };
 
 
@@ -30,6 +48,19 @@ class I2sTestalyserResults : public AnalyzerResults
     virtual void GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base );
 
   protected: // functions
+    const char* ErrorTypeString( I2sResultType type );
+    void ReferenceEventString( const Frame& frame, char* str, U32 size );
+    void LockStepEventString( const Frame& frame, char* str, U32 size );
+    void SequenceEventString( const Frame& frame, char* str, U32 size );
+    void ClockTreeEventString( const Frame& frame, char* str, U32 size );
+    void ClockTreeReportString( const Frame& frame, char* str, U32 size );
+    void JitterSpectrumString( const Frame& frame, char* str, U32 size );
+    void ClockGlitchString( const Frame& frame, char* str, U32 size );
+    void ClockPulseString( const Frame& frame, char* str, U32 size );
+    void FrameLengthString( const Frame& frame, char* str, U32 size );
+    void SampleRateString( const Frame& frame, char* str, U32 size );
+    void RateSegmentString( const Frame& frame, char* str, U32 size );
+
   protected: // vars
     I2sTestalyserSettings* mSettings;
     I2sTestalyser* mAnalyzer;
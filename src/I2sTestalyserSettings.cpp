@@ -20,11 +20,18 @@ I2sTestalyserSettings::I2sTestalyserSettings()
       mFrameType( FRAME_TRANSITION_ONCE_EVERY_WORD ),
       mBitAlignment( BITS_SHIFTED_RIGHT_1 ),
       mSigned( AnalyzerEnums::UnsignedInteger ),
-      mWordSelectInverted( WS_NOT_INVERTED )
+      mWordSelectInverted( WS_NOT_INVERTED ),
+
+      mOutputClockChannel( UNDEFINED_CHANNEL ),
+      mOutputFrameChannel( UNDEFINED_CHANNEL ),
+      mOutputDataChannel( UNDEFINED_CHANNEL ),
+      mMasterClockChannel( UNDEFINED_CHANNEL )
 {
     mClockChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
-    mClockChannelInterface->SetTitleAndTooltip( "CLOCK channel", "Clock, aka I2S SCK - Continuous Serial Clock, aka Bit Clock" );
+    mClockChannelInterface->SetTitleAndTooltip( "CLOCK channel", "Clock, aka I2S SCK - Continuous Serial Clock, aka Bit Clock. "
+                                                                 "None recovers the bit clock from DATA and FRAME." );
     mClockChannelInterface->SetChannel( mClockChannel );
+    mClockChannelInterface->SetSelectionOfNoneIsAllowed( true );
 
     mFrameChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
     mFrameChannelInterface->SetTitleAndTooltip( "FRAME", "Frame Delimiter / aka I2S WS - Word Select, aka Sampling Clock" );
@@ -118,6 +125,35 @@ I2sTestalyserSettings::I2sTestalyserSettings()
         AddInterface( pInterface );
     }
 
+    // TEST_EXTENSION: loopback output stream, decoded with the same format settings.
+    mOutputDataChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
+    mOutputDataChannelInterface->SetTitleAndTooltip( "Output DATA", "DUT output data, for the loopback latency measurement" );
+    mOutputDataChannelInterface->SetChannel( mOutputDataChannel );
+    mOutputDataChannelInterface->SetSelectionOfNoneIsAllowed( true );
+
+    mOutputClockChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
+    mOutputClockChannelInterface->SetTitleAndTooltip( "Output CLOCK", "DUT output clock, if it has its own. None uses CLOCK" );
+    mOutputClockChannelInterface->SetChannel( mOutputClockChannel );
+    mOutputClockChannelInterface->SetSelectionOfNoneIsAllowed( true );
+
+    mOutputFrameChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
+    mOutputFrameChannelInterface->SetTitleAndTooltip( "Output FRAME", "DUT output frame, if it has its own CLOCK. None uses FRAME" );
+    mOutputFrameChannelInterface->SetChannel( mOutputFrameChannel );
+    mOutputFrameChannelInterface->SetSelectionOfNoneIsAllowed( true );
+
+    AddInterface( mOutputDataChannelInterface.get() );
+    AddInterface( mOutputClockChannelInterface.get() );
+    AddInterface( mOutputFrameChannelInterface.get() );
+
+    // TEST_EXTENSION: clock tree monitor.
+    mMasterClockChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
+    mMasterClockChannelInterface->SetTitleAndTooltip( "MCLK", "Master clock. Monitors the MCLK and CLOCK periods per FRAME period, and "
+                                                              "the phase of FRAME against them. None doesn't monitor them" );
+    mMasterClockChannelInterface->SetChannel( mMasterClockChannel );
+    mMasterClockChannelInterface->SetSelectionOfNoneIsAllowed( true );
+
+    AddInterface( mMasterClockChannelInterface.get() );
+
     // AddExportOption( 0, "Export as text/csv file", "text (*.txt);;csv (*.csv)" );
     AddExportOption( 0, "Export as text/csv file" );
     AddExportExtension( 0, "text", "txt" );
@@ -127,6 +163,10 @@ I2sTestalyserSettings::I2sTestalyserSettings()
     AddChannel( mClockChannel, "PCM CLOCK", false );
     AddChannel( mFrameChannel, "PCM FRAME", false );
     AddChannel( mDataChannel, "PCM DATA", false );
+    AddChannel( mOutputDataChannel, "PCM OUTPUT DATA", false );
+    AddChannel( mOutputClockChannel, "PCM OUTPUT CLOCK", false );
+    AddChannel( mOutputFrameChannel, "PCM OUTPUT FRAME", false );
+    AddChannel( mMasterClockChannel, "PCM MCLK", false );
 }
 
 I2sTestalyserSettings::~I2sTestalyserSettings()
@@ -153,16 +193,62 @@ void I2sTestalyserSettings::UpdateInterfacesFromSettings()
 
     // TEST_EXTENSION
     mTestSettings.UpdateInterfacesFromSettings();
+    mOutputDataChannelInterface->SetChannel( mOutputDataChannel );
+    mOutputClockChannelInterface->SetChannel( mOutputClockChannel );
+    mOutputFrameChannelInterface->SetChannel( mOutputFrameChannel );
+    mMasterClockChannelInterface->SetChannel( mMasterClockChannel );
 }
 
-bool I2sTestalyserSettings::SetSettingsFromInterfaces()
+U32 I2sTestalyserSettings::GetChannelsCount() const
 {
-    Channel clock_channel = mClockChannelInterface->GetChannel();
-    if( clock_channel == UNDEFINED_CHANNEL )
+    return GetFrameFormat().GetChannelsCount();
+}
+
+U32 I2sTestalyserSettings::GetChannel1Subframe() const
+{
+    return GetFrameFormat().GetChannel1Subframe();
+}
+
+I2sFrameFormat I2sTestalyserSettings::GetFrameFormat() const
+{
+    I2sFrameFormat format;
+    format.mShiftOrder = mShiftOrder;
+    format.mDataValidEdge = mDataValidEdge;
+    format.mBitsPerWord = mBitsPerWord;
+    format.mWordAlignment = mWordAlignment;
+    format.mFrameType = mFrameType;
+    format.mBitAlignment = mBitAlignment;
+    format.mWordSelectInverted = mWordSelectInverted;
+    return format;
+}
+
+// enum PcmFrameType { FRAME_TRANSITION_TWICE_EVERY_WORD, FRAME_TRANSITION_ONCE_EVERY_WORD, FRAME_TRANSITION_TWICE_EVERY_FOUR_WORDS };
+U32 I2sFrameFormat::GetChannelsCount() const
+{
+    switch( mFrameType )
     {
-        SetErrorText( "Please select a channel for I2S/PCM CLOCK signal" );
-        return false;
+    case FRAME_TRANSITION_TWICE_EVERY_WORD:
+        return 1;
+    case FRAME_TRANSITION_ONCE_EVERY_WORD:
+        return 2;
+    case FRAME_TRANSITION_TWICE_EVERY_FOUR_WORDS:
+        return 4;
+    default:
+        AnalyzerHelpers::Assert( "unexpected" );
+        return 2;
     }
+}
+
+U32 I2sFrameFormat::GetChannel1Subframe() const
+{
+    // the word shown as Channel 1 in I2sTestalyser::ProcessWord(): subframe 1 of a frame unless word select is inverted.
+    return ( GetChannelsCount() > 1 && mWordSelectInverted != WS_INVERTED ) ? 1 : 0;
+}
+
+bool I2sTestalyserSettings::SetSettingsFromInterfaces()
+{
+    // TEST_EXTENSION: no CLOCK recovers the bit clock from DATA and FRAME.
+    Channel clock_channel = mClockChannelInterface->GetChannel();
 
     Channel frame_channel = mFrameChannelInterface->GetChannel();
     if( frame_channel == UNDEFINED_CHANNEL )
@@ -178,7 +264,8 @@ bool I2sTestalyserSettings::SetSettingsFromInterfaces()
         return false;
     }
 
-    if( ( clock_channel == frame_channel ) || ( clock_channel == data_channel ) || ( frame_channel == data_channel ) )
+    if( ( clock_channel != UNDEFINED_CHANNEL && ( clock_channel == frame_channel || clock_channel == data_channel ) ) ||
+        ( frame_channel == data_channel ) )
     {
         SetErrorText( "Please select different channels for the I2S/PCM signals" );
         return false;
@@ -204,12 +291,57 @@ bool I2sTestalyserSettings::SetSettingsFromInterfaces()
     // TEST_EXTENSION
     mTestSettings.SetSettingsFromInterfaces();
 
+    if( mTestSettings.mDecodeRange != DECODE_WHOLE_CAPTURE && mTestSettings.mDecodeEndUs <= mTestSettings.mDecodeStartUs )
+    {
+        SetErrorText( "Please set a decode window end after its start" );
+        return false;
+    }
+
+    Channel output_data_channel = mOutputDataChannelInterface->GetChannel();
+    Channel output_clock_channel = mOutputClockChannelInterface->GetChannel();
+    Channel output_frame_channel = mOutputFrameChannelInterface->GetChannel();
+    Channel master_clock_channel = mMasterClockChannelInterface->GetChannel();
+    if( mTestSettings.mLoopbackReportInterval != 0 && output_data_channel == UNDEFINED_CHANNEL )
+    {
+        SetErrorText( "Please select an Output DATA channel for the loopback latency measurement" );
+        return false;
+    }
+
+    if( ( output_clock_channel == UNDEFINED_CHANNEL ) != ( output_frame_channel == UNDEFINED_CHANNEL ) )
+    {
+        SetErrorText( "Please select both Output CLOCK and Output FRAME, or neither to use CLOCK and FRAME" );
+        return false;
+    }
+
+    Channel channels[] = { clock_channel,        frame_channel,        data_channel,        output_data_channel,
+                           output_clock_channel, output_frame_channel, master_clock_channel };
+    for( U32 i = 3; i < 7; i++ )
+    {
+        for( U32 j = 0; j < i; j++ )
+        {
+            if( channels[ i ] != UNDEFINED_CHANNEL && channels[ i ] == channels[ j ] )
+            {
+                SetErrorText( "Please select different channels for the I2S/PCM signals" );
+                return false;
+            }
+        }
+    }
+
+    mOutputDataChannel = output_data_channel;
+    mOutputClockChannel = output_clock_channel;
+    mOutputFrameChannel = output_frame_channel;
+    mMasterClockChannel = master_clock_channel;
+
     // AddExportOption( 0, "Export as text/csv file", "text (*.txt);;csv (*.csv)" );
 
     ClearChannels();
-    AddChannel( mClockChannel, "PCM CLOCK", true );
+    AddChannel( mClockChannel, "PCM CLOCK", mClockChannel != UNDEFINED_CHANNEL );
     AddChannel( mFrameChannel, "PCM FRAME", true );
     AddChannel( mDataChannel, "PCM DATA", true );
+    AddChannel( mOutputDataChannel, "PCM OUTPUT DATA", mOutputDataChannel != UNDEFINED_CHANNEL );
+    AddChannel( mOutputClockChannel, "PCM OUTPUT CLOCK", mOutputClockChannel != UNDEFINED_CHANNEL );
+    AddChannel( mOutputFrameChannel, "PCM OUTPUT FRAME", mOutputFrameChannel != UNDEFINED_CHANNEL );
+    AddChannel( mMasterClockChannel, "PCM MCLK", mMasterClockChannel != UNDEFINED_CHANNEL );
 
     return true;
 }
@@ -249,10 +381,28 @@ void I2sTestalyserSettings::LoadSettings( const char* settings )
     // TEST_EXTENSION
     mTestSettings.LoadSettings( text_archive );
 
+    Channel output_data_channel;
+    Channel output_clock_channel;
+    Channel output_frame_channel;
+    if( ( text_archive >> output_data_channel ) && ( text_archive >> output_clock_channel ) && ( text_archive >> output_frame_channel ) )
+    {
+        mOutputDataChannel = output_data_channel;
+        mOutputClockChannel = output_clock_channel;
+        mOutputFrameChannel = output_frame_channel;
+    }
+
+    Channel master_clock_channel;
+    if( text_archive >> master_clock_channel )
+        mMasterClockChannel = master_clock_channel;
+
     ClearChannels();
-    AddChannel( mClockChannel, "PCM CLOCK", true );
+    AddChannel( mClockChannel, "PCM CLOCK", mClockChannel != UNDEFINED_CHANNEL );
     AddChannel( mFrameChannel, "PCM FRAME", true );
     AddChannel( mDataChannel, "PCM DATA", true );
+    AddChannel( mOutputDataChannel, "PCM OUTPUT DATA", mOutputDataChannel != UNDEFINED_CHANNEL );
+    AddChannel( mOutputClockChannel, "PCM OUTPUT CLOCK", mOutputClockChannel != UNDEFINED_CHANNEL );
+    AddChannel( mOutputFrameChannel, "PCM OUTPUT FRAME", mOutputFrameChannel != UNDEFINED_CHANNEL );
+    AddChannel( mMasterClockChannel, "PCM MCLK", mMasterClockChannel != UNDEFINED_CHANNEL );
 
     UpdateInterfacesFromSettings();
 }
@@ -281,6 +431,10 @@ const char* I2sTestalyserSettings::SaveSettings()
 
     // TEST_EXTENSION
     mTestSettings.SaveSettings( text_archive );
+    text_archive << mOutputDataChannel;
+    text_archive << mOutputClockChannel;
+    text_archive << mOutputFrameChannel;
+    text_archive << mMasterClockChannel;
 
     return SetReturnString( text_archive.GetString() );
 }
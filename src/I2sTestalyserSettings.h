@@ -26,6 +26,22 @@ enum PcmWordSelectInverted
     WS_NOT_INVERTED
 };
 
+// TEST_EXTENSION: the frame format a decode runs with. It starts as the settings, and format detection may replace it for the run:
+// the settings stay as the user chose them.
+struct I2sFrameFormat
+{
+    U32 GetChannelsCount() const;
+    U32 GetChannel1Subframe() const;
+
+    AnalyzerEnums::ShiftOrder mShiftOrder;
+    AnalyzerEnums::EdgeDirection mDataValidEdge;
+    U32 mBitsPerWord;
+    PcmWordAlignment mWordAlignment;
+    PcmFrameType mFrameType;
+    PcmBitAlignment mBitAlignment;
+    PcmWordSelectInverted mWordSelectInverted;
+};
+
 class I2sTestalyserSettings : public AnalyzerSettings
 {
   public:
@@ -39,6 +55,10 @@ class I2sTestalyserSettings : public AnalyzerSettings
 
     void UpdateInterfacesFromSettings();
 
+    U32 GetChannelsCount() const; // Number of words (subframes) decoded for each FRAME period.
+    U32 GetChannel1Subframe() const; // The subframe shown as Channel 1, channel 0 of the tests that look at whole frames.
+    I2sFrameFormat GetFrameFormat() const;
+
     Channel mClockChannel;
     Channel mFrameChannel;
     Channel mDataChannel;
@@ -57,6 +77,14 @@ class I2sTestalyserSettings : public AnalyzerSettings
     // TEST_EXTENSION
     TestExtensionSettings mTestSettings;
 
+    // TEST_EXTENSION: loopback output stream. The clock and frame are UNDEFINED_CHANNEL when it shares CLOCK and FRAME.
+    Channel mOutputClockChannel;
+    Channel mOutputFrameChannel;
+    Channel mOutputDataChannel;
+
+    // TEST_EXTENSION: master clock of the clock tree monitor, UNDEFINED_CHANNEL when it isn't monitored.
+    Channel mMasterClockChannel;
+
   protected:
     std::auto_ptr<AnalyzerSettingInterfaceChannel> mClockChannelInterface;
     std::auto_ptr<AnalyzerSettingInterfaceChannel> mFrameChannelInterface;
@@ -73,4 +101,10 @@ class I2sTestalyserSettings : public AnalyzerSettings
     std::auto_ptr<AnalyzerSettingInterfaceNumberList> mSignedInterface;
 
     std::auto_ptr<AnalyzerSettingInterfaceNumberList> mWordSelectInvertedInterface;
+
+    std::auto_ptr<AnalyzerSettingInterfaceChannel> mOutputClockChannelInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceChannel> mOutputFrameChannelInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceChannel> mOutputDataChannelInterface;
+
+    std::auto_ptr<AnalyzerSettingInterfaceChannel> mMasterClockChannelInterface;
 };
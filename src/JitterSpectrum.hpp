@@ -0,0 +1,348 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+#include "Fft.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define JITTER_SPECTRUM_REPORT_BLOCKS 16 // blocks between reports
+#define JITTER_SPECTRUM_BANDS 5          // below 1 kHz, then decades up to 1 MHz, then above it
+#define JITTER_SPECTRUM_SPURS 5          // most spurs in a report
+#define JITTER_SPECTRUM_LOBE_BINS 2      // bins either side of a peak in the main lobe of the Hann window
+#define JITTER_SPECTRUM_SPUR_RATIO 10.0  // power of a spur's main lobe over the noise floor in the same bins
+
+/**
+ * @brief Spectrum of the time interval error (TIE) of the data valid clock edges.
+ *
+ * The edges are collected in blocks of a fixed number of edges. Each block is fitted with an ideal clock, a straight line through
+ * the edge times by least squares, and the distance of each edge from the line is its TIE. The fit takes out the frequency offset
+ * of each block, so only jitter and wander faster than a block are left. The TIE of a block is windowed (Hann) and run through an
+ * FFT, and the power of the blocks is averaged into a jitter spectrum with one bin per edge rate / block size.
+ *
+ * A report covers JITTER_SPECTRUM_REPORT_BLOCKS blocks: the rms jitter in total and per band, and the largest spurs. A spur is a
+ * local peak whose main lobe holds JITTER_SPECTRUM_SPUR_RATIO times the noise floor, the median bin, in as many bins. The
+ * spectrum averaged over all blocks since the decode started can be written to a CSV file at each report.
+ *
+ * The edge times are whole samples, so the spectrum has a white floor of about 0.29 samples rms from the quantisation.
+ */
+class JitterSpectrum
+{
+  public:
+    struct Spur
+    {
+        double mFrequencyHz;
+        double mRms; // samples, above the noise floor
+    };
+
+    struct Report
+    {
+        U64 mFirstSample;
+        U64 mLastSample;
+        U64 mBlocks;
+        double mBitPeriod; // samples, mean of the fitted clocks
+        double mRms;       // samples
+        double mBandRms[ JITTER_SPECTRUM_BANDS ];
+        U32 mSpurCount;
+        Spur mSpurs[ JITTER_SPECTRUM_SPURS ]; // largest first
+    };
+
+    JitterSpectrum()
+    {
+        setup( 0, 0, std::string() );
+    }
+
+    /**
+     * @param blockSize edges per block, a power of two, 0 disables the spectrum
+     * @param csvFile written with the spectrum since the start at each report, none when empty
+     */
+    void setup( U32 blockSize, U64 sampleRateHz, const std::string& csvFile )
+    {
+        mBlockSize = blockSize;
+        mSampleRateHz = sampleRateHz;
+        mCsvFile = csvFile;
+        mTimes.clear();
+        mPower.clear();
+        mTotalPower.clear();
+        mTotalBlocks = 0;
+        mTotalPeriod = 0.0;
+        mReportStart = 0;
+        startReport( 0 );
+        restart();
+        if( mBlockSize == 0 )
+            return;
+
+        const double pi = 3.14159265358979323846;
+        mWindow.resize( mBlockSize );
+        mWindowPower = 0.0;
+        for( U32 i = 0; i < mBlockSize; i++ )
+        {
+            mWindow[ i ] = 0.5 - 0.5 * cos( 2.0 * pi * double( i ) / double( mBlockSize ) );
+            mWindowPower += mWindow[ i ] * mWindow[ i ];
+        }
+        mFft.setup( mBlockSize );
+        mTimes.resize( mBlockSize );
+        mPower.assign( mBlockSize / 2 + 1, 0.0 );
+        mTotalPower.assign( mBlockSize / 2 + 1, 0.0 );
+    }
+
+    bool enabled() const
+    {
+        return mBlockSize != 0;
+    }
+
+    /**
+     * @brief The clock stopped: drop the block in progress, a block has to be one stretch of clock. The report period carries on.
+     */
+    void restart()
+    {
+        mEdges = 0;
+        mSumTime = 0.0;
+        mSumIndexTime = 0.0;
+    }
+
+    /**
+     * @brief A data valid clock edge.
+     *
+     * @return true when a report period ended, with the report in report
+     */
+    bool edge( U64 sampleNumber, Report& report )
+    {
+        if( mBlockSize == 0 )
+            return false;
+        if( mEdges == 0 )
+        {
+            mBlockStart = sampleNumber;
+            if( mReportStart == 0 )
+                mReportStart = sampleNumber;
+        }
+
+        // relative to the first edge of the block, so the times keep their precision.
+        double time = double( sampleNumber - mBlockStart );
+        mTimes[ mEdges ] = time;
+        mSumTime += time;
+        mSumIndexTime += double( mEdges ) * time;
+        mEdges++;
+        if( mEdges < mBlockSize )
+            return false;
+
+        processBlock();
+        restart();
+        if( mBlocks < JITTER_SPECTRUM_REPORT_BLOCKS )
+            return false;
+        makeReport( sampleNumber, report );
+        startReport( sampleNumber );
+        return true;
+    }
+
+    /**
+     * @brief Report the blocks so far, e.g. when the data ran out. The block in progress is left for more data, and the period
+     *        carries on: it is reported again, from its start, when it ends.
+     *
+     * @return false if no block completed since the period was last reported
+     */
+    bool flush( U64 sampleNumber, Report& report )
+    {
+        if( mBlockSize == 0 || mBlocks == mReportedBlocks )
+            return false;
+        makeReport( sampleNumber, report );
+        mReportedBlocks = mBlocks;
+        return true;
+    }
+
+    static const char* bandName( U32 band )
+    {
+        static const char* names[ JITTER_SPECTRUM_BANDS ] = { "below_1khz", "1khz_10khz", "10khz_100khz", "100khz_1mhz", "above_1mhz" };
+        return names[ band ];
+    }
+
+  protected:
+    void processBlock()
+    {
+        // least squares fit of time = mean + period * ( index - mean index ).
+        double n = double( mBlockSize );
+        double mean_index = ( n - 1.0 ) / 2.0;
+        double mean_time = mSumTime / n;
+        double index_variance = n * ( n * n - 1.0 ) / 12.0;
+        double period = ( mSumIndexTime - n * mean_index * mean_time ) / index_variance;
+
+        for( U32 i = 0; i < mBlockSize; i++ )
+        {
+            double error = mTimes[ i ] - ( mean_time + period * ( double( i ) - mean_index ) );
+            mFft.set( i, error * mWindow[ i ] );
+        }
+        mFft.transform();
+
+        // one sided, as the TIE variance per bin: Parseval over all bins, corrected for the window power.
+        double scale = 2.0 / ( n * mWindowPower );
+        U32 half = mBlockSize / 2;
+        for( U32 i = 1; i <= half; i++ )
+        {
+            double power = mFft.power( i ) * ( i == half ? scale / 2.0 : scale );
+            mPower[ i ] += power;
+            mTotalPower[ i ] += power;
+        }
+        mBlocks++;
+        mPeriod += period;
+        mTotalBlocks++;
+        mTotalPeriod += period;
+    }
+
+    void startReport( U64 sampleNumber )
+    {
+        mReportStart = sampleNumber;
+        mBlocks = 0;
+        mReportedBlocks = 0;
+        mPeriod = 0.0;
+        std::fill( mPower.begin(), mPower.end(), 0.0 );
+    }
+
+    void makeReport( U64 sampleNumber, Report& report )
+    {
+        U32 half = mBlockSize / 2;
+        double blocks = double( mBlocks );
+        double period = mPeriod / blocks;
+        double bin_hz = period > 0.0 ? double( mSampleRateHz ) / period / double( mBlockSize ) : 0.0;
+
+        report.mFirstSample = mReportStart;
+        report.mLastSample = sampleNumber;
+        report.mBlocks = mBlocks;
+        report.mBitPeriod = period;
+
+        // the mean over the blocks, the sums carry on should the period be flushed before it ends.
+        double total = 0.0;
+        double bands[ JITTER_SPECTRUM_BANDS ] = {};
+        mMeanPower.assign( mPower.size(), 0.0 );
+        for( U32 i = 1; i <= half; i++ )
+        {
+            mMeanPower[ i ] = mPower[ i ] / blocks;
+            total += mMeanPower[ i ];
+            bands[ band( double( i ) * bin_hz ) ] += mMeanPower[ i ];
+        }
+        report.mRms = sqrt( total );
+        for( U32 i = 0; i < JITTER_SPECTRUM_BANDS; i++ )
+            report.mBandRms[ i ] = sqrt( bands[ i ] );
+
+        findSpurs( bin_hz, report );
+        writeCsv();
+    }
+
+    static U32 band( double frequencyHz )
+    {
+        U32 index = 0;
+        for( double edge = 1e3; index < JITTER_SPECTRUM_BANDS - 1 && frequencyHz >= edge; edge *= 10.0 )
+            index++;
+        return index;
+    }
+
+    void findSpurs( double binHz, Report& report )
+    {
+        U32 half = mBlockSize / 2;
+        report.mSpurCount = 0;
+
+        // the noise floor is the median bin, spurs hardly move it.
+        mScratch.assign( mMeanPower.begin() + 1, mMeanPower.end() );
+        std::nth_element( mScratch.begin(), mScratch.begin() + mScratch.size() / 2, mScratch.end() );
+        double floor_power = mScratch[ mScratch.size() / 2 ];
+
+        // peaks by the power in their main lobe, largest first.
+        std::vector<std::pair<double, U32> > peaks;
+        for( U32 i = 2; i < half; i++ )
+        {
+            if( mMeanPower[ i ] <= mMeanPower[ i - 1 ] || mMeanPower[ i ] < mMeanPower[ i + 1 ] )
+                continue;
+            U32 first = std::max<U32>( i - JITTER_SPECTRUM_LOBE_BINS, 1 );
+            U32 last = std::min<U32>( i + JITTER_SPECTRUM_LOBE_BINS, half );
+            double lobe = 0.0;
+            for( U32 j = first; j <= last; j++ )
+                lobe += mMeanPower[ j ];
+            double lobe_floor = floor_power * double( last - first + 1 );
+            if( lobe > lobe_floor * JITTER_SPECTRUM_SPUR_RATIO )
+                peaks.push_back( std::make_pair( lobe - lobe_floor, i ) );
+        }
+        std::sort( peaks.begin(), peaks.end(), std::greater<std::pair<double, U32> >() );
+
+        U32 taken[ JITTER_SPECTRUM_SPURS ];
+        for( const std::pair<double, U32>& peak : peaks )
+        {
+            if( report.mSpurCount == JITTER_SPECTRUM_SPURS )
+                break;
+            // a smaller peak in the lobe of a larger one is part of it.
+            bool in_lobe = false;
+            for( U32 j = 0; j < report.mSpurCount; j++ )
+            {
+                U32 distance = peak.second > taken[ j ] ? peak.second - taken[ j ] : taken[ j ] - peak.second;
+                in_lobe = in_lobe || distance <= 2 * JITTER_SPECTRUM_LOBE_BINS;
+            }
+            if( in_lobe )
+                continue;
+
+            // the Hann window's main lobe is close to a Gaussian, so a parabola through the log of the bins finds the centre.
+            U32 i = peak.second;
+            double a = log( std::max( mMeanPower[ i - 1 ], 1e-300 ) );
+            double b = log( std::max( mMeanPower[ i ], 1e-300 ) );
+            double c = log( std::max( mMeanPower[ i + 1 ], 1e-300 ) );
+            double denominator = a - 2.0 * b + c;
+            double offset = denominator < 0.0 ? 0.5 * ( a - c ) / denominator : 0.0;
+
+            Spur& spur = report.mSpurs[ report.mSpurCount ];
+            spur.mFrequencyHz = ( double( i ) + offset ) * binHz;
+            spur.mRms = sqrt( peak.first );
+            taken[ report.mSpurCount++ ] = i;
+        }
+    }
+
+    void writeCsv()
+    {
+        if( mCsvFile.empty() || mTotalBlocks == 0 )
+            return;
+        FILE* file = fopen( mCsvFile.c_str(), "w" );
+        if( file == NULL )
+            return;
+
+        double period = mTotalPeriod / double( mTotalBlocks );
+        double bin_hz = double( mSampleRateHz ) / period / double( mBlockSize );
+        double ns_per_sample = 1e9 / double( mSampleRateHz );
+        fprintf( file, "frequency_hz,jitter_rms_ns,jitter_psd_ns2_per_hz\n" );
+        for( U32 i = 1; i < mTotalPower.size(); i++ )
+        {
+            double power = mTotalPower[ i ] / double( mTotalBlocks ) * ns_per_sample * ns_per_sample;
+            fprintf( file, "%.3f,%.6g,%.6g\n", double( i ) * bin_hz, sqrt( power ), power / bin_hz );
+        }
+        fclose( file );
+    }
+
+    U32 mBlockSize;
+    U64 mSampleRateHz;
+    std::string mCsvFile;
+
+    std::vector<double> mWindow;
+    double mWindowPower; // sum of the squared window
+    Fft mFft;
+
+    // block in progress
+    U64 mBlockStart;
+    U32 mEdges;
+    std::vector<double> mTimes; // samples after mBlockStart
+    double mSumTime;
+    double mSumIndexTime;
+
+    // report period
+    U64 mReportStart;
+    U64 mBlocks;
+    U64 mReportedBlocks;            // mBlocks when the period was last flushed
+    double mPeriod;                 // sum of the fitted bit periods
+    std::vector<double> mPower;     // sum of the TIE variance per bin, samples squared
+    std::vector<double> mMeanPower; // mPower over the blocks, at the last report
+
+    // since the decode started, for the CSV file
+    U64 mTotalBlocks;
+    double mTotalPeriod;
+    std::vector<double> mTotalPower;
+
+    std::vector<double> mScratch;
+};
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#define LEVEL_STATISTICS_LANES 4
+
+/**
+ * @brief Running per-channel min / max / mean / RMS, clipping and digital silence statistics of decoded words.
+ *
+ * Words arrive centred on zero, signed or offset binary as the audio analysis sees them, so a full scale word of either polarity
+ * clips, a zero word is silence, and the mean and RMS are those of the signal. Words are buffered per channel and reduced a block
+ * at a time. The reduction keeps LEVEL_STATISTICS_LANES independent
+ * accumulators so the loop has no cross-iteration dependency and vectorises without needing -ffast-math.
+ */
+class LevelStatistics
+{
+  public:
+    struct Summary
+    {
+        U32 mChannel;
+        U64 mFirstSample;
+        U64 mLastSample;
+        U64 mCount;
+        S64 mMin;
+        S64 mMax;
+        double mMean; // fraction of full scale
+        double mRms;  // fraction of full scale
+        U64 mClipped;
+        U64 mLongestSilence; // words
+    };
+
+    LevelStatistics() : mBlockSize( 0 ), mFullScaleMin( 0 ), mFullScaleMax( 0 ), mFullScale( 1.0 )
+    {
+    }
+
+    /**
+     * @param blockSize words per periodic summary, 0 disables the statistics
+     */
+    void setup( U32 channelCount, U32 blockSize, U32 bitsPerWord )
+    {
+        mBlockSize = blockSize;
+        mChannels.assign( channelCount, ChannelStatistics() );
+
+        if( bitsPerWord >= 64 )
+        {
+            mFullScaleMin = std::numeric_limits<S64>::min();
+            mFullScaleMax = std::numeric_limits<S64>::max();
+        }
+        else
+        {
+            mFullScaleMin = -( S64( 1 ) << ( bitsPerWord - 1 ) );
+            mFullScaleMax = ( S64( 1 ) << ( bitsPerWord - 1 ) ) - 1;
+        }
+        mFullScale = ldexp( 1.0, bitsPerWord - 1 );
+
+        for( U32 i = 0; i < channelCount; i++ )
+        {
+            resetTotal( mChannels[ i ].mTotal, i );
+            mChannels[ i ].mWords.reserve( mBlockSize );
+        }
+    }
+
+    bool enabled() const
+    {
+        return mBlockSize != 0;
+    }
+
+    /**
+     * @brief Add one word, centred on zero.
+     *
+     * @return true if this word completed a block, with the block's statistics in block
+     */
+    bool push( U32 channel, S64 value, U64 sampleNumber, Summary& block )
+    {
+        ChannelStatistics& statistics = mChannels.at( channel );
+        if( statistics.mWords.empty() )
+        {
+            statistics.mBlockFirstSample = sampleNumber;
+        }
+        statistics.mWords.push_back( value );
+        statistics.mBlockLastSample = sampleNumber;
+
+        if( statistics.mWords.size() < mBlockSize )
+        {
+            return false;
+        }
+
+        reduceBlock( statistics, channel, block );
+        return true;
+    }
+
+    /**
+     * @brief Fold any partial block into the totals and return the statistics of everything seen so far.
+     */
+    const Summary& total( U32 channel )
+    {
+        ChannelStatistics& statistics = mChannels.at( channel );
+        if( !statistics.mWords.empty() )
+        {
+            Summary block;
+            reduceBlock( statistics, channel, block );
+        }
+        return statistics.mTotal;
+    }
+
+    U32 channelCount() const
+    {
+        return mChannels.size();
+    }
+
+  protected:
+    struct ChannelStatistics
+    {
+        std::vector<S64> mWords;
+        U64 mBlockFirstSample;
+        U64 mBlockLastSample;
+        U64 mSilenceRun;
+        double mSum;
+        double mSumOfSquares;
+        Summary mTotal;
+    };
+
+    void resetTotal( Summary& total, U32 channel )
+    {
+        total.mChannel = channel;
+        total.mFirstSample = 0;
+        total.mLastSample = 0;
+        total.mCount = 0;
+        total.mMin = std::numeric_limits<S64>::max();
+        total.mMax = std::numeric_limits<S64>::min();
+        total.mMean = 0.0;
+        total.mRms = 0.0;
+        total.mClipped = 0;
+        total.mLongestSilence = 0;
+        mChannels[ channel ].mSilenceRun = 0;
+        mChannels[ channel ].mSum = 0.0;
+        mChannels[ channel ].mSumOfSquares = 0.0;
+    }
+
+    void reduceBlock( ChannelStatistics& statistics, U32 channel, Summary& block )
+    {
+        const S64* words = statistics.mWords.data();
+        U32 count = statistics.mWords.size();
+
+        S64 minimum[ LEVEL_STATISTICS_LANES ];
+        S64 maximum[ LEVEL_STATISTICS_LANES ];
+        double sum[ LEVEL_STATISTICS_LANES ];
+        double sumOfSquares[ LEVEL_STATISTICS_LANES ];
+        U64 clipped[ LEVEL_STATISTICS_LANES ];
+        for( U32 lane = 0; lane < LEVEL_STATISTICS_LANES; lane++ )
+        {
+            minimum[ lane ] = std::numeric_limits<S64>::max();
+            maximum[ lane ] = std::numeric_limits<S64>::min();
+            sum[ lane ] = 0.0;
+            sumOfSquares[ lane ] = 0.0;
+            clipped[ lane ] = 0;
+        }
+
+        U32 i = 0;
+        for( ; i + LEVEL_STATISTICS_LANES <= count; i += LEVEL_STATISTICS_LANES )
+        {
+            for( U32 lane = 0; lane < LEVEL_STATISTICS_LANES; lane++ )
+            {
+                S64 word = words[ i + lane ];
+                double value = double( word );
+                minimum[ lane ] = std::min( minimum[ lane ], word );
+                maximum[ lane ] = std::max( maximum[ lane ], word );
+                sum[ lane ] += value;
+                sumOfSquares[ lane ] += value * value;
+                clipped[ lane ] += U64( word <= mFullScaleMin ) | U64( word >= mFullScaleMax );
+            }
+        }
+        for( ; i < count; i++ )
+        {
+            S64 word = words[ i ];
+            double value = double( word );
+            minimum[ 0 ] = std::min( minimum[ 0 ], word );
+            maximum[ 0 ] = std::max( maximum[ 0 ], word );
+            sum[ 0 ] += value;
+            sumOfSquares[ 0 ] += value * value;
+            clipped[ 0 ] += U64( word <= mFullScaleMin ) | U64( word >= mFullScaleMax );
+        }
+
+        block.mChannel = channel;
+        block.mFirstSample = statistics.mBlockFirstSample;
+        block.mLastSample = statistics.mBlockLastSample;
+        block.mCount = count;
+        block.mMin = minimum[ 0 ];
+        block.mMax = maximum[ 0 ];
+        block.mClipped = clipped[ 0 ];
+        double blockSum = sum[ 0 ];
+        double blockSumOfSquares = sumOfSquares[ 0 ];
+        for( U32 lane = 1; lane < LEVEL_STATISTICS_LANES; lane++ )
+        {
+            block.mMin = std::min( block.mMin, minimum[ lane ] );
+            block.mMax = std::max( block.mMax, maximum[ lane ] );
+            block.mClipped += clipped[ lane ];
+            blockSum += sum[ lane ];
+            blockSumOfSquares += sumOfSquares[ lane ];
+        }
+        block.mMean = blockSum / double( count ) / mFullScale;
+        block.mRms = sqrt( blockSumOfSquares / double( count ) ) / mFullScale;
+
+        // Silence runs carry over block borders, so this part stays sequential. All-zero words are digital silence.
+        U64 run = statistics.mSilenceRun;
+        U64 longest = 0;
+        for( i = 0; i < count; i++ )
+        {
+            run = ( words[ i ] == 0 ) ? run + 1 : 0;
+            longest = std::max( longest, run );
+        }
+        statistics.mSilenceRun = run;
+        block.mLongestSilence = longest;
+
+        Summary& total = statistics.mTotal;
+        if( total.mCount == 0 )
+        {
+            total.mFirstSample = block.mFirstSample;
+        }
+        total.mLastSample = block.mLastSample;
+        total.mCount += count;
+        total.mMin = std::min( total.mMin, block.mMin );
+        total.mMax = std::max( total.mMax, block.mMax );
+        total.mClipped += block.mClipped;
+        total.mLongestSilence = std::max( total.mLongestSilence, block.mLongestSilence );
+        statistics.mSum += blockSum;
+        statistics.mSumOfSquares += blockSumOfSquares;
+        total.mMean = statistics.mSum / double( total.mCount ) / mFullScale;
+        total.mRms = sqrt( statistics.mSumOfSquares / double( total.mCount ) ) / mFullScale;
+
+        statistics.mWords.clear();
+    }
+
+    U32 mBlockSize;
+    S64 mFullScaleMin;
+    S64 mFullScaleMax;
+    double mFullScale;
+    std::vector<ChannelStatistics> mChannels;
+};
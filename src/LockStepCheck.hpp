@@ -0,0 +1,273 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+
+#include <algorithm>
+#include <vector>
+
+#define LOCKSTEP_MAX_CHANNELS 16 // lanes of the frame check, frames narrower than this are padded
+#define LOCKSTEP_MAX_SKEW 8      // frames either way a skewed channel is looked for
+
+/**
+ * @brief Checks that the words of each frame keep a fixed relationship: ch[n] == ch[0] + n * step, modulo the word size.
+ *
+ * A step of 0 expects the same value in every slot. A frame is checked in one pass over LOCKSTEP_MAX_CHANNELS lanes, without
+ * branches, so the check costs the same for 2 channels as for a TDM frame. Only a frame that fails is looked at more closely:
+ * - its words are the expected values in another order: the slots are swapped, each slot is reported with the channel it carries
+ * - a channel holds the relationship with channel 0 from up to LOCKSTEP_MAX_SKEW frames earlier or later: it is skewed
+ * - otherwise the channel mismatched
+ * Skews and swaps are reported when a channel's state changes, mismatches for every word.
+ */
+class LockStepCheck
+{
+  public:
+    enum State
+    {
+        STATE_IN_STEP,
+        STATE_SKEWED,
+        STATE_SWAPPED,
+        STATE_MISMATCH
+    };
+
+    struct Event
+    {
+        U32 mChannel;
+        State mState;
+        S64 mValue;        // frames the channel is late by (negative: early) when skewed, the channel it carries when swapped
+        U64 mFirstSample;  // of the frame the state changed on
+        U64 mFrames;       // frames the channel spent in its previous state
+        State mPreviousState;
+    };
+
+    struct Mismatch
+    {
+        U32 mChannel;
+        U64 mExpected;
+        U64 mReceived;
+    };
+
+    LockStepCheck() : mEnabled( false ), mChannelCount( 0 ), mWordMask( ~0ULL ), mStep( 0 )
+    {
+    }
+
+    /**
+     * @param enabled false disables the check, as does a frame of one channel
+     */
+    void setup( U32 channelCount, U32 bitsPerWord, S64 step, bool enabled )
+    {
+        mChannelCount = std::min<U32>( channelCount, LOCKSTEP_MAX_CHANNELS );
+        mEnabled = enabled && mChannelCount > 1;
+        mWordMask = ( bitsPerWord >= 64 ) ? ~0ULL : ( ( 1ULL << bitsPerWord ) - 1 );
+        mStep = U64( step );
+        for( U32 channel = 0; channel < LOCKSTEP_MAX_CHANNELS; channel++ )
+        {
+            mOffsets[ channel ] = ( U64( channel ) * mStep ) & mWordMask;
+            mLaneMask[ channel ] = channel < mChannelCount ? mWordMask : 0;
+        }
+        mChannels.assign( mChannelCount, ChannelState() );
+        restart();
+    }
+
+    bool enabled() const
+    {
+        return mEnabled;
+    }
+
+    /**
+     * @brief Forget the frame in progress and the frame history, e.g. after the clock stopped. Channel states are kept.
+     */
+    void restart()
+    {
+        mHaveFrame = false;
+        mHistory.clear();
+    }
+
+    /**
+     * @brief Add one decoded word, the words of a frame in channel order: channel 0 starts a frame, channel N-1 completes it.
+     *
+     * @return true if this completed a frame that is in step on every channel
+     */
+    bool push( U32 channel, U64 value, U64 sampleNumber, std::vector<Event>& events, std::vector<Mismatch>& mismatches )
+    {
+        if( channel >= mChannelCount )
+            return false;
+        if( channel == 0 )
+        {
+            std::fill( mFrame.mWords, mFrame.mWords + LOCKSTEP_MAX_CHANNELS, 0 );
+            mFrame.mFirstSample = sampleNumber;
+            mHaveFrame = true;
+        }
+        if( !mHaveFrame )
+            return false;
+        mFrame.mWords[ channel ] = value & mWordMask;
+        if( channel + 1 < mChannelCount )
+            return false;
+
+        mHaveFrame = false;
+        bool in_step = check( events, mismatches );
+        mHistory.push_back( mFrame );
+        if( mHistory.size() > LOCKSTEP_MAX_SKEW )
+            mHistory.erase( mHistory.begin() );
+        return in_step;
+    }
+
+  protected:
+    struct Frame
+    {
+        U64 mWords[ LOCKSTEP_MAX_CHANNELS ];
+        U64 mFirstSample;
+    };
+
+    struct ChannelState
+    {
+        ChannelState() : mState( STATE_IN_STEP ), mValue( 0 ), mFrames( 0 )
+        {
+        }
+
+        State mState;
+        S64 mValue;
+        U64 mFrames;
+    };
+
+    U64 expected( U64 base, U32 channel ) const
+    {
+        return ( base + mOffsets[ channel ] ) & mWordMask;
+    }
+
+    bool check( std::vector<Event>& events, std::vector<Mismatch>& mismatches )
+    {
+        // the whole frame in one pass: lanes past the channel count have a zero mask and never fail.
+        U64 failed[ LOCKSTEP_MAX_CHANNELS ];
+        U64 any_failed = 0;
+        U64 base = mFrame.mWords[ 0 ];
+        for( U32 channel = 0; channel < LOCKSTEP_MAX_CHANNELS; channel++ )
+        {
+            failed[ channel ] = ( mFrame.mWords[ channel ] - base - mOffsets[ channel ] ) & mLaneMask[ channel ];
+            any_failed |= failed[ channel ];
+        }
+
+        if( any_failed == 0 )
+        {
+            for( U32 channel = 0; channel < mChannelCount; channel++ )
+                setState( channel, STATE_IN_STEP, 0, events );
+            return true;
+        }
+
+        S32 carried[ LOCKSTEP_MAX_CHANNELS ];
+        if( findSwap( carried ) )
+        {
+            for( U32 channel = 0; channel < mChannelCount; channel++ )
+            {
+                if( carried[ channel ] != S32( channel ) )
+                    setState( channel, STATE_SWAPPED, carried[ channel ], events );
+                else
+                    setState( channel, STATE_IN_STEP, 0, events );
+            }
+            return false;
+        }
+
+        // channel 0 is what the others are measured against.
+        setState( 0, STATE_IN_STEP, 0, events );
+        for( U32 channel = 1; channel < mChannelCount; channel++ )
+        {
+            if( failed[ channel ] == 0 )
+            {
+                setState( channel, STATE_IN_STEP, 0, events );
+                continue;
+            }
+            S64 skew;
+            if( findSkew( channel, skew ) )
+            {
+                setState( channel, STATE_SKEWED, skew, events );
+                continue;
+            }
+            setState( channel, STATE_MISMATCH, 0, events );
+            Mismatch mismatch = { channel, expected( base, channel ), mFrame.mWords[ channel ] };
+            mismatches.push_back( mismatch );
+        }
+        return false;
+    }
+
+    /**
+     * @brief Are the words the expected values of some base in another order? carried is then the channel each slot carries.
+     */
+    bool findSwap( S32* carried ) const
+    {
+        // nothing to tell the channels apart by.
+        if( mStep == 0 )
+            return false;
+
+        for( U32 candidate = 0; candidate < mChannelCount; candidate++ )
+        {
+            // candidate holds channel 0's value, every slot then has to hold a different channel's value.
+            U64 base = mFrame.mWords[ candidate ];
+            U32 seen = 0;
+            U32 channel = 0;
+            for( ; channel < mChannelCount; channel++ )
+            {
+                U32 source = 0;
+                while( source < mChannelCount && mFrame.mWords[ channel ] != expected( base, source ) )
+                    source++;
+                if( source == mChannelCount || ( seen & ( 1U << source ) ) != 0 )
+                    break;
+                seen |= 1U << source;
+                carried[ channel ] = S32( source );
+            }
+            if( channel == mChannelCount )
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Does channel match channel 0 of a frame before or after this one? skew is then how many frames late it is.
+     */
+    bool findSkew( U32 channel, S64& skew ) const
+    {
+        // mHistory.back() is the frame before this one.
+        for( size_t frames = 1; frames <= mHistory.size(); frames++ )
+        {
+            const Frame& earlier = mHistory[ mHistory.size() - frames ];
+            if( mFrame.mWords[ channel ] == expected( earlier.mWords[ 0 ], channel ) )
+            {
+                skew = S64( frames );
+                return true;
+            }
+            if( earlier.mWords[ channel ] == expected( mFrame.mWords[ 0 ], channel ) )
+            {
+                skew = -S64( frames );
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void setState( U32 channel, State state, S64 value, std::vector<Event>& events )
+    {
+        ChannelState& current = mChannels[ channel ];
+        if( current.mState == state && current.mValue == value )
+        {
+            current.mFrames++;
+            return;
+        }
+
+        // every mismatching frame is reported on its own, so only the change into the mismatch state is an event.
+        Event event = { channel, state, value, mFrame.mFirstSample, current.mFrames, current.mState };
+        events.push_back( event );
+        current.mState = state;
+        current.mValue = value;
+        current.mFrames = 1;
+    }
+
+    bool mEnabled;
+    U32 mChannelCount;
+    U64 mWordMask;
+    U64 mStep;
+    U64 mOffsets[ LOCKSTEP_MAX_CHANNELS ];  // n * step
+    U64 mLaneMask[ LOCKSTEP_MAX_CHANNELS ]; // word mask for the lanes in use, 0 for the padding
+
+    Frame mFrame;
+    bool mHaveFrame;
+    std::vector<Frame> mHistory; // the last LOCKSTEP_MAX_SKEW frames, oldest first
+    std::vector<ChannelState> mChannels;
+};
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+#define LOOPBACK_MARKER_WORDS 16 // consecutive words that make up a marker
+#define LOOPBACK_HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+#define LOOPBACK_WINDOW_BASE 0x100000001B3ULL
+
+/**
+ * @brief Input to output latency of a loopback, from a marker (counter, PRBS, ...) that passes through the DUT unchanged.
+ *
+ * Every run of LOOPBACK_MARKER_WORDS input words is hashed and remembered with the sample it ended on, for as long as it could
+ * still come out of the DUT (the maximum latency). Each output word completes a run that is looked up in those, a hit gives the
+ * latency of that word. So memory is bounded by the input words in the maximum latency, however long the capture is.
+ * Runs that are all one value (silence, a stuck line) aren't markers and are skipped on both sides.
+ */
+class LoopbackLatency
+{
+  public:
+    struct Summary
+    {
+        U64 mFirstSample;    // of the first output word in the report
+        U64 mLastSample;     // of the last output word in the report
+        U64 mMatches;        // output words matched in the report
+        U64 mUnmatched;      // output markers not found in the input, in the report
+        U64 mLatency;        // samples, of the last match
+        U64 mMin;            // samples, over the report
+        U64 mMax;            // samples, over the report
+        double mMean;        // samples, over the report
+        double mJitter;      // samples, standard deviation over the report
+        U64 mTotalMin;       // samples, since the start
+        U64 mTotalMax;       // samples, since the start
+        double mFramePeriod; // samples between input words, to express the latency in audio frames
+    };
+
+    LoopbackLatency() : mReportInterval( 0 ), mMaxLatency( 0 )
+    {
+    }
+
+    /**
+     * @param reportInterval matched output words per report, 0 disables the measurement
+     * @param maxLatency samples an input marker is remembered for
+     */
+    void setup( U32 reportInterval, U64 maxLatency )
+    {
+        mReportInterval = reportInterval;
+        mMaxLatency = maxLatency;
+        mMarkers.clear();
+        mExpiry.clear();
+        mInput = Window();
+        mOutput = Window();
+        mFirstInputSample = 0;
+        mLastInputSample = 0;
+        mInputWords = 0;
+        mTotalMin = std::numeric_limits<U64>::max();
+        mTotalMax = 0;
+        startReport();
+    }
+
+    bool enabled() const
+    {
+        return mReportInterval != 0;
+    }
+
+    /**
+     * @brief Forget the runs in progress on both sides, e.g. after the clock stopped. Remembered markers and totals are kept.
+     */
+    void restart()
+    {
+        mInput = Window();
+        mOutput = Window();
+    }
+
+    /**
+     * @param sampleNumber where the word ended
+     */
+    void pushInput( U64 value, U64 sampleNumber )
+    {
+        if( mInputWords++ == 0 )
+            mFirstInputSample = sampleNumber;
+        mLastInputSample = sampleNumber;
+
+        // markers that can't come out any more, the output is never more than mMaxLatency behind the newest input.
+        while( !mExpiry.empty() && mExpiry.front().first + mMaxLatency < sampleNumber )
+        {
+            std::unordered_map<U64, U64>::iterator marker = mMarkers.find( mExpiry.front().second );
+            if( marker != mMarkers.end() && marker->second == mExpiry.front().first )
+                mMarkers.erase( marker );
+            mExpiry.pop_front();
+        }
+
+        if( !mInput.push( value ) )
+            return;
+        // a marker repeating within the window keeps its newest position, so the latency reads short rather than long.
+        mMarkers[ mInput.mHash ] = sampleNumber;
+        mExpiry.push_back( std::make_pair( sampleNumber, mInput.mHash ) );
+    }
+
+    /**
+     * @param sampleNumber where the word ended
+     * @return true when a report completed, with it in summary
+     */
+    bool pushOutput( U64 value, U64 sampleNumber, Summary& summary )
+    {
+        if( !mOutput.push( value ) )
+            return false;
+
+        std::unordered_map<U64, U64>::const_iterator marker = mMarkers.find( mOutput.mHash );
+        if( marker == mMarkers.end() || marker->second > sampleNumber )
+        {
+            mReport.mUnmatched++;
+            return false;
+        }
+
+        U64 latency = sampleNumber - marker->second;
+        if( mReport.mMatches == 0 )
+            mReport.mFirstSample = sampleNumber;
+        mReport.mLastSample = sampleNumber;
+        mReport.mMatches++;
+        mReport.mLatency = latency;
+        mReport.mMin = std::min( mReport.mMin, latency );
+        mReport.mMax = std::max( mReport.mMax, latency );
+        mTotalMin = std::min( mTotalMin, latency );
+        mTotalMax = std::max( mTotalMax, latency );
+
+        // relative to the first latency of the report, so the sums don't lose the jitter to the size of the latency.
+        if( mReport.mMatches == 1 )
+            mOffset = latency;
+        double delta = double( S64( latency - mOffset ) );
+        mSum += delta;
+        mSumSquares += delta * delta;
+
+        if( mReport.mMatches < mReportInterval )
+            return false;
+
+        summary = mReport;
+        double count = double( mReport.mMatches );
+        double mean = mSum / count;
+        summary.mMean = double( mOffset ) + mean;
+        summary.mJitter = sqrt( std::max( mSumSquares / count - mean * mean, 0.0 ) );
+        summary.mTotalMin = mTotalMin;
+        summary.mTotalMax = mTotalMax;
+        summary.mFramePeriod = mInputWords > 1 ? double( mLastInputSample - mFirstInputSample ) / double( mInputWords - 1 ) : 0.0;
+        startReport();
+        return true;
+    }
+
+  protected:
+    /**
+     * @brief Rolling hash of the last LOOPBACK_MARKER_WORDS words.
+     */
+    struct Window
+    {
+        Window() : mHash( 0 ), mCount( 0 ), mNext( 0 ), mLastValue( 0 ), mRun( 0 )
+        {
+        }
+
+        /**
+         * @return true if the last LOOPBACK_MARKER_WORDS words are a marker, mHash is then its hash
+         */
+        bool push( U64 value )
+        {
+            U64 hash = ( value ^ ( value >> 29 ) ) * LOOPBACK_HASH_MULTIPLIER;
+            mHash = mHash * LOOPBACK_WINDOW_BASE + hash;
+            if( mCount == LOOPBACK_MARKER_WORDS )
+                mHash -= mHashes[ mNext ] * windowPower();
+            else
+                mCount++;
+            mHashes[ mNext ] = hash;
+            mNext = ( mNext + 1 ) % LOOPBACK_MARKER_WORDS;
+
+            mRun = ( mRun != 0 && value == mLastValue ) ? mRun + 1 : 1;
+            mLastValue = value;
+            return mCount == LOOPBACK_MARKER_WORDS && mRun < LOOPBACK_MARKER_WORDS;
+        }
+
+        static U64 windowPower()
+        {
+            U64 power = 1;
+            for( U32 i = 0; i < LOOPBACK_MARKER_WORDS; i++ )
+                power *= LOOPBACK_WINDOW_BASE;
+            return power;
+        }
+
+        U64 mHash;
+        U64 mHashes[ LOOPBACK_MARKER_WORDS ];
+        U32 mCount;
+        U32 mNext;
+        U64 mLastValue;
+        U32 mRun; // words in a row equal to mLastValue
+    };
+
+    void startReport()
+    {
+        mReport = Summary();
+        mReport.mMin = std::numeric_limits<U64>::max();
+        mOffset = 0;
+        mSum = 0.0;
+        mSumSquares = 0.0;
+    }
+
+    U32 mReportInterval;
+    U64 mMaxLatency;
+
+    std::unordered_map<U64, U64> mMarkers;      // marker hash -> sample its last input word ended on
+    std::deque<std::pair<U64, U64> > mExpiry;   // (sample, marker hash) in input order
+    Window mInput;
+    Window mOutput;
+    U64 mFirstInputSample;
+    U64 mLastInputSample;
+    U64 mInputWords;
+
+    Summary mReport;
+    U64 mOffset;
+    double mSum;
+    double mSumSquares;
+    U64 mTotalMin;
+    U64 mTotalMax;
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <AnalyzerChannelData.h>
+#include <AnalyzerTypes.h>
+#include "I2sTestalyserSettings.h"
+
+#include <vector>
+
+/**
+ * @brief Decodes a second I2S/PCM stream with its own CLOCK and FRAME, in the format of the main decode.
+ *
+ * The main decode drives this one: decodeUntil() only walks clock edges up to a sample number, and never waits for data that
+ * isn't in the capture yet, so the two streams stay level without a thread of their own. There is no clock gap handling or
+ * error reporting here, frames that don't split into whole words are skipped.
+ */
+class OutputStreamDecoder
+{
+  public:
+    struct Word
+    {
+        U64 mValue;
+        U64 mEndingSample; // data valid edge of the last bit
+        U32 mSubframe;
+    };
+
+    OutputStreamDecoder() : mClock( NULL ), mFrame( NULL ), mData( NULL )
+    {
+    }
+
+    void setup( AnalyzerChannelData* clock, AnalyzerChannelData* frame, AnalyzerChannelData* data, const I2sFrameFormat& format )
+    {
+        mClock = clock;
+        mFrame = frame;
+        mData = data;
+        mValidState = format.mDataValidEdge == AnalyzerEnums::PosEdge ? BIT_HIGH : BIT_LOW;
+        mShifted = format.mBitAlignment == BITS_SHIFTED_RIGHT_1;
+        mRightAligned = format.mWordAlignment == RIGHT_ALIGNED;
+        mLsbFirst = format.mShiftOrder == AnalyzerEnums::LsbFirst;
+        mBitsPerWord = format.mBitsPerWord;
+        mWordsPerFrame = format.GetChannelsCount();
+        restart();
+    }
+
+    /**
+     * @brief Look for the start of a frame again, e.g. after the clock stopped.
+     */
+    void restart()
+    {
+        mBits.clear();
+        mEdges.clear();
+        mHaveLastFrame = false;
+        mSynced = false;
+    }
+
+    /**
+     * @brief Decode the frames that are complete at sampleNumber, appending their words to words.
+     */
+    void decodeUntil( U64 sampleNumber, std::vector<Word>& words )
+    {
+        while( mClock->DoMoreTransitionsExistInCurrentData() && mClock->GetSampleOfNextEdge() <= sampleNumber )
+        {
+            mClock->AdvanceToNextEdge();
+            if( mClock->GetBitState() != mValidState )
+                continue;
+
+            U64 edge = mClock->GetSampleNumber();
+            mData->AdvanceToAbsPosition( edge );
+            mFrame->AdvanceToAbsPosition( edge );
+            addBit( mData->GetBitState(), mFrame->GetBitState(), edge, words );
+        }
+    }
+
+  protected:
+    void addBit( BitState data, BitState frame, U64 edge, std::vector<Word>& words )
+    {
+        bool frame_start = mHaveLastFrame && frame == BIT_HIGH && mLastFrame == BIT_LOW;
+        mLastFrame = frame;
+        mHaveLastFrame = true;
+
+        // as in the main decode: the bit at the FRAME edge starts the frame, or with the one bit shift ends the previous one.
+        if( frame_start && mShifted )
+        {
+            if( mSynced )
+            {
+                mBits.push_back( data );
+                mEdges.push_back( edge );
+                finishFrame( words );
+            }
+            mSynced = true;
+            return;
+        }
+        if( frame_start )
+        {
+            if( mSynced )
+                finishFrame( words );
+            mSynced = true;
+        }
+        if( !mSynced )
+            return;
+        mBits.push_back( data );
+        mEdges.push_back( edge );
+    }
+
+    void finishFrame( std::vector<Word>& words )
+    {
+        U32 num_bits = U32( mBits.size() );
+        U32 bits_per_frame = num_bits / mWordsPerFrame;
+        if( num_bits % mWordsPerFrame == 0 && bits_per_frame >= mBitsPerWord )
+        {
+            U32 starting_offset = mRightAligned ? bits_per_frame - mBitsPerWord : 0;
+            for( U32 i = 0; i < mWordsPerFrame; i++ )
+            {
+                U32 first = i * bits_per_frame + starting_offset;
+                U64 value = 0;
+                for( U32 j = 0; j < mBitsPerWord; j++ )
+                {
+                    if( mBits[ first + j ] == BIT_HIGH )
+                        value |= 1ULL << ( mLsbFirst ? j : mBitsPerWord - 1 - j );
+                }
+                Word word = { value, mEdges[ first + mBitsPerWord - 1 ], i };
+                words.push_back( word );
+            }
+        }
+        mBits.clear();
+        mEdges.clear();
+    }
+
+    AnalyzerChannelData* mClock;
+    AnalyzerChannelData* mFrame;
+    AnalyzerChannelData* mData;
+
+    BitState mValidState;
+    bool mShifted;
+    bool mRightAligned;
+    bool mLsbFirst;
+    U32 mBitsPerWord;
+    U32 mWordsPerFrame;
+
+    std::vector<BitState> mBits;
+    std::vector<U64> mEdges;
+    BitState mLastFrame;
+    bool mHaveLastFrame;
+    bool mSynced;
+};
@@ -0,0 +1,534 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define REFERENCE_MAX_CHANNELS 4
+#define REFERENCE_MAX_OFFSET 32      // frames either way a drop or a repeat is looked for
+#define REFERENCE_RESYNC_FRAMES 4    // frames that have to match again to settle a divergence
+#define REFERENCE_MAX_PENDING 256    // frames a divergence may stay unsettled before the lock is lost
+#define REFERENCE_HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+#define REFERENCE_WINDOW_BASE 0x100000001B3ULL
+
+/**
+ * @brief A reference WAV or raw PCM file, memory mapped and read as the words the decoder would produce for it.
+ *
+ * WAV files must be integer PCM, plain or WAVE_FORMAT_EXTENSIBLE. Raw files are interleaved little endian two's complement with
+ * the decoder's channel count, in the smallest whole number of bytes that holds a word. Samples are taken MSB aligned, so a
+ * reference with more or fewer bits than the decoded words is compared on its top bits.
+ */
+class ReferenceFile
+{
+  public:
+    ReferenceFile()
+        : mMap( NULL ), mMapSize( 0 ), mData( NULL ), mFrames( 0 ), mChannels( 0 ), mContainerBytes( 0 ), mUnsigned( false ),
+          mBitsPerWord( 32 )
+    {
+    }
+
+    ~ReferenceFile()
+    {
+        close();
+    }
+
+    /**
+     * @return false if the file can't be used, see error()
+     */
+    bool open( const std::string& path, U32 channelCount, U32 bitsPerWord )
+    {
+        close();
+        mBitsPerWord = bitsPerWord;
+
+        int fd = ::open( path.c_str(), O_RDONLY );
+        if( fd < 0 )
+            return fail( "can't open " + path );
+        struct stat status;
+        if( fstat( fd, &status ) != 0 || status.st_size == 0 )
+        {
+            ::close( fd );
+            return fail( path + " is empty" );
+        }
+        void* map = mmap( NULL, size_t( status.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+        ::close( fd );
+        if( map == MAP_FAILED )
+            return fail( "can't map " + path );
+        mMap = static_cast<const U8*>( map );
+        mMapSize = U64( status.st_size );
+
+        if( mMapSize >= 12 && memcmp( mMap, "RIFF", 4 ) == 0 && memcmp( mMap + 8, "WAVE", 4 ) == 0 )
+            return parseWav();
+
+        mChannels = channelCount;
+        mContainerBytes = ( bitsPerWord + 7 ) / 8;
+        mUnsigned = false;
+        mData = mMap;
+        mFrames = mMapSize / ( mChannels * mContainerBytes );
+        return checkFormat();
+    }
+
+    void close()
+    {
+        if( mMap != NULL )
+            munmap( const_cast<U8*>( mMap ), size_t( mMapSize ) );
+        mMap = NULL;
+        mMapSize = 0;
+        mData = NULL;
+        mFrames = 0;
+    }
+
+    U64 frames() const
+    {
+        return mFrames;
+    }
+
+    U32 channels() const
+    {
+        return mChannels;
+    }
+
+    const std::string& error() const
+    {
+        return mError;
+    }
+
+    U64 word( U64 frame, U32 channel ) const
+    {
+        const U8* sample = mData + ( frame * mChannels + channel ) * mContainerBytes;
+        U64 value = 0;
+        for( U32 i = 0; i < mContainerBytes; i++ )
+            value |= U64( sample[ i ] ) << ( 8 * i );
+        // 8 bit WAV samples are offset binary.
+        if( mUnsigned )
+            value ^= 0x80;
+
+        U32 container_bits = mContainerBytes * 8;
+        if( container_bits > mBitsPerWord )
+            value >>= container_bits - mBitsPerWord;
+        else
+            value <<= mBitsPerWord - container_bits;
+        return mBitsPerWord >= 64 ? value : value & ( ( 1ULL << mBitsPerWord ) - 1 );
+    }
+
+  protected:
+    static U32 le16( const U8* p )
+    {
+        return U32( p[ 0 ] ) | ( U32( p[ 1 ] ) << 8 );
+    }
+
+    static U32 le32( const U8* p )
+    {
+        return le16( p ) | ( le16( p + 2 ) << 16 );
+    }
+
+    bool fail( const std::string& error )
+    {
+        close();
+        mError = error;
+        return false;
+    }
+
+    bool parseWav()
+    {
+        bool have_format = false;
+        U64 offset = 12;
+        while( offset + 8 <= mMapSize )
+        {
+            const U8* chunk = mMap + offset;
+            U32 size = le32( chunk + 4 );
+            const U8* body = chunk + 8;
+            U64 available = std::min<U64>( size, mMapSize - offset - 8 );
+
+            if( memcmp( chunk, "fmt ", 4 ) == 0 && available >= 16 )
+            {
+                U32 format = le16( body );
+                // WAVE_FORMAT_EXTENSIBLE, the format is the first two bytes of the sub format GUID.
+                if( format == 0xFFFE && available >= 26 )
+                    format = le16( body + 24 );
+                if( format != 1 )
+                    return fail( "only integer PCM WAV files are supported" );
+                mChannels = le16( body + 2 );
+                U32 block_align = le16( body + 12 );
+                if( mChannels == 0 || block_align % mChannels != 0 )
+                    return fail( "invalid WAV format chunk" );
+                mContainerBytes = block_align / mChannels;
+                mUnsigned = mContainerBytes == 1;
+                have_format = true;
+            }
+            else if( memcmp( chunk, "data", 4 ) == 0 && have_format )
+            {
+                // a WAV that is still being written may have a data size of 0 or ~0, the file size is what counts.
+                if( size == 0 || size == 0xFFFFFFFF )
+                    available = mMapSize - offset - 8;
+                mData = body;
+                mFrames = available / ( mChannels * mContainerBytes );
+                return checkFormat();
+            }
+            offset += 8 + U64( size ) + ( size & 1 );
+        }
+        return fail( "no PCM data in the WAV file" );
+    }
+
+    bool checkFormat()
+    {
+        if( mContainerBytes == 0 || mContainerBytes > 8 )
+            return fail( "unsupported sample size" );
+        if( mFrames == 0 )
+            return fail( "no samples in the reference file" );
+        return true;
+    }
+
+    const U8* mMap;
+    U64 mMapSize;
+    const U8* mData;
+    U64 mFrames;
+    U32 mChannels;
+    U32 mContainerBytes;
+    bool mUnsigned;
+    U32 mBitsPerWord;
+    std::string mError;
+};
+
+/**
+ * @brief Compares the decoded frames with a reference file the DUT is playing.
+ *
+ * Until locked, the last N decoded frames are hashed and looked up in an index of the reference, which holds a window of N frames
+ * at every N/2th frame. So the lock is found within N + N/2 frames of the stream matching, without scanning the reference.
+ * Once locked every frame is compared with the next reference frame. A frame that differs starts a divergence, which is settled
+ * as soon as REFERENCE_RESYNC_FRAMES decoded frames match the reference again within REFERENCE_MAX_OFFSET frames of where they
+ * were expected: frames before that point are mismatched, and the offset is a drop (reference frames missing from the stream)
+ * or a repeat (frames played again). A divergence that isn't settled in REFERENCE_MAX_PENDING frames loses the lock.
+ */
+class ReferenceCompare
+{
+  public:
+    enum EventKind
+    {
+        EVENT_LOCKED,
+        EVENT_MISMATCH,
+        EVENT_DROP,
+        EVENT_REPEAT,
+        EVENT_LOCK_LOST,
+        EVENT_REFERENCE_END,
+        EVENT_ERROR
+    };
+
+    struct Event
+    {
+        EventKind mKind;
+        U64 mFirstSample; // first decoded frame involved
+        U64 mPosition;    // reference frame
+        U64 mFrames;      // frames dropped or repeated
+        U32 mChannel;     // of a mismatch
+        U64 mExpected;
+        U64 mReceived;
+    };
+
+    struct Totals
+    {
+        U64 mFrames; // decoded frames compared while locked
+        U64 mMismatches[ REFERENCE_MAX_CHANNELS ];
+        U64 mDropped;
+        U64 mRepeated;
+        U64 mLockLosses;
+    };
+
+    ReferenceCompare() : mEnabled( false ), mChannelCount( 0 ), mCompared( 0 ), mLockFrames( 0 ), mStride( 1 )
+    {
+    }
+
+    /**
+     * @param lockFrames frames that have to match to lock, 0 disables the comparison
+     * @return false if the reference file can't be used, see error()
+     */
+    bool setup( const std::string& path, U32 channelCount, U32 bitsPerWord, U32 lockFrames )
+    {
+        mEnabled = false;
+        mIndex.clear();
+        mWindow.clear();
+        mWindowHash = 0;
+        mPending.clear();
+        mHaveFrame = false;
+        mLocked = false;
+        memset( &mTotals, 0, sizeof( mTotals ) );
+        if( lockFrames == 0 )
+            return true;
+        if( !mReference.open( path, channelCount, bitsPerWord ) )
+            return false;
+
+        mChannelCount = std::min<U32>( channelCount, REFERENCE_MAX_CHANNELS );
+        mCompared = std::min( mChannelCount, mReference.channels() );
+        mLockFrames = lockFrames;
+        mStride = std::max<U32>( lockFrames / 2, 1 );
+        mWindowPower = 1;
+        for( U32 i = 0; i < mLockFrames; i++ )
+            mWindowPower *= REFERENCE_WINDOW_BASE;
+        buildIndex();
+        mEnabled = true;
+        return true;
+    }
+
+    bool enabled() const
+    {
+        return mEnabled;
+    }
+
+    const std::string& error() const
+    {
+        return mReference.error();
+    }
+
+    const Totals& totals() const
+    {
+        return mTotals;
+    }
+
+    /**
+     * @brief Add one decoded word, the words of a frame in channel order: channel 0 starts a frame, channel N-1 completes it.
+     *
+     * Events are appended to events once they are settled, which can be up to REFERENCE_MAX_PENDING frames later than the words
+     * they are about.
+     */
+    void push( U32 channel, U64 value, U64 sampleNumber, std::vector<Event>& events )
+    {
+        if( channel >= mChannelCount )
+            return;
+        if( channel == 0 )
+        {
+            mFrame.mFirstSample = sampleNumber;
+            mHaveFrame = true;
+        }
+        if( !mHaveFrame )
+            return;
+        mFrame.mWords[ channel ] = value;
+        if( channel + 1 < mChannelCount )
+            return;
+
+        mHaveFrame = false;
+        mFrame.mHash = frameHash( mFrame.mWords );
+        if( mLocked )
+            compare( mFrame, events );
+        else
+            acquire( mFrame, events );
+    }
+
+  protected:
+    struct DecodedFrame
+    {
+        U64 mWords[ REFERENCE_MAX_CHANNELS ];
+        U64 mHash;
+        U64 mFirstSample;
+    };
+
+    U64 frameHash( const U64* words ) const
+    {
+        U64 hash = 0;
+        for( U32 channel = 0; channel < mCompared; channel++ )
+        {
+            hash = ( hash ^ words[ channel ] ) * REFERENCE_HASH_MULTIPLIER;
+            hash ^= hash >> 29;
+        }
+        return hash;
+    }
+
+    U64 referenceHash( U64 position ) const
+    {
+        U64 words[ REFERENCE_MAX_CHANNELS ];
+        for( U32 channel = 0; channel < mCompared; channel++ )
+            words[ channel ] = mReference.word( position, channel );
+        return frameHash( words );
+    }
+
+    bool matches( const DecodedFrame& frame, U64 position ) const
+    {
+        for( U32 channel = 0; channel < mCompared; channel++ )
+        {
+            if( frame.mWords[ channel ] != mReference.word( position, channel ) )
+                return false;
+        }
+        return true;
+    }
+
+    void buildIndex()
+    {
+        // rolling hash of the last mLockFrames frame hashes, kept at every mStride-th window start.
+        U64 frames = mReference.frames();
+        mIndex.reserve( size_t( frames / mStride + 1 ) );
+        U64 window = 0;
+        for( U64 position = 0; position < frames; position++ )
+        {
+            window = window * REFERENCE_WINDOW_BASE + referenceHash( position );
+            if( position >= mLockFrames )
+                window -= referenceHash( position - mLockFrames ) * mWindowPower;
+            if( position + 1 >= mLockFrames && ( position + 1 - mLockFrames ) % mStride == 0 )
+                mIndex.push_back( std::make_pair( window, position + 1 - mLockFrames ) );
+        }
+        std::sort( mIndex.begin(), mIndex.end() );
+    }
+
+    void addToWindow( const DecodedFrame& frame )
+    {
+        mWindowHash = mWindowHash * REFERENCE_WINDOW_BASE + frame.mHash;
+        mWindow.push_back( frame );
+        if( mWindow.size() > mLockFrames )
+        {
+            mWindowHash -= mWindow.front().mHash * mWindowPower;
+            mWindow.pop_front();
+        }
+    }
+
+    void acquire( const DecodedFrame& frame, std::vector<Event>& events )
+    {
+        addToWindow( frame );
+        if( mWindow.size() < mLockFrames )
+            return;
+
+        std::vector<std::pair<U64, U64> >::const_iterator entry =
+            std::lower_bound( mIndex.begin(), mIndex.end(), std::make_pair( mWindowHash, U64( 0 ) ) );
+        for( ; entry != mIndex.end() && entry->first == mWindowHash; ++entry )
+        {
+            U64 start = entry->second;
+            U32 i = 0;
+            while( i < mLockFrames && matches( mWindow[ i ], start + i ) )
+                i++;
+            if( i < mLockFrames )
+                continue;
+
+            addEvent( events, EVENT_LOCKED, mWindow.front().mFirstSample, start );
+            mTotals.mFrames += mLockFrames;
+            mLocked = true;
+            mPosition = start + mLockFrames;
+            mWindow.clear();
+            mWindowHash = 0;
+            checkReferenceEnd( frame, events );
+            return;
+        }
+    }
+
+    void compare( const DecodedFrame& frame, std::vector<Event>& events )
+    {
+        if( mPending.empty() && matches( frame, mPosition ) )
+        {
+            mTotals.mFrames++;
+            mPosition++;
+            checkReferenceEnd( frame, events );
+            return;
+        }
+
+        mPending.push_back( frame );
+        if( mPending.size() >= REFERENCE_RESYNC_FRAMES && settle( events ) )
+        {
+            checkReferenceEnd( frame, events );
+            return;
+        }
+        if( mPending.size() < REFERENCE_MAX_PENDING )
+            return;
+
+        // too far out of step, look for the stream in the whole reference again, starting from the frames just seen.
+        addEvent( events, EVENT_LOCK_LOST, mPending.front().mFirstSample, mPosition );
+        mTotals.mLockLosses++;
+        mLocked = false;
+        mWindowHash = 0;
+        size_t keep = std::min<size_t>( mPending.size(), mLockFrames );
+        for( size_t i = mPending.size() - keep; i < mPending.size(); i++ )
+            addToWindow( mPending[ i ] );
+        mPending.clear();
+    }
+
+    /**
+     * @brief Try to explain the pending frames: some mismatched frames, then the rest in step at an offset from mPosition.
+     *
+     * Only the newest placement of the resync run needs testing, the earlier ones were tested as the frames came in.
+     */
+    bool settle( std::vector<Event>& events )
+    {
+        U64 mismatched = mPending.size() - REFERENCE_RESYNC_FRAMES;
+        for( S64 step = 0; step <= 2 * REFERENCE_MAX_OFFSET; step++ )
+        {
+            // 0, +1, -1, +2, -2 ...
+            S64 offset = ( step & 1 ) ? ( step + 1 ) / 2 : -step / 2;
+            S64 start = S64( mPosition + mismatched ) + offset;
+            if( start < 0 || U64( start ) + REFERENCE_RESYNC_FRAMES > mReference.frames() )
+                continue;
+            U32 i = 0;
+            while( i < REFERENCE_RESYNC_FRAMES && matches( mPending[ mismatched + i ], U64( start ) + i ) )
+                i++;
+            if( i < REFERENCE_RESYNC_FRAMES )
+                continue;
+
+            for( U64 j = 0; j < mismatched && mPosition + j < mReference.frames(); j++ )
+                addMismatches( events, mPending[ j ], mPosition + j );
+            if( offset > 0 )
+            {
+                addEvent( events, EVENT_DROP, mPending[ mismatched ].mFirstSample, mPosition + mismatched, offset );
+                mTotals.mDropped += offset;
+            }
+            else if( offset < 0 )
+            {
+                addEvent( events, EVENT_REPEAT, mPending[ mismatched ].mFirstSample, mPosition + mismatched, -offset );
+                mTotals.mRepeated += -offset;
+            }
+            mTotals.mFrames += mPending.size();
+            mPosition = U64( start ) + REFERENCE_RESYNC_FRAMES;
+            mPending.clear();
+            return true;
+        }
+        return false;
+    }
+
+    void checkReferenceEnd( const DecodedFrame& frame, std::vector<Event>& events )
+    {
+        if( mPosition < mReference.frames() )
+            return;
+        // played to the end, the DUT may start the file again.
+        addEvent( events, EVENT_REFERENCE_END, frame.mFirstSample, mPosition );
+        mLocked = false;
+        mPending.clear();
+    }
+
+    void addMismatches( std::vector<Event>& events, const DecodedFrame& frame, U64 position )
+    {
+        for( U32 channel = 0; channel < mCompared; channel++ )
+        {
+            U64 expected = mReference.word( position, channel );
+            if( frame.mWords[ channel ] == expected )
+                continue;
+            Event event = { EVENT_MISMATCH, frame.mFirstSample, position, 0, channel, expected, frame.mWords[ channel ] };
+            events.push_back( event );
+            mTotals.mMismatches[ channel ]++;
+        }
+    }
+
+    void addEvent( std::vector<Event>& events, EventKind kind, U64 firstSample, U64 position, U64 frames = 0 )
+    {
+        Event event = { kind, firstSample, position, frames, 0, 0, 0 };
+        events.push_back( event );
+    }
+
+    ReferenceFile mReference;
+    bool mEnabled;
+    U32 mChannelCount; // words per decoded frame
+    U32 mCompared;     // channels in both the stream and the reference
+    U32 mLockFrames;
+    U32 mStride;
+    U64 mWindowPower; // REFERENCE_WINDOW_BASE ^ mLockFrames
+    std::vector<std::pair<U64, U64> > mIndex; // (window hash, first frame)
+
+    DecodedFrame mFrame;
+    bool mHaveFrame = false;
+    std::deque<DecodedFrame> mWindow; // the last frames, while not locked
+    U64 mWindowHash = 0;
+    bool mLocked = false;
+    U64 mPosition = 0; // next reference frame expected
+    std::deque<DecodedFrame> mPending;
+    Totals mTotals;
+};
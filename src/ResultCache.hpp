@@ -0,0 +1,366 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#define RESULT_CACHE_MAGIC 0x4548434143533249ULL // "I2SCACHE"
+#define RESULT_CACHE_VERSION 4
+#define RESULT_CACHE_CHECK_BASIS 0x811c9dc5U // FNV-1a, 32 bits, over the bytes of a frame's records
+#define RESULT_CACHE_CHECK_PRIME 0x01000193U
+
+/**
+ * @brief On-disk cache of the decoded word stream, so a re-run over the same capture doesn't have to walk the clock edges bit by bit.
+ *
+ * One file per key, the key being a hash of everything that changes which words are decoded: the decode settings, the sample rate
+ * and a fingerprint of where the capture starts. Presentation settings (signed/unsigned, channel naming, the test) are applied when the
+ * words are replayed, so changing them keeps the cache. Every record also holds the number of CLOCK, DATA and FRAME transitions since
+ * the previous record, which the replay checks against the capture, so a key collision is caught at the first record that differs.
+ * The first record of a frame also holds the frame's first bit and the transitions up to it, checked before the replay moves into
+ * the frame: should the capture differ up to there, the live decode takes over at that very frame.
+ *
+ * Records are packed: a flags byte, the samples as varints from the previous record's end, the transitions as a varint and the word
+ * in as many bytes as the word is wide, so a frame of two 16-bit words takes about 17 bytes. A frame's records are written at once,
+ * the last one flagged and followed by a check byte over them all. The replay only takes whole frames that pass the check, and the
+ * file is cut back to them before it is added to.
+ */
+class ResultCache
+{
+  public:
+    enum RecordKind
+    {
+        RECORD_WORD,
+        RECORD_FRAME_ERROR,
+        RECORD_CLOCK_GAP
+    };
+
+    enum RecordFlags
+    {
+        RECORD_FRAME_LAST = 0x10,  // the last record of a frame, or a clock gap
+        RECORD_FRAME_START = 0x20, // the first record of a frame, mFrameStart and mFrameStartTransitions are set
+        RECORD_FRAME_END = 0x40    // mEnd is the last bit of the frame, the next bit starts a frame
+    };
+
+    struct Record
+    {
+        U64 mFrameStart;            // first bit of the frame
+        U64 mFrameStartTransitions; // CLOCK + DATA + FRAME transitions after the previous record, up to and including mFrameStart
+        U64 mStart;
+        U64 mEnd;
+        U64 mValue;       // word, or the I2sResultType of a frame error
+        U64 mTransitions; // after the frame start or the previous record, up to and including mEnd
+        U8 mKind;
+        U8 mIndex; // subframe index of a word, below 4
+        U8 mFlags;
+    };
+
+    /**
+     * @brief FNV-1a, over the key values one at a time.
+     */
+    class Key
+    {
+      public:
+        Key() : mHash( 0xcbf29ce484222325ULL )
+        {
+        }
+
+        void add( U64 value )
+        {
+            for( U32 i = 0; i < 8; i++ )
+            {
+                mHash ^= ( value >> ( i * 8 ) ) & 0xFF;
+                mHash *= 0x100000001b3ULL;
+            }
+        }
+
+        U64 value() const
+        {
+            return mHash;
+        }
+
+      protected:
+        U64 mHash;
+    };
+
+    ResultCache() : mFile( NULL ), mWriting( false ), mKey( 0 ), mValueBytes( 0 ), mPrevious( 0 ), mReplayedPrevious( 0 ), mReplayedLength( 0 ), mFrameLast( 0 ), mFrameEmpty( true ), mCheck( 0 )
+    {
+    }
+
+    ~ResultCache()
+    {
+        close();
+    }
+
+    /**
+     * @brief Open the cache file for the key in directory, for reading if it exists and has a valid header, otherwise for writing.
+     *
+     * @param bitsPerWord width of the words, part of the key
+     * @return true if there are records to replay
+     */
+    bool open( const std::string& directory, U64 key, U32 bitsPerWord )
+    {
+        close();
+        mKey = key;
+        mValueBytes = ( bitsPerWord + 7 ) / 8;
+        mPrevious = 0;
+
+        char name[ 48 ];
+        snprintf( name, sizeof( name ), "i2s-%016llx.cache", ( unsigned long long )key );
+        mPath = directory;
+        if( !mPath.empty() && mPath[ mPath.size() - 1 ] != '/' && mPath[ mPath.size() - 1 ] != '\\' )
+            mPath += "/";
+        mPath += name;
+
+        mFile = fopen( mPath.c_str(), "rb" );
+        if( mFile != NULL )
+        {
+            U64 header[ 3 ];
+            if( fread( header, sizeof( header ), 1, mFile ) == 1 && header[ 0 ] == RESULT_CACHE_MAGIC &&
+                header[ 1 ] == RESULT_CACHE_VERSION && header[ 2 ] == key )
+            {
+                mWriting = false;
+                mReplayedPrevious = 0;
+                mFrameEmpty = true;
+                mReplayedLength = ftell( mFile );
+                return true;
+            }
+            fclose( mFile );
+            mFile = NULL;
+        }
+
+        startWriting( "wb" );
+        return false;
+    }
+
+    bool isOpen() const
+    {
+        return mFile != NULL;
+    }
+
+    bool isReplaying() const
+    {
+        return mFile != NULL && !mWriting;
+    }
+
+    /**
+     * @return false at the end of the cached records, or at one that is cut short or has flags no version wrote
+     */
+    bool read( Record& record )
+    {
+        if( !isReplaying() )
+            return false;
+        if( mFrameEmpty )
+            mCheck = RESULT_CACHE_CHECK_BASIS;
+        int flags = readByte();
+        if( flags == EOF || ( flags & 0x80 ) != 0 || ( flags & 0x3 ) > RECORD_CLOCK_GAP )
+            return false;
+        record.mKind = U8( flags & 0x3 );
+        record.mIndex = U8( ( flags >> 2 ) & 0x3 );
+        record.mFlags = U8( flags & ( RECORD_FRAME_LAST | RECORD_FRAME_START | RECORD_FRAME_END ) );
+
+        U64 start_delta;
+        U64 span;
+        record.mFrameStart = mPrevious;
+        record.mFrameStartTransitions = 0;
+        if( ( record.mFlags & RECORD_FRAME_START ) != 0 )
+        {
+            U64 frame_start_delta;
+            if( !readVarint( frame_start_delta ) || !readVarint( record.mFrameStartTransitions ) )
+                return false;
+            record.mFrameStart = mPrevious + frame_start_delta;
+        }
+        if( !readVarint( start_delta ) || !readVarint( span ) || !readVarint( record.mTransitions ) )
+            return false;
+        // a clock gap can start before the end of the previous record, the other deltas don't go backwards.
+        record.mStart = record.mFrameStart + U64( S64( start_delta >> 1 ) ^ -S64( start_delta & 1 ) );
+        record.mEnd = record.mStart + span;
+
+        record.mValue = 0;
+        U32 value_bytes = record.mKind == RECORD_WORD ? mValueBytes : record.mKind == RECORD_FRAME_ERROR ? 1 : 0;
+        for( U32 i = 0; i < value_bytes; i++ )
+        {
+            int byte = readByte();
+            if( byte == EOF )
+                return false;
+            record.mValue |= U64( byte ) << ( i * 8 );
+        }
+        // the check byte doesn't go into the check.
+        mFrameEmpty = ( record.mFlags & RECORD_FRAME_LAST ) != 0;
+        if( mFrameEmpty && getc( mFile ) != int( mCheck & 0xFF ) )
+            return false;
+        mPrevious = record.mEnd;
+        return true;
+    }
+
+    /**
+     * @brief The records read so far were replayed, the file is kept up to here.
+     */
+    void replayed()
+    {
+        mReplayedPrevious = mPrevious;
+        mReplayedLength = ftell( mFile );
+    }
+
+    /**
+     * @brief Keep adding to the same file from the last replayed record on. A run stopped in the middle of a write leaves part of a
+     *        frame at the end, and a damaged file has records that can't be replayed: both are cut off first.
+     */
+    void resumeWriting()
+    {
+        fclose( mFile );
+        mFile = NULL;
+        if( truncate( mPath.c_str(), off_t( mReplayedLength ) ) != 0 )
+        {
+            discard();
+            return;
+        }
+        mPrevious = mReplayedPrevious;
+        startWriting( "ab" );
+    }
+
+    /**
+     * @brief The capture doesn't match the cached records, the file is no use to anyone.
+     */
+    void discard()
+    {
+        close();
+        remove( mPath.c_str() );
+    }
+
+    /**
+     * @brief Add a record to the frame in progress, see endFrame().
+     */
+    void write( const Record& record )
+    {
+        if( !mWriting )
+            return;
+
+        U8 buffer[ 64 ];
+        U32 size = 0;
+        buffer[ size++ ] = U8( record.mKind | ( ( record.mIndex & 0x3 ) << 2 ) | record.mFlags );
+        U64 from = mPrevious;
+        if( ( record.mFlags & RECORD_FRAME_START ) != 0 )
+        {
+            size = writeVarint( buffer, size, record.mFrameStart - mPrevious );
+            size = writeVarint( buffer, size, record.mFrameStartTransitions );
+            from = record.mFrameStart;
+        }
+        S64 start_delta = S64( record.mStart - from );
+        size = writeVarint( buffer, size, U64( start_delta << 1 ) ^ U64( start_delta >> 63 ) );
+        size = writeVarint( buffer, size, record.mEnd - record.mStart );
+        size = writeVarint( buffer, size, record.mTransitions );
+        U32 value_bytes = record.mKind == RECORD_WORD ? mValueBytes : record.mKind == RECORD_FRAME_ERROR ? 1 : 0;
+        for( U32 i = 0; i < value_bytes; i++ )
+            buffer[ size++ ] = U8( record.mValue >> ( i * 8 ) );
+        mPrevious = record.mEnd;
+
+        mFrameLast = mFrame.size();
+        mFrame.insert( mFrame.end(), buffer, buffer + size );
+    }
+
+    /**
+     * @brief The frame's records are complete, flag the last one and write them all at once, so the replay can tell a frame that
+     *        was cut short.
+     */
+    void endFrame()
+    {
+        if( !mWriting || mFrame.empty() )
+            return;
+        mFrame[ mFrameLast ] |= RECORD_FRAME_LAST;
+        U32 check = RESULT_CACHE_CHECK_BASIS;
+        for( U8 byte : mFrame )
+            check = ( check ^ byte ) * RESULT_CACHE_CHECK_PRIME;
+        mFrame.push_back( U8( check ) );
+        if( fwrite( &mFrame[ 0 ], mFrame.size(), 1, mFile ) != 1 )
+            discard();
+        mFrame.clear();
+    }
+
+    /**
+     * @brief Make what was decoded so far available to the next run, e.g. while waiting for more data.
+     */
+    void flush()
+    {
+        if( mWriting )
+            fflush( mFile );
+    }
+
+    void close()
+    {
+        mFrame.clear();
+        if( mFile != NULL )
+            fclose( mFile );
+        mFile = NULL;
+        mWriting = false;
+    }
+
+  protected:
+    /**
+     * @brief LEB128, 7 bits a byte with the high bit set on all but the last.
+     */
+    static U32 writeVarint( U8* buffer, U32 size, U64 value )
+    {
+        while( value >= 0x80 )
+        {
+            buffer[ size++ ] = U8( value | 0x80 );
+            value >>= 7;
+        }
+        buffer[ size++ ] = U8( value );
+        return size;
+    }
+
+    /**
+     * @brief A byte of a record, into the frame's check.
+     */
+    int readByte()
+    {
+        int byte = getc( mFile );
+        if( byte != EOF )
+            mCheck = ( mCheck ^ U32( byte ) ) * RESULT_CACHE_CHECK_PRIME;
+        return byte;
+    }
+
+    bool readVarint( U64& value )
+    {
+        value = 0;
+        for( U32 shift = 0; shift < 64; shift += 7 )
+        {
+            int byte = readByte();
+            if( byte == EOF )
+                return false;
+            value |= U64( byte & 0x7F ) << shift;
+            if( ( byte & 0x80 ) == 0 )
+                return true;
+        }
+        return false;
+    }
+
+    void startWriting( const char* mode )
+    {
+        mFile = fopen( mPath.c_str(), mode );
+        mWriting = mFile != NULL;
+        if( mWriting && strcmp( mode, "wb" ) == 0 )
+        {
+            U64 header[ 3 ] = { RESULT_CACHE_MAGIC, RESULT_CACHE_VERSION, mKey };
+            if( fwrite( header, sizeof( header ), 1, mFile ) != 1 )
+                discard();
+        }
+    }
+
+    FILE* mFile;
+    bool mWriting;
+    U64 mKey;
+    U32 mValueBytes;
+    U64 mPrevious; // mEnd of the last record read or written, the deltas are from there
+    U64 mReplayedPrevious;
+    long mReplayedLength;   // of the header and the records replayed
+    std::vector<U8> mFrame; // records of the frame in progress
+    size_t mFrameLast;      // where the last of them starts
+    bool mFrameEmpty;       // no record of the frame being read was read yet
+    U32 mCheck;             // of the frame being read, so far
+    std::string mPath;
+};
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#define SAMPLE_RATE_LOCK_FRAMES 4  // FRAME periods in a row at one rate to establish it
+#define SAMPLE_RATE_TOLERANCE 0.01 // relative FRAME period difference that is still the same rate
+
+/**
+ * @brief Splits the decode into segments of one FRAME rate, the sample rate of the bus, and keeps statistics per segment.
+ *
+ * Each FRAME period is timed from its own bits: the span from the first to the last data valid edge, scaled by the bits in it, so
+ * it needs no FRAME period before it and works straight after a clock gap. A rate is established once SAMPLE_RATE_LOCK_FRAMES
+ * FRAME periods in a row agree within SAMPLE_RATE_TOLERANCE. A FRAME period off the established rate starts a candidate; should
+ * the candidate hold for SAMPLE_RATE_LOCK_FRAMES periods, the segment ends where the candidate started, otherwise its periods are
+ * counted as off rate, e.g. a slipped FRAME period.
+ */
+class SampleRateTracker
+{
+  public:
+    struct Change
+    {
+        U64 mSample;      // first bit of the first FRAME period at the new rate
+        U32 mSegment;     // the segment it starts
+        double mPrevious; // Hz, 0 for the first rate
+        double mRate;     // Hz
+        double mNominal;  // the standard rate it is closest to, 0 if none is within SAMPLE_RATE_TOLERANCE
+    };
+
+    struct Segment
+    {
+        U32 mIndex;
+        U64 mFirstSample;
+        U64 mLastSample;
+        U64 mFrames;
+        U64 mOffRateFrames; // FRAME periods that didn't match the rate, not in the rate statistics
+        U64 mErrors;
+        U64 mClockGaps;
+        double mRate;    // Hz, from the mean FRAME period, 0 when no rate was established
+        double mNominal; // 0 if no standard rate is within SAMPLE_RATE_TOLERANCE
+        double mPpm;     // of mRate against mNominal
+        double mMinRate; // of single FRAME periods, timed to whole samples
+        double mMaxRate;
+    };
+
+    SampleRateTracker() : mEnabled( false ), mSampleRateHz( 0 )
+    {
+        setup( false, 0 );
+    }
+
+    /**
+     * @param sampleRateHz of the capture
+     */
+    void setup( bool enabled, U64 sampleRateHz )
+    {
+        mEnabled = enabled;
+        mSampleRateHz = sampleRateHz;
+        mIndex = 0;
+        mRate = 0.0;
+        mStarted = false;
+        mCandidate = Periods();
+        startSegment( 0 );
+    }
+
+    bool enabled() const
+    {
+        return mEnabled;
+    }
+
+    /**
+     * @brief A FRAME period was read.
+     *
+     * @param sample its first bit
+     * @param span samples from its first to its last bit
+     * @param changes a change is added when a rate is established
+     * @return true when the segment ended at a rate change, with its statistics in segment
+     */
+    bool frame( U64 sample, U64 span, U32 bits, std::vector<Change>& changes, Segment& segment )
+    {
+        if( !mEnabled )
+            return false;
+        if( !mStarted )
+        {
+            mStarted = true;
+            mSegmentStart = sample;
+        }
+        mFrames++;
+        if( bits < 2 || span == 0 )
+        {
+            mOffRateFrames++;
+            return false;
+        }
+
+        double period = double( span ) * double( bits ) / double( bits - 1 );
+        if( mRate > 0.0 && matches( period, mPeriods.mReference ) )
+        {
+            // back at the rate, a candidate in progress was off rate.
+            mOffRateFrames += mCandidate.mCount;
+            mCandidate = Periods();
+            mPeriods.add( period );
+            return false;
+        }
+
+        if( mCandidate.mCount != 0 && !matches( period, mCandidate.mReference ) )
+        {
+            mOffRateFrames += mCandidate.mCount;
+            mCandidate = Periods();
+        }
+        if( mCandidate.mCount == 0 )
+            mCandidateStart = sample;
+        mCandidate.add( period );
+        if( mCandidate.mCount < SAMPLE_RATE_LOCK_FRAMES )
+            return false;
+
+        // the candidate holds: it is the rate of a new segment, or the first rate of this one.
+        bool ended = mRate > 0.0;
+        if( ended )
+        {
+            mFrames -= mCandidate.mCount;
+            makeSegment( mCandidateStart, segment );
+            mIndex++;
+            startSegment( mCandidateStart );
+            mFrames = mCandidate.mCount;
+        }
+        double previous = mRate;
+        mPeriods = mCandidate;
+        mCandidate = Periods();
+        mRate = double( mSampleRateHz ) / mPeriods.mean();
+        Change change = { mCandidateStart, mIndex, previous, mRate, nominal( mRate ) };
+        changes.push_back( change );
+        return ended;
+    }
+
+    /**
+     * @brief An error was reported in the segment.
+     */
+    void error()
+    {
+        if( mEnabled )
+            mErrors++;
+    }
+
+    void clockGap()
+    {
+        if( mEnabled )
+            mClockGaps++;
+    }
+
+    /**
+     * @brief Report the segment so far, e.g. when the data ran out. The segment carries on, should more data arrive it is
+     *        reported again, from its start, when it ends. A candidate in progress counts as off rate.
+     *
+     * @return false if no FRAME period was read since the segment was last reported
+     */
+    bool flush( U64 sampleNumber, Segment& segment )
+    {
+        if( !mEnabled || mFrames == mReportedFrames )
+            return false;
+        makeSegment( sampleNumber, segment );
+        if( mRate > 0.0 )
+            segment.mOffRateFrames += mCandidate.mCount;
+        mReportedFrames = mFrames;
+        return true;
+    }
+
+  protected:
+    struct Periods
+    {
+        Periods() : mReference( 0.0 ), mSum( 0.0 ), mMin( 0.0 ), mMax( 0.0 ), mCount( 0 )
+        {
+        }
+
+        void add( double period )
+        {
+            if( mCount == 0 )
+                mReference = period;
+            mMin = mCount == 0 ? period : std::min( mMin, period );
+            mMax = mCount == 0 ? period : std::max( mMax, period );
+            mSum += period;
+            mCount++;
+        }
+
+        double mean() const
+        {
+            return mSum / double( mCount );
+        }
+
+        double mReference; // the first period, the others are matched against it
+        double mSum;
+        double mMin;
+        double mMax;
+        U64 mCount;
+    };
+
+    static bool matches( double period, double reference )
+    {
+        return fabs( period - reference ) <= reference * SAMPLE_RATE_TOLERANCE;
+    }
+
+    static double nominal( double rate )
+    {
+        static const double rates[] = { 8000.0,   11025.0,  16000.0,  22050.0,  24000.0,  32000.0,  44100.0,  48000.0,
+                                        64000.0,  88200.0,  96000.0,  176400.0, 192000.0, 352800.0, 384000.0, 705600.0, 768000.0 };
+        for( double standard : rates )
+        {
+            if( fabs( rate - standard ) <= standard * SAMPLE_RATE_TOLERANCE )
+                return standard;
+        }
+        return 0.0;
+    }
+
+    void startSegment( U64 sampleNumber )
+    {
+        mSegmentStart = sampleNumber;
+        mFrames = 0;
+        mReportedFrames = 0;
+        mOffRateFrames = 0;
+        mErrors = 0;
+        mClockGaps = 0;
+        mPeriods = Periods();
+    }
+
+    void makeSegment( U64 sampleNumber, Segment& segment )
+    {
+        segment.mIndex = mIndex;
+        segment.mFirstSample = mSegmentStart;
+        segment.mLastSample = sampleNumber;
+        segment.mFrames = mFrames;
+        segment.mOffRateFrames = mOffRateFrames;
+        segment.mErrors = mErrors;
+        segment.mClockGaps = mClockGaps;
+        segment.mRate = 0.0;
+        segment.mNominal = 0.0;
+        segment.mPpm = 0.0;
+        segment.mMinRate = 0.0;
+        segment.mMaxRate = 0.0;
+        if( mRate <= 0.0 )
+        {
+            // no rate was established, every FRAME period was off rate.
+            segment.mOffRateFrames = mFrames;
+            return;
+        }
+        segment.mRate = double( mSampleRateHz ) / mPeriods.mean();
+        segment.mNominal = nominal( segment.mRate );
+        if( segment.mNominal > 0.0 )
+            segment.mPpm = ( segment.mRate / segment.mNominal - 1.0 ) * 1e6;
+        segment.mMinRate = double( mSampleRateHz ) / mPeriods.mMax;
+        segment.mMaxRate = double( mSampleRateHz ) / mPeriods.mMin;
+    }
+
+    bool mEnabled;
+    U64 mSampleRateHz;
+
+    U32 mIndex;
+    double mRate; // Hz, established, 0 while there is none
+    bool mStarted;
+    Periods mCandidate; // FRAME periods in a row off the established rate
+    U64 mCandidateStart;
+
+    U64 mSegmentStart;
+    U64 mFrames;
+    U64 mReportedFrames; // mFrames when the segment was last flushed
+    U64 mOffRateFrames;
+    U64 mErrors;
+    U64 mClockGaps;
+    Periods mPeriods; // at the established rate
+};
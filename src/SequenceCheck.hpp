@@ -0,0 +1,338 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+
+#include <algorithm>
+#include <vector>
+
+#define SEQUENCE_MAX_CHANNELS 16      // words of a frame kept for the CRC, wider frames are checked over their first 16 words
+#define SEQUENCE_MIN_BITS_PER_WORD 12 // a sequence number of at least 4 bits next to a CRC-8
+#define SEQUENCE_WINDOW 64            // frames behind the newest that a late frame is recognised in, as a reorder rather than a drop
+
+/**
+ * @brief Layout of the sequence test pattern: the channel 0 word of a frame carries the frame's sequence number in its upper bits
+ *        and a CRC in its lower bits, the other channels carry any payload.
+ *
+ * Words of up to 23 bits carry a CRC-8 (polynomial 0x07), wider words a CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF).
+ * The CRC covers the other words of the frame in channel order, then the sequence number, each as whole bytes most significant
+ * first. It is computed a byte at a time from a 256 entry table, so checking a frame costs a table lookup per byte.
+ */
+class SequenceCrc
+{
+  public:
+    SequenceCrc() : mCrcBits( 0 ), mSequenceBits( 0 ), mWordBytes( 0 ), mCrcMask( 0 ), mTopShift( 0 ), mInitial( 0 )
+    {
+    }
+
+    /**
+     * @return false if the words are too narrow for the pattern
+     */
+    bool setup( U32 bitsPerWord )
+    {
+        bitsPerWord = std::min<U32>( bitsPerWord, 64 );
+        if( bitsPerWord < SEQUENCE_MIN_BITS_PER_WORD )
+        {
+            mCrcBits = 0;
+            mSequenceBits = 0;
+            return false;
+        }
+
+        mCrcBits = bitsPerWord < 24 ? 8 : 16;
+        mSequenceBits = bitsPerWord - mCrcBits;
+        mWordBytes = ( bitsPerWord + 7 ) / 8;
+        mCrcMask = ( 1U << mCrcBits ) - 1;
+        mTopShift = mCrcBits - 8;
+        mInitial = mCrcBits == 8 ? 0 : 0xFFFF;
+
+        U32 polynomial = mCrcBits == 8 ? 0x07 : 0x1021;
+        U32 top_bit = 1U << ( mCrcBits - 1 );
+        for( U32 byte = 0; byte < 256; byte++ )
+        {
+            U32 crc = byte << mTopShift;
+            for( U32 bit = 0; bit < 8; bit++ )
+                crc = ( crc & top_bit ) ? ( crc << 1 ) ^ polynomial : crc << 1;
+            mTable[ byte ] = U16( crc & mCrcMask );
+        }
+        return true;
+    }
+
+    U32 sequenceBits() const
+    {
+        return mSequenceBits;
+    }
+
+    U64 sequenceMask() const
+    {
+        return mSequenceBits >= 64 ? ~0ULL : ( 1ULL << mSequenceBits ) - 1;
+    }
+
+    U64 sequence( U64 header ) const
+    {
+        return ( header >> mCrcBits ) & sequenceMask();
+    }
+
+    /**
+     * @brief The channel 0 word for a frame with this sequence number and these words on channels 1 .. count.
+     */
+    U64 header( U64 sequence, const U64* payload, U32 count ) const
+    {
+        return ( ( sequence & sequenceMask() ) << mCrcBits ) | crc( sequence, payload, count );
+    }
+
+    U32 crc( U64 sequence, const U64* payload, U32 count ) const
+    {
+        U32 crc = mInitial;
+        for( U32 i = 0; i < count; i++ )
+            crc = addWord( crc, payload[ i ], mWordBytes );
+        return addWord( crc, sequence & sequenceMask(), ( mSequenceBits + 7 ) / 8 );
+    }
+
+  protected:
+    U32 addWord( U32 crc, U64 word, U32 bytes ) const
+    {
+        for( U32 i = bytes; i > 0; i-- )
+        {
+            U32 byte = U32( word >> ( ( i - 1 ) * 8 ) ) & 0xFF;
+            crc = ( ( crc << 8 ) ^ mTable[ ( ( crc >> mTopShift ) ^ byte ) & 0xFF ] ) & mCrcMask;
+        }
+        return crc;
+    }
+
+    U32 mCrcBits;
+    U32 mSequenceBits;
+    U32 mWordBytes;
+    U32 mCrcMask;
+    U32 mTopShift; // from the CRC register to its top byte
+    U32 mInitial;
+    U16 mTable[ 256 ];
+};
+
+/**
+ * @brief Checks frames of the sequence test pattern, see SequenceCrc, and classifies what went wrong with each.
+ *
+ * - corruption: the CRC doesn't match. The frame is taken to be the next one in sequence, so it isn't also counted as a drop.
+ * - duplicate: the sequence number was already received, within the last SEQUENCE_WINDOW frames
+ * - reorder: the sequence number is older than the newest received, but wasn't received yet
+ * - drop: a sequence number that was skipped and hasn't arrived by the time it is SEQUENCE_WINDOW frames old
+ * A +1 counter can't tell these apart: it sees a step in the count and starts again from there.
+ * A sequence number further back than the window is the sequence starting over, which restarts the check.
+ */
+class SequenceCheck
+{
+  public:
+    enum Kind
+    {
+        KIND_DROP,
+        KIND_DUPLICATE,
+        KIND_REORDER,
+        KIND_CORRUPTION,
+        KIND_ERROR // the pattern can't be checked, the words are narrower than SEQUENCE_MIN_BITS_PER_WORD
+    };
+
+    struct Event
+    {
+        Kind mKind;
+        U64 mSequence;    // received, for a drop the first sequence number dropped
+        U64 mExpected;    // the next sequence number in order
+        U64 mFrames;      // frames dropped, or how many frames late a reordered frame is
+        U64 mFirstSample; // of the frame
+        U64 mReceived;    // channel 0 word, for a corruption
+        U64 mHeader;      // channel 0 word the frame's payload and sequence number should have had, for a corruption
+    };
+
+    struct Totals
+    {
+        U64 mFrames;
+        U64 mCounts[ KIND_ERROR ]; // frames, by Kind
+    };
+
+    SequenceCheck() : mEnabled( false ), mChannelCount( 0 ), mWordMask( ~0ULL )
+    {
+    }
+
+    /**
+     * @param enabled false disables the check, as do words that are too narrow for the pattern
+     */
+    void setup( U32 channelCount, U32 bitsPerWord, bool enabled )
+    {
+        mChannelCount = std::min<U32>( channelCount, SEQUENCE_MAX_CHANNELS );
+        mWordMask = ( bitsPerWord >= 64 ) ? ~0ULL : ( ( 1ULL << bitsPerWord ) - 1 );
+        mEnabled = mCrc.setup( bitsPerWord ) && enabled && mChannelCount > 0;
+
+        // a late frame has to be told apart from one that is a whole sequence range early.
+        mWindow = SEQUENCE_WINDOW;
+        if( mCrc.sequenceBits() > 0 )
+            mWindow = U32( std::min<U64>( SEQUENCE_WINDOW, 1ULL << ( mCrc.sequenceBits() - 1 ) ) );
+        mTotals = Totals();
+        restart();
+    }
+
+    bool enabled() const
+    {
+        return mEnabled;
+    }
+
+    /**
+     * @brief Forget the frame in progress and the sequence numbers received, e.g. after the clock stopped. Totals are kept.
+     */
+    void restart()
+    {
+        mHaveFrame = false;
+        mPrimed = false;
+    }
+
+    const Totals& totals() const
+    {
+        return mTotals;
+    }
+
+    /**
+     * @brief Add one decoded word, the words of a frame in channel order: channel 0 starts a frame, channel N-1 completes it.
+     *
+     * @return true if this completed a frame with a good CRC
+     */
+    bool push( U32 channel, U64 value, U64 sampleNumber, std::vector<Event>& events )
+    {
+        if( channel >= mChannelCount )
+            return false;
+        if( channel == 0 )
+        {
+            mFirstSample = sampleNumber;
+            mHaveFrame = true;
+        }
+        if( !mHaveFrame )
+            return false;
+        mWords[ channel ] = value & mWordMask;
+        if( channel + 1 < mChannelCount )
+            return false;
+
+        mHaveFrame = false;
+        mTotals.mFrames++;
+        return check( events );
+    }
+
+  protected:
+    bool check( std::vector<Event>& events )
+    {
+        U64 header = mWords[ 0 ];
+        U64 sequence = mCrc.sequence( header );
+        U64 expected = mPrimed ? ( mNewest + 1 ) & mCrc.sequenceMask() : sequence;
+        U64 should_be = mCrc.header( sequence, mWords + 1, mChannelCount - 1 );
+        if( should_be != header )
+        {
+            addEvent( KIND_CORRUPTION, sequence, expected, 1, header, should_be, events );
+            if( mPrimed )
+                advance( expected, events );
+            return false;
+        }
+
+        if( !mPrimed )
+        {
+            mPrimed = true;
+            startAt( sequence );
+            return true;
+        }
+
+        // how far ahead of the newest sequence number received, negative is behind it.
+        U64 range_mask = mCrc.sequenceMask();
+        U64 half = ( range_mask >> 1 ) + 1;
+        U64 ahead = ( sequence - mNewest ) & range_mask;
+        if( ahead != 0 && ahead < half )
+        {
+            advance( sequence, events );
+            return true;
+        }
+
+        U64 behind = ( mNewest - sequence ) & range_mask;
+        if( behind < mWindow && ( mReceived & ( 1ULL << behind ) ) != 0 )
+        {
+            addEvent( KIND_DUPLICATE, sequence, expected, 1, 0, 0, events );
+        }
+        else if( behind < mWindow )
+        {
+            addEvent( KIND_REORDER, sequence, expected, behind, 0, 0, events );
+            mReceived |= 1ULL << behind;
+        }
+        else
+        {
+            // too far back to be late: the source started over. Frames still missing can't be placed any more.
+            startAt( sequence );
+        }
+        return true;
+    }
+
+    /**
+     * @brief Start counting from sequence, the numbers before it count as received: nothing is known about them.
+     */
+    void startAt( U64 sequence )
+    {
+        mNewest = sequence;
+        mReceived = ~0ULL;
+    }
+
+    /**
+     * @brief Make sequence the newest received, a drop is decided for the skipped numbers that are now out of the window.
+     */
+    void advance( U64 sequence, std::vector<Event>& events )
+    {
+        U64 ahead = ( sequence - mNewest ) & mCrc.sequenceMask();
+        U64 window_mask = mWindow >= 64 ? ~0ULL : ( 1ULL << mWindow ) - 1;
+
+        // bit n of mReceived is mNewest - n, shifting by ahead moves bits at mWindow - ahead and up out of the window.
+        U64 leaving = ahead < mWindow ? window_mask & ~( ( 1ULL << ( mWindow - ahead ) ) - 1 ) : window_mask;
+        U64 missing = ~mReceived & leaving;
+        U64 dropped = countBits( missing );
+        U64 first = ( mNewest + 1 ) & mCrc.sequenceMask();
+        if( missing != 0 )
+            first = ( mNewest - highestBit( missing ) ) & mCrc.sequenceMask();
+
+        // the numbers skipped beyond the window never got into it.
+        if( ahead > mWindow )
+            dropped += ahead - mWindow;
+
+        if( dropped != 0 )
+            addEvent( KIND_DROP, first, ( mNewest + 1 ) & mCrc.sequenceMask(), dropped, 0, 0, events );
+
+        mReceived = ahead >= 64 ? 0 : ( mReceived << ahead ) & window_mask;
+        mReceived |= 1;
+        mNewest = sequence;
+    }
+
+    static U64 highestBit( U64 bits )
+    {
+        U64 bit = 0;
+        while( bits >>= 1 )
+            bit++;
+        return bit;
+    }
+
+    static U64 countBits( U64 bits )
+    {
+        U64 count = 0;
+        for( ; bits != 0; bits &= bits - 1 )
+            count++;
+        return count;
+    }
+
+    void addEvent( Kind kind, U64 sequence, U64 expected, U64 frames, U64 received, U64 header, std::vector<Event>& events )
+    {
+        mTotals.mCounts[ kind ] += kind == KIND_DROP ? frames : 1;
+        Event event = { kind, sequence, expected, frames, mFirstSample, received, header };
+        events.push_back( event );
+    }
+
+    bool mEnabled;
+    U32 mChannelCount;
+    U64 mWordMask;
+    U32 mWindow;
+    SequenceCrc mCrc;
+
+    U64 mWords[ SEQUENCE_MAX_CHANNELS ];
+    U64 mFirstSample;
+    bool mHaveFrame;
+
+    bool mPrimed;
+    U64 mNewest;   // newest sequence number received
+    U64 mReceived; // bit n: mNewest - n was received, over the last mWindow numbers
+    Totals mTotals;
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <AnalyzerTypes.h>
+
+#define STARTUP_NOT_REACHED 0xFFFFFFFFFFFFFFFFULL
+
+/**
+ * @brief Time from a codec starting up to it producing valid audio, for every power cycle in a capture.
+ *
+ * A cycle starts at the start of the decode, and again at the end of every clock gap. It is timed from an anchor: the start of
+ * the decode, or the last CLOCK edge before the gap. Its milestones are
+ * - the first CLOCK edge
+ * - the first FRAME edge, to the data valid edge it was first seen at
+ * - the first frame that decodes without a framing error
+ * - the first word the selected test passes, when a test is selected
+ * A cycle is complete when all of them are reached. A cycle that is cut short by the next gap is reported as incomplete.
+ */
+class StartupTiming
+{
+  public:
+    enum Milestone
+    {
+        MILESTONE_CLOCK,
+        MILESTONE_FRAME_EDGE,
+        MILESTONE_VALID_FRAME,
+        MILESTONE_TEST_PASS,
+        MILESTONE_COUNT
+    };
+
+    struct Cycle
+    {
+        U32 mIndex; // 0 for the cycle at the start of the decode
+        bool mComplete;
+        U64 mAnchor;                     // sample the cycle is timed from
+        U64 mSamples[ MILESTONE_COUNT ]; // sample each milestone was reached at, STARTUP_NOT_REACHED if it wasn't
+    };
+
+    StartupTiming() : mEnabled( false ), mNeedsTest( false ), mStarted( false ), mReported( true )
+    {
+    }
+
+    /**
+     * @param testSelected false when there is no test, the cycle is then complete at its first valid frame
+     */
+    void setup( bool enabled, bool testSelected )
+    {
+        mEnabled = enabled;
+        mNeedsTest = testSelected;
+        mStarted = false;
+        mReported = true;
+        mCycle.mIndex = 0;
+    }
+
+    bool enabled() const
+    {
+        return mEnabled;
+    }
+
+    /**
+     * @brief Start a cycle at its first CLOCK edge.
+     *
+     * @return true if the previous cycle was cut short, with it in finished
+     */
+    bool start( U64 anchor, U64 firstClock, Cycle& finished )
+    {
+        bool cut_short = mStarted && !mReported;
+        if( cut_short )
+            finished = mCycle;
+
+        if( mStarted )
+            mCycle.mIndex++;
+        mStarted = true;
+        mReported = false;
+        mHaveFrameState = false;
+        mCycle.mComplete = false;
+        mCycle.mAnchor = anchor;
+        for( U32 milestone = 0; milestone < MILESTONE_COUNT; milestone++ )
+            mCycle.mSamples[ milestone ] = STARTUP_NOT_REACHED;
+        mCycle.mSamples[ MILESTONE_CLOCK ] = firstClock;
+        return cut_short;
+    }
+
+    /**
+     * @brief The FRAME level at a data valid edge. The first change from the level at the cycle's first edge is its first FRAME edge.
+     */
+    void frameBit( BitState frame, U64 sampleNumber )
+    {
+        if( !mStarted || mCycle.mSamples[ MILESTONE_FRAME_EDGE ] != STARTUP_NOT_REACHED )
+            return;
+        if( !mHaveFrameState )
+        {
+            mFrameState = frame;
+            mHaveFrameState = true;
+        }
+        else if( frame != mFrameState )
+        {
+            mCycle.mSamples[ MILESTONE_FRAME_EDGE ] = sampleNumber;
+        }
+    }
+
+    /**
+     * @return true when this completes the cycle, with it in cycle
+     */
+    bool validFrame( U64 sampleNumber, Cycle& cycle )
+    {
+        return reach( MILESTONE_VALID_FRAME, sampleNumber, cycle );
+    }
+
+    /**
+     * @return true when this completes the cycle, with it in cycle
+     */
+    bool testPass( U64 sampleNumber, Cycle& cycle )
+    {
+        return reach( MILESTONE_TEST_PASS, sampleNumber, cycle );
+    }
+
+  protected:
+    bool reach( Milestone milestone, U64 sampleNumber, Cycle& cycle )
+    {
+        if( !mStarted || mReported || mCycle.mSamples[ milestone ] != STARTUP_NOT_REACHED )
+            return false;
+        // a test can only pass on a frame that decoded.
+        if( milestone == MILESTONE_TEST_PASS && mCycle.mSamples[ MILESTONE_VALID_FRAME ] == STARTUP_NOT_REACHED )
+            return false;
+        mCycle.mSamples[ milestone ] = sampleNumber;
+
+        for( U32 required = 0; required < MILESTONE_COUNT; required++ )
+        {
+            if( required == MILESTONE_TEST_PASS && !mNeedsTest )
+                continue;
+            if( mCycle.mSamples[ required ] == STARTUP_NOT_REACHED )
+                return false;
+        }
+        mCycle.mComplete = true;
+        mReported = true;
+        cycle = mCycle;
+        return true;
+    }
+
+    bool mEnabled;
+    bool mNeedsTest;
+    bool mStarted;
+    bool mReported; // the current cycle completed, or there is none
+    Cycle mCycle;
+    bool mHaveFrameState;
+    BitState mFrameState;
+};
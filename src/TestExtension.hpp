@@ -4,17 +4,42 @@
 #include <AnalyzerTypes.h>
 #include <AnalyzerHelpers.h>
 #include "TestServer.hpp"
+#include "BitFaultMap.hpp"
+#include "AudioQualityAnalysis.hpp"
+#include "LevelStatistics.hpp"
+#include "ReferenceCompare.hpp"
+#include "LoopbackLatency.hpp"
+#include "LockStepCheck.hpp"
+#include "SequenceCheck.hpp"
+#include "StartupTiming.hpp"
+#include "ClockRecovery.hpp"
+#include "ClockTreeMonitor.hpp"
+#include "JitterSpectrum.hpp"
+#include "ClockPulseMonitor.hpp"
+#include "FrameLengthTracker.hpp"
+#include "SampleRateTracker.hpp"
 
 #include <memory>
 #include <algorithm>
 #include <string>
 #include <limits>
+#include <cstring>
 
 
 enum TestMode
 {
     TEST_DISABLED,
-    TEST_CONTIGUOUS
+    TEST_CONTIGUOUS,
+    TEST_REFERENCE,
+    TEST_LOCKSTEP,
+    TEST_SEQUENCE
+};
+
+enum DecodeRange
+{
+    DECODE_WHOLE_CAPTURE,
+    DECODE_FROM_CAPTURE_START,
+    DECODE_FROM_TRIGGER
 };
 
 // Note: We give away the pointer to the setting interfaces, so we need to ensure that they are not used after the TestExtensionSettings is
@@ -24,18 +49,192 @@ enum TestMode
 class TestExtensionSettings
 {
   public:
-    TestExtensionSettings() : mTestMode( TEST_DISABLED ), mUseTestServer( false )
+    TestExtensionSettings() : mTestMode( TEST_DISABLED ), mUseTestServer( false ), mErrorMergeGapUs( 0 ), mAudioAnalysisBlockSize( 0 ), mLevelStatisticsBlockSize( 0 ),
+          mClockGapThreshold( 0 ), mDecodeRange( DECODE_WHOLE_CAPTURE ), mDecodeStartUs( 0 ), mDecodeEndUs( 1000000 ),
+          mFormatDetectionMs( 0 ), mReferenceLockFrames( 16 ), mLoopbackReportInterval( 0 ), mLoopbackMaxLatencyMs( 100 ),
+          mLockStepStep( 0 ), mStartupTiming( false ), mRecoveredBitsPerFrame( 0 ),
+          mJitterSpectrumBlockSize( 0 ), mClockGlitchPercent( 0 ), mFrameLengthTracking( false ),
+          mSampleRateSegments( false )
     {
         mTestModeInterface.reset( new AnalyzerSettingInterfaceNumberList() );
         mTestModeInterface->SetTitleAndTooltip( "Test mode", "Select a data test. Results will show test errors." );
         mTestModeInterface->AddNumber( TEST_DISABLED, "No test", "normal analyser operation." );
         mTestModeInterface->AddNumber( TEST_CONTIGUOUS, "Contiguous", "Reports errors if channel samples are not contiguous." );
+        mTestModeInterface->AddNumber( TEST_REFERENCE, "Reference file",
+                                       "Locks onto the reference file below and reports samples that differ, drops, repeats and lock loss." );
+        mTestModeInterface->AddNumber( TEST_LOCKSTEP, "Channel lock-step",
+                                       "Reports frames where ch[n] != ch[0] + n * step, and channels that are swapped or skewed." );
+        mTestModeInterface->AddNumber( TEST_SEQUENCE, "Sequence + CRC",
+                                       "Channel 1 carries a frame sequence number and a CRC of the frame. Reports drops, duplicates, "
+                                       "reordered and corrupted frames. Needs 12 or more bits per word." );
         mTestModeInterface->SetNumber( mTestMode );
 
         mUseTestServerInterface.reset( new AnalyzerSettingInterfaceBool() );
         mUseTestServerInterface->SetTitleAndTooltip( "Use test server",
                                                      "Use the custom i2s test server to log clock stats and control automation" );
         mUseTestServerInterface->SetValue( mUseTestServer );
+
+        mErrorMergeGapInterface.reset( new AnalyzerSettingInterfaceInteger() );
+        mErrorMergeGapInterface->SetTitleAndTooltip( "Error merge gap (us)",
+                                                     "Consecutive errors of the same kind closer than this are reported as one error range. "
+                                                     "0 reports every error on its own." );
+        mErrorMergeGapInterface->SetMin( 0 );
+        mErrorMergeGapInterface->SetMax( 1000000 );
+        mErrorMergeGapInterface->SetInteger( mErrorMergeGapUs );
+
+        mAudioAnalysisInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+        mAudioAnalysisInterface->SetTitleAndTooltip( "Audio analysis",
+                                                     "Measure frequency, THD+N, SNR and DC offset of each channel in blocks of samples." );
+        mAudioAnalysisInterface->AddNumber( 0, "Off", "No audio analysis." );
+        mAudioAnalysisInterface->AddNumber( 1024, "1024 sample blocks", "" );
+        mAudioAnalysisInterface->AddNumber( 4096, "4096 sample blocks", "" );
+        mAudioAnalysisInterface->AddNumber( 16384, "16384 sample blocks", "" );
+        mAudioAnalysisInterface->AddNumber( 65536, "65536 sample blocks", "" );
+        mAudioAnalysisInterface->SetNumber( mAudioAnalysisBlockSize );
+
+        mLevelStatisticsInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+        mLevelStatisticsInterface->SetTitleAndTooltip(
+            "Level statistics", "Report min, max, RMS, DC, clipping and digital silence of each channel every N words and at the end." );
+        mLevelStatisticsInterface->AddNumber( 0, "Off", "No level statistics." );
+        mLevelStatisticsInterface->AddNumber( 4096, "Every 4096 words", "" );
+        mLevelStatisticsInterface->AddNumber( 65536, "Every 65536 words", "" );
+        mLevelStatisticsInterface->AddNumber( 1048576, "Every 1048576 words", "" );
+        mLevelStatisticsInterface->SetNumber( mLevelStatisticsBlockSize );
+
+        mClockGapThresholdInterface.reset( new AnalyzerSettingInterfaceInteger() );
+        mClockGapThresholdInterface->SetTitleAndTooltip( "Clock gap threshold (bit periods)",
+                                                         "A CLOCK pause longer than this many bit periods is reported as a clock gap, and "
+                                                         "framing and tests restart after it. 0 disables gap detection." );
+        mClockGapThresholdInterface->SetMin( 0 );
+        mClockGapThresholdInterface->SetMax( 1000000 );
+        mClockGapThresholdInterface->SetInteger( mClockGapThreshold );
+
+        mDecodeRangeInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+        mDecodeRangeInterface->SetTitleAndTooltip( "Decode range", "Decode the whole capture, or only the time window given below." );
+        mDecodeRangeInterface->AddNumber( DECODE_WHOLE_CAPTURE, "Whole capture", "" );
+        mDecodeRangeInterface->AddNumber( DECODE_FROM_CAPTURE_START, "Window, from capture start", "Start and end are times from the start of the capture." );
+        mDecodeRangeInterface->AddNumber( DECODE_FROM_TRIGGER, "Window, relative to trigger", "Start and end are times relative to the trigger." );
+        mDecodeRangeInterface->SetNumber( mDecodeRange );
+
+        mDecodeStartInterface.reset( new AnalyzerSettingInterfaceInteger() );
+        mDecodeStartInterface->SetTitleAndTooltip( "Decode window start (us)", "Start of the decode window, when a window is selected." );
+        mDecodeStartInterface->SetMin( -2000000000 );
+        mDecodeStartInterface->SetMax( 2000000000 );
+        mDecodeStartInterface->SetInteger( mDecodeStartUs );
+
+        mDecodeEndInterface.reset( new AnalyzerSettingInterfaceInteger() );
+        mDecodeEndInterface->SetTitleAndTooltip( "Decode window end (us)", "End of the decode window, when a window is selected." );
+        mDecodeEndInterface->SetMin( -2000000000 );
+        mDecodeEndInterface->SetMax( 2000000000 );
+        mDecodeEndInterface->SetInteger( mDecodeEndUs );
+
+        mFormatDetectionInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+        mFormatDetectionInterface->SetTitleAndTooltip(
+            "Format detection", "Detect edge, frame type, bit shift and bit depth from the start of the decode, and override the settings above." );
+        mFormatDetectionInterface->AddNumber( 0, "Off (use settings)", "" );
+        mFormatDetectionInterface->AddNumber( 2, "Auto (first 2 ms)", "The first 2 ms are used for detection only and not decoded." );
+        mFormatDetectionInterface->AddNumber( 10, "Auto (first 10 ms)", "The first 10 ms are used for detection only and not decoded." );
+        mFormatDetectionInterface->AddNumber( 50, "Auto (first 50 ms)", "The first 50 ms are used for detection only and not decoded." );
+        mFormatDetectionInterface->SetNumber( mFormatDetectionMs );
+
+        mResultCacheInterface.reset( new AnalyzerSettingInterfaceText() );
+        mResultCacheInterface->SetTitleAndTooltip( "Result cache directory",
+                                                   "Keep the decoded words of each capture here, so a re-run over the same capture replays them "
+                                                   "instead of decoding again. Leave empty to disable." );
+        mResultCacheInterface->SetTextType( AnalyzerSettingInterfaceText::FolderPath );
+        mResultCacheInterface->SetText( mResultCacheDirectory.c_str() );
+
+        mReferenceFileInterface.reset( new AnalyzerSettingInterfaceText() );
+        mReferenceFileInterface->SetTitleAndTooltip( "Reference file",
+                                                     "WAV or raw PCM file the DUT is playing, for the Reference file test. Raw files are "
+                                                     "interleaved little endian, in whole bytes per sample." );
+        mReferenceFileInterface->SetTextType( AnalyzerSettingInterfaceText::FilePath );
+        mReferenceFileInterface->SetText( mReferenceFile.c_str() );
+
+        mReferenceLockFramesInterface.reset( new AnalyzerSettingInterfaceInteger() );
+        mReferenceLockFramesInterface->SetTitleAndTooltip( "Reference lock frames",
+                                                           "Consecutive frames that have to match the reference file to lock onto it." );
+        mReferenceLockFramesInterface->SetMin( 1 );
+        mReferenceLockFramesInterface->SetMax( 4096 );
+        mReferenceLockFramesInterface->SetInteger( mReferenceLockFrames );
+
+        mLoopbackInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+        mLoopbackInterface->SetTitleAndTooltip( "Loopback latency",
+                                                "Measure the latency from DATA to the output DATA line below, on a marker such as a counter or "
+                                                "PRBS that passes through the DUT unchanged." );
+        mLoopbackInterface->AddNumber( 0, "Off", "No latency measurement." );
+        mLoopbackInterface->AddNumber( 1000, "Report every 1000 matches", "" );
+        mLoopbackInterface->AddNumber( 10000, "Report every 10000 matches", "" );
+        mLoopbackInterface->AddNumber( 100000, "Report every 100000 matches", "" );
+        mLoopbackInterface->SetNumber( mLoopbackReportInterval );
+
+        mLoopbackMaxLatencyInterface.reset( new AnalyzerSettingInterfaceInteger() );
+        mLoopbackMaxLatencyInterface->SetTitleAndTooltip( "Loopback max latency (ms)",
+                                                          "Longest latency looked for. Input markers are remembered for this long." );
+        mLoopbackMaxLatencyInterface->SetMin( 1 );
+        mLoopbackMaxLatencyInterface->SetMax( 10000 );
+        mLoopbackMaxLatencyInterface->SetInteger( mLoopbackMaxLatencyMs );
+
+        mLockStepStepInterface.reset( new AnalyzerSettingInterfaceInteger() );
+        mLockStepStepInterface->SetTitleAndTooltip( "Lock-step channel step",
+                                                    "For the Channel lock-step test: each channel of a frame is expected to be the previous "
+                                                    "channel plus this. 0 expects the same value on all channels." );
+        mLockStepStepInterface->SetMin( -1000000 );
+        mLockStepStepInterface->SetMax( 1000000 );
+        mLockStepStepInterface->SetInteger( mLockStepStep );
+
+        mStartupTimingInterface.reset( new AnalyzerSettingInterfaceBool() );
+        mStartupTimingInterface->SetTitleAndTooltip( "Startup timing",
+                                                     "Time the first CLOCK edge, first FRAME edge, first valid frame and first word that "
+                                                     "passes the test, from the start of the decode and after every clock gap." );
+        mStartupTimingInterface->SetValue( mStartupTiming );
+
+        mRecoveredBitsPerFrameInterface.reset( new AnalyzerSettingInterfaceInteger() );
+        mRecoveredBitsPerFrameInterface->SetTitleAndTooltip( "Recovered bits per FRAME",
+                                                             "With no CLOCK channel, the bit clock is recovered from DATA and FRAME. "
+                                                             "Bit clocks from one FRAME rising edge to the next, 0 is bits per word "
+                                                             "times words per FRAME period." );
+        mRecoveredBitsPerFrameInterface->SetMin( 0 );
+        mRecoveredBitsPerFrameInterface->SetMax( 4096 );
+        mRecoveredBitsPerFrameInterface->SetInteger( mRecoveredBitsPerFrame );
+
+        mJitterSpectrumInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+        mJitterSpectrumInterface->SetTitleAndTooltip( "Jitter spectrum",
+                                                      "Spectrum of the time interval error of the data valid CLOCK edges against a fitted "
+                                                      "ideal clock, in blocks of edges. Reports rms jitter per band and the largest spurs." );
+        mJitterSpectrumInterface->AddNumber( 0, "Off", "No jitter spectrum." );
+        mJitterSpectrumInterface->AddNumber( 1024, "1024 edge blocks", "" );
+        mJitterSpectrumInterface->AddNumber( 4096, "4096 edge blocks", "" );
+        mJitterSpectrumInterface->AddNumber( 16384, "16384 edge blocks", "" );
+        mJitterSpectrumInterface->AddNumber( 65536, "65536 edge blocks", "" );
+        mJitterSpectrumInterface->SetNumber( mJitterSpectrumBlockSize );
+
+        mJitterSpectrumCsvInterface.reset( new AnalyzerSettingInterfaceText() );
+        mJitterSpectrumCsvInterface->SetTitleAndTooltip( "Jitter spectrum CSV",
+                                                         "File the jitter spectrum averaged since the start of the decode is written to "
+                                                         "at each report. Leave empty for none." );
+        mJitterSpectrumCsvInterface->SetTextType( AnalyzerSettingInterfaceText::FilePath );
+        mJitterSpectrumCsvInterface->SetText( mJitterSpectrumCsvFile.c_str() );
+
+        mClockGlitchInterface.reset( new AnalyzerSettingInterfaceInteger() );
+        mClockGlitchInterface->SetTitleAndTooltip( "Clock glitch threshold (%)",
+                                                   "Measure every CLOCK pulse. Pulses shorter than this percentage of the bit period are "
+                                                   "reported as glitches, the others go into duty cycle reports. 0 disables it." );
+        mClockGlitchInterface->SetMin( 0 );
+        mClockGlitchInterface->SetMax( 100 );
+        mClockGlitchInterface->SetInteger( mClockGlitchPercent );
+
+        mFrameLengthInterface.reset( new AnalyzerSettingInterfaceBool() );
+        mFrameLengthInterface->SetTitleAndTooltip( "Frame length tracking",
+                                                   "Keep the bit count of every FRAME period as runs and a histogram, and report the "
+                                                   "periods that slip from the established count." );
+        mFrameLengthInterface->SetValue( mFrameLengthTracking );
+
+        mSampleRateInterface.reset( new AnalyzerSettingInterfaceBool() );
+        mSampleRateInterface->SetTitleAndTooltip( "Sample rate segments",
+                                                  "Split the decode where the FRAME rate changes, with statistics per segment, and "
+                                                  "restart the test and the clock measurements at each change." );
+        mSampleRateInterface->SetValue( mSampleRateSegments );
     };
 
     ~TestExtensionSettings() = default;
@@ -45,6 +244,27 @@ class TestExtensionSettings
         std::vector<AnalyzerSettingInterface*> interfaces;
         interfaces.push_back( mTestModeInterface.get() );
         interfaces.push_back( mUseTestServerInterface.get() );
+        interfaces.push_back( mErrorMergeGapInterface.get() );
+        interfaces.push_back( mAudioAnalysisInterface.get() );
+        interfaces.push_back( mLevelStatisticsInterface.get() );
+        interfaces.push_back( mClockGapThresholdInterface.get() );
+        interfaces.push_back( mDecodeRangeInterface.get() );
+        interfaces.push_back( mDecodeStartInterface.get() );
+        interfaces.push_back( mDecodeEndInterface.get() );
+        interfaces.push_back( mFormatDetectionInterface.get() );
+        interfaces.push_back( mResultCacheInterface.get() );
+        interfaces.push_back( mReferenceFileInterface.get() );
+        interfaces.push_back( mReferenceLockFramesInterface.get() );
+        interfaces.push_back( mLoopbackInterface.get() );
+        interfaces.push_back( mLoopbackMaxLatencyInterface.get() );
+        interfaces.push_back( mLockStepStepInterface.get() );
+        interfaces.push_back( mStartupTimingInterface.get() );
+        interfaces.push_back( mRecoveredBitsPerFrameInterface.get() );
+        interfaces.push_back( mJitterSpectrumInterface.get() );
+        interfaces.push_back( mJitterSpectrumCsvInterface.get() );
+        interfaces.push_back( mClockGlitchInterface.get() );
+        interfaces.push_back( mFrameLengthInterface.get() );
+        interfaces.push_back( mSampleRateInterface.get() );
         return interfaces;
     }
 
@@ -52,12 +272,54 @@ class TestExtensionSettings
     {
         mTestModeInterface->SetNumber( mTestMode );
         mUseTestServerInterface->SetValue( mUseTestServer );
+        mErrorMergeGapInterface->SetInteger( mErrorMergeGapUs );
+        mAudioAnalysisInterface->SetNumber( mAudioAnalysisBlockSize );
+        mLevelStatisticsInterface->SetNumber( mLevelStatisticsBlockSize );
+        mClockGapThresholdInterface->SetInteger( mClockGapThreshold );
+        mDecodeRangeInterface->SetNumber( mDecodeRange );
+        mDecodeStartInterface->SetInteger( mDecodeStartUs );
+        mDecodeEndInterface->SetInteger( mDecodeEndUs );
+        mFormatDetectionInterface->SetNumber( mFormatDetectionMs );
+        mResultCacheInterface->SetText( mResultCacheDirectory.c_str() );
+        mReferenceFileInterface->SetText( mReferenceFile.c_str() );
+        mReferenceLockFramesInterface->SetInteger( mReferenceLockFrames );
+        mLoopbackInterface->SetNumber( mLoopbackReportInterval );
+        mLoopbackMaxLatencyInterface->SetInteger( mLoopbackMaxLatencyMs );
+        mLockStepStepInterface->SetInteger( mLockStepStep );
+        mStartupTimingInterface->SetValue( mStartupTiming );
+        mRecoveredBitsPerFrameInterface->SetInteger( mRecoveredBitsPerFrame );
+        mJitterSpectrumInterface->SetNumber( mJitterSpectrumBlockSize );
+        mJitterSpectrumCsvInterface->SetText( mJitterSpectrumCsvFile.c_str() );
+        mClockGlitchInterface->SetInteger( mClockGlitchPercent );
+        mFrameLengthInterface->SetValue( mFrameLengthTracking );
+        mSampleRateInterface->SetValue( mSampleRateSegments );
     }
 
     void SetSettingsFromInterfaces()
     {
         mTestMode = TestMode( U32( mTestModeInterface->GetNumber() ) );
         mUseTestServer = mUseTestServerInterface->GetValue();
+        mErrorMergeGapUs = U32( mErrorMergeGapInterface->GetInteger() );
+        mAudioAnalysisBlockSize = U32( mAudioAnalysisInterface->GetNumber() );
+        mLevelStatisticsBlockSize = U32( mLevelStatisticsInterface->GetNumber() );
+        mClockGapThreshold = U32( mClockGapThresholdInterface->GetInteger() );
+        mDecodeRange = DecodeRange( U32( mDecodeRangeInterface->GetNumber() ) );
+        mDecodeStartUs = mDecodeStartInterface->GetInteger();
+        mDecodeEndUs = mDecodeEndInterface->GetInteger();
+        mFormatDetectionMs = U32( mFormatDetectionInterface->GetNumber() );
+        mResultCacheDirectory = mResultCacheInterface->GetText();
+        mReferenceFile = mReferenceFileInterface->GetText();
+        mReferenceLockFrames = U32( mReferenceLockFramesInterface->GetInteger() );
+        mLoopbackReportInterval = U32( mLoopbackInterface->GetNumber() );
+        mLoopbackMaxLatencyMs = U32( mLoopbackMaxLatencyInterface->GetInteger() );
+        mLockStepStep = mLockStepStepInterface->GetInteger();
+        mStartupTiming = mStartupTimingInterface->GetValue();
+        mRecoveredBitsPerFrame = U32( mRecoveredBitsPerFrameInterface->GetInteger() );
+        mJitterSpectrumBlockSize = U32( mJitterSpectrumInterface->GetNumber() );
+        mJitterSpectrumCsvFile = mJitterSpectrumCsvInterface->GetText();
+        mClockGlitchPercent = U32( mClockGlitchInterface->GetInteger() );
+        mFrameLengthTracking = mFrameLengthInterface->GetValue();
+        mSampleRateSegments = mSampleRateInterface->GetValue();
     }
 
     void LoadSettings( SimpleArchive& text_archive )
@@ -73,19 +335,188 @@ class TestExtensionSettings
         {
             mUseTestServer = test_server;
         }
+
+        U32 error_merge_gap;
+        if( text_archive >> error_merge_gap )
+        {
+            mErrorMergeGapUs = error_merge_gap;
+        }
+
+        U32 audio_analysis_block_size;
+        if( text_archive >> audio_analysis_block_size )
+        {
+            mAudioAnalysisBlockSize = audio_analysis_block_size;
+        }
+
+        U32 level_statistics_block_size;
+        if( text_archive >> level_statistics_block_size )
+        {
+            mLevelStatisticsBlockSize = level_statistics_block_size;
+        }
+
+        U32 clock_gap_threshold;
+        if( text_archive >> clock_gap_threshold )
+        {
+            mClockGapThreshold = clock_gap_threshold;
+        }
+
+        U32 decode_range;
+        S32 decode_start;
+        S32 decode_end;
+        if( ( text_archive >> decode_range ) && ( text_archive >> decode_start ) && ( text_archive >> decode_end ) )
+        {
+            mDecodeRange = DecodeRange( decode_range );
+            mDecodeStartUs = decode_start;
+            mDecodeEndUs = decode_end;
+        }
+
+        U32 format_detection_ms;
+        if( text_archive >> format_detection_ms )
+        {
+            mFormatDetectionMs = format_detection_ms;
+        }
+
+        const char* result_cache_directory;
+        if( text_archive >> &result_cache_directory )
+        {
+            mResultCacheDirectory = result_cache_directory;
+        }
+
+        const char* reference_file;
+        U32 reference_lock_frames;
+        if( ( text_archive >> &reference_file ) && ( text_archive >> reference_lock_frames ) )
+        {
+            mReferenceFile = reference_file;
+            mReferenceLockFrames = reference_lock_frames;
+        }
+
+        U32 loopback_report_interval;
+        U32 loopback_max_latency_ms;
+        if( ( text_archive >> loopback_report_interval ) && ( text_archive >> loopback_max_latency_ms ) )
+        {
+            mLoopbackReportInterval = loopback_report_interval;
+            mLoopbackMaxLatencyMs = loopback_max_latency_ms;
+        }
+
+        S32 lock_step_step;
+        if( text_archive >> lock_step_step )
+        {
+            mLockStepStep = lock_step_step;
+        }
+
+        bool startup_timing;
+        if( text_archive >> startup_timing )
+        {
+            mStartupTiming = startup_timing;
+        }
+
+        U32 recovered_bits_per_frame;
+        if( text_archive >> recovered_bits_per_frame )
+        {
+            mRecoveredBitsPerFrame = recovered_bits_per_frame;
+        }
+
+        U32 jitter_spectrum_block_size;
+        const char* jitter_spectrum_csv_file;
+        if( ( text_archive >> jitter_spectrum_block_size ) && ( text_archive >> &jitter_spectrum_csv_file ) )
+        {
+            mJitterSpectrumBlockSize = jitter_spectrum_block_size;
+            mJitterSpectrumCsvFile = jitter_spectrum_csv_file;
+        }
+
+        U32 clock_glitch_percent;
+        if( text_archive >> clock_glitch_percent )
+        {
+            mClockGlitchPercent = clock_glitch_percent;
+        }
+
+        bool frame_length_tracking;
+        if( text_archive >> frame_length_tracking )
+        {
+            mFrameLengthTracking = frame_length_tracking;
+        }
+
+        bool sample_rate_segments;
+        if( text_archive >> sample_rate_segments )
+        {
+            mSampleRateSegments = sample_rate_segments;
+        }
     }
 
     void SaveSettings( SimpleArchive& text_archive )
     {
         text_archive << mTestMode;
         text_archive << mUseTestServer;
+        text_archive << mErrorMergeGapUs;
+        text_archive << mAudioAnalysisBlockSize;
+        text_archive << mLevelStatisticsBlockSize;
+        text_archive << mClockGapThreshold;
+        text_archive << U32( mDecodeRange );
+        text_archive << mDecodeStartUs;
+        text_archive << mDecodeEndUs;
+        text_archive << mFormatDetectionMs;
+        text_archive << mResultCacheDirectory.c_str();
+        text_archive << mReferenceFile.c_str();
+        text_archive << mReferenceLockFrames;
+        text_archive << mLoopbackReportInterval;
+        text_archive << mLoopbackMaxLatencyMs;
+        text_archive << mLockStepStep;
+        text_archive << mStartupTiming;
+        text_archive << mRecoveredBitsPerFrame;
+        text_archive << mJitterSpectrumBlockSize;
+        text_archive << mJitterSpectrumCsvFile.c_str();
+        text_archive << mClockGlitchPercent;
+        text_archive << mFrameLengthTracking;
+        text_archive << mSampleRateSegments;
     }
 
     TestMode mTestMode;
     bool mUseTestServer;
+    U32 mErrorMergeGapUs;
+    U32 mAudioAnalysisBlockSize;
+    U32 mLevelStatisticsBlockSize;
+    U32 mClockGapThreshold;
+    DecodeRange mDecodeRange;
+    S32 mDecodeStartUs;
+    S32 mDecodeEndUs;
+    U32 mFormatDetectionMs;
+    std::string mResultCacheDirectory;
+    std::string mReferenceFile;
+    U32 mReferenceLockFrames;
+    U32 mLoopbackReportInterval;
+    U32 mLoopbackMaxLatencyMs;
+    S32 mLockStepStep;
+    bool mStartupTiming;
+    U32 mRecoveredBitsPerFrame;
+    U32 mJitterSpectrumBlockSize;
+    std::string mJitterSpectrumCsvFile;
+    U32 mClockGlitchPercent;
+    bool mFrameLengthTracking;
+    bool mSampleRateSegments;
 
     std::unique_ptr<AnalyzerSettingInterfaceNumberList> mTestModeInterface;
     std::unique_ptr<AnalyzerSettingInterfaceBool> mUseTestServerInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceInteger> mErrorMergeGapInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceNumberList> mAudioAnalysisInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceNumberList> mLevelStatisticsInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceInteger> mClockGapThresholdInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceNumberList> mDecodeRangeInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceInteger> mDecodeStartInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceInteger> mDecodeEndInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceNumberList> mFormatDetectionInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceText> mResultCacheInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceText> mReferenceFileInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceInteger> mReferenceLockFramesInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceNumberList> mLoopbackInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceInteger> mLoopbackMaxLatencyInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceInteger> mLockStepStepInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceBool> mStartupTimingInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceInteger> mRecoveredBitsPerFrameInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceNumberList> mJitterSpectrumInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceText> mJitterSpectrumCsvInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceInteger> mClockGlitchInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceBool> mFrameLengthInterface;
+    std::unique_ptr<AnalyzerSettingInterfaceBool> mSampleRateInterface;
 };
 
 class TestExtension
@@ -95,16 +526,34 @@ class TestExtension
 
     ~TestExtension() = default;
 
-    void setup( int channelCount, TestExtensionSettings& pSettings )
+    void setup( int channelCount, U32 bitsPerWord, U64 sampleRateHz, TestExtensionSettings& pSettings )
     {
         mTestChannelPrimed.clear();
         mTestExpectedResults.clear();
         mTestChannelPrimed.assign( channelCount, false );
         mTestExpectedResults.assign( channelCount, 0 );
+        mWordMask = ( bitsPerWord >= 64 ) ? ~0ULL : ( ( 1ULL << bitsPerWord ) - 1 );
+
+        mFaultMap.setup( channelCount, bitsPerWord );
+        mFaultMapDirty = false;
+        mLastExpected = 0;
+        mLastSlip = 0;
+
+        mAudioQuality.setup( channelCount, pSettings.mAudioAnalysisBlockSize, sampleRateHz );
+        mLevelStatistics.setup( channelCount, pSettings.mLevelStatisticsBlockSize, bitsPerWord );
+        mReference.setup( pSettings.mReferenceFile, channelCount, bitsPerWord,
+                          pSettings.mTestMode == TEST_REFERENCE ? pSettings.mReferenceLockFrames : 0 );
+        mLatency.setup( pSettings.mLoopbackReportInterval, U64( pSettings.mLoopbackMaxLatencyMs ) * sampleRateHz / 1000 );
+        mLockStep.setup( channelCount, bitsPerWord, pSettings.mLockStepStep, pSettings.mTestMode == TEST_LOCKSTEP );
+        mSequence.setup( channelCount, bitsPerWord, pSettings.mTestMode == TEST_SEQUENCE );
+        mStartup.setup( pSettings.mStartupTiming, pSettings.mTestMode != TEST_DISABLED );
+        mTestPassed = false;
 
         mClockMinInterval = std::numeric_limits<U64>::max();
         mClockMaxInterval = 0;
         mStatsUpdateCount = 0;
+        mClockStatsPrimed = false;
+        edgeCount = 0;
 
         if( pSettings.mUseTestServer && !mTestServerConnected )
         {
@@ -112,6 +561,32 @@ class TestExtension
         }
     }
 
+    /**
+     * @brief Forget the expected values and the clock interval in progress, e.g. after the clock stopped.
+     *        Accumulated results (fault map, level statistics) are kept.
+     */
+    void restart()
+    {
+        mTestChannelPrimed.assign( mTestChannelPrimed.size(), false );
+        mLatency.restart();
+        mLockStep.restart();
+        mSequence.restart();
+        mClockStatsPrimed = false;
+        edgeCount = 0;
+    }
+
+    /**
+     * @brief The sample rate changed: restart as after a clock gap, and drop the clock intervals collected since the last update,
+     *        so no update mixes two rates.
+     */
+    void startSegment()
+    {
+        restart();
+        mClockMinInterval = std::numeric_limits<U64>::max();
+        mClockMaxInterval = 0;
+        mStatsUpdateCount = 0;
+    }
+
     /**
      * @brief
      *
@@ -122,7 +597,7 @@ class TestExtension
      * @return true if error
      * @return false if no error
      */
-    bool process( TestExtensionSettings& settings, int channel, int value )
+    bool process( TestExtensionSettings& settings, int channel, U64 value )
     {
         if( settings.mTestMode != TestMode::TEST_CONTIGUOUS )
         {
@@ -133,9 +608,13 @@ class TestExtension
         {
             if( mTestChannelPrimed.at( channel ) )
             {
+                // Keep what went wrong for the bit fault map before the expected value is lost.
+                mLastExpected = mTestExpectedResults.at( channel );
+                mLastSlip = mFaultMap.record( channel, mLastExpected, value );
+                mFaultMapDirty = true;
+
                 // The test is now unpredictable, allow the next sample to reset the test position
                 mTestChannelPrimed.at( channel ) = false;
-                mTestServer.error();
                 return true;
             }
             else
@@ -146,15 +625,618 @@ class TestExtension
         }
         else
         {
+            // A primed channel has passed the test with this sample
+            mTestPassed = mTestPassed || mTestChannelPrimed.at( channel );
+
             // We now have 1 samples to test against
             mTestChannelPrimed.at( channel ) = true;
         }
 
-        mTestExpectedResults.at( channel ) = value + 1;
+        mTestExpectedResults.at( channel ) = ( value + 1 ) & mWordMask;
 
         return false;
     }
 
+    bool referenceEnabled() const
+    {
+        return mReference.enabled();
+    }
+
+    /**
+     * @brief Why the reference file couldn't be used, when the reference test is selected but not enabled.
+     */
+    const std::string& referenceError() const
+    {
+        return mReference.error();
+    }
+
+    const ReferenceCompare::Totals& referenceTotals() const
+    {
+        return mReference.totals();
+    }
+
+    /**
+     * @brief Compare a decoded word with the reference file, see ReferenceCompare::push().
+     *
+     * Lock, drop, repeat, lock loss and end of reference events are also sent to the test server. Mismatches are test errors, the
+     * caller reports them and records them with recordMismatch().
+     */
+    void processReference( U32 channel, U64 value, U64 sampleNumber, std::vector<ReferenceCompare::Event>& events )
+    {
+        size_t first = events.size();
+        mReference.push( channel, value, sampleNumber, events );
+        for( size_t i = first; i < events.size(); i++ )
+        {
+            mTestPassed = mTestPassed || events[ i ].mKind == ReferenceCompare::EVENT_LOCKED;
+        }
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+        for( size_t i = first; i < events.size(); i++ )
+        {
+            if( events[ i ].mKind == ReferenceCompare::EVENT_MISMATCH )
+            {
+                continue;
+            }
+            // kind, first sample, reference frame, frames dropped or repeated.
+            std::vector<uint64_t> fields;
+            fields.push_back( events[ i ].mKind );
+            fields.push_back( events[ i ].mFirstSample );
+            fields.push_back( events[ i ].mPosition );
+            fields.push_back( events[ i ].mFrames );
+            mTestServer.record( TEST_SERVER_RECORD_REFERENCE, fields );
+        }
+    }
+
+    /**
+     * @brief Add a sample that differs from what a test expected (reference, lock-step, sequence header) to the bit fault map.
+     *
+     * @return the bit slip, see BitFaultMap::record()
+     */
+    int recordMismatch( U32 channel, U64 expected, U64 received )
+    {
+        mFaultMapDirty = true;
+        return mFaultMap.record( channel, expected, received );
+    }
+
+    /**
+     * @brief The value the last failing sample should have had.
+     */
+    U64 lastExpected() const
+    {
+        return mLastExpected;
+    }
+
+    /**
+     * @brief Bit slip of the last failing sample, see BitFaultMap::record().
+     */
+    int lastSlip() const
+    {
+        return mLastSlip;
+    }
+
+    /**
+     * @brief Push an error event to the test server straight away, ahead of the next stats update.
+     *
+     * @param errorType I2sResultType of the error
+     */
+    void reportError( U64 startSample, U64 endSample, U32 channel, U64 expected, U64 received, U32 errorType )
+    {
+        if( mTestServerConnected )
+        {
+            mTestServer.error( startSample, endSample, channel, expected, received, errorType );
+        }
+    }
+
+    bool audioAnalysisEnabled() const
+    {
+        return mAudioQuality.enabled();
+    }
+
+    /**
+     * @brief Feed a decoded sample, normalised to -1.0 .. 1.0, to the audio analysis.
+     *
+     * @return true when a block completed, with its measurements in result. These are also sent to the test server.
+     */
+    bool processAudio( U32 channel, double value, U64 sampleNumber, AudioQualityAnalysis::Result& result )
+    {
+        if( !mAudioQuality.push( channel, value, sampleNumber, result ) )
+        {
+            return false;
+        }
+
+        if( mTestServerConnected )
+        {
+            // channel, first sample, last sample, then frequency, THD+N, SNR and DC offset as IEEE doubles.
+            std::vector<uint64_t> fields;
+            fields.push_back( result.mChannel );
+            fields.push_back( result.mFirstSample );
+            fields.push_back( result.mLastSample );
+            fields.push_back( doubleBits( result.mFrequencyHz ) );
+            fields.push_back( doubleBits( result.mThdNDb ) );
+            fields.push_back( doubleBits( result.mSnrDb ) );
+            fields.push_back( doubleBits( result.mDcOffset ) );
+            mTestServer.record( TEST_SERVER_RECORD_AUDIO_QUALITY, fields );
+        }
+        return true;
+    }
+
+    bool levelStatisticsEnabled() const
+    {
+        return mLevelStatistics.enabled();
+    }
+
+    /**
+     * @brief Feed a decoded word, centred on zero, to the level statistics.
+     *
+     * @return true when a block completed, with its statistics in block. These are also sent to the test server.
+     */
+    bool processLevel( U32 channel, S64 value, U64 sampleNumber, LevelStatistics::Summary& block )
+    {
+        if( !mLevelStatistics.push( channel, value, sampleNumber, block ) )
+        {
+            return false;
+        }
+
+        sendLevelStatistics( block, false );
+        return true;
+    }
+
+    /**
+     * @brief Statistics of everything decoded so far on a channel. These are also sent to the test server.
+     */
+    const LevelStatistics::Summary& levelTotal( U32 channel )
+    {
+        const LevelStatistics::Summary& total = mLevelStatistics.total( channel );
+        sendLevelStatistics( total, true );
+        return total;
+    }
+
+    bool lockStepEnabled() const
+    {
+        return mLockStep.enabled();
+    }
+
+    /**
+     * @brief Check a decoded word against the other channels of its frame, see LockStepCheck::push().
+     *
+     * Channel state changes are also sent to the test server. Mismatches are test errors, the caller reports them and records them
+     * with recordMismatch().
+     */
+    void processLockStep( U32 channel, U64 value, U64 sampleNumber, std::vector<LockStepCheck::Event>& events,
+                          std::vector<LockStepCheck::Mismatch>& mismatches )
+    {
+        size_t first = events.size();
+        mTestPassed = mLockStep.push( channel, value, sampleNumber, events, mismatches ) || mTestPassed;
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+        for( size_t i = first; i < events.size(); i++ )
+        {
+            // channel, state, skew or carried channel (int64), first sample, frames in the previous state.
+            std::vector<uint64_t> fields;
+            fields.push_back( events[ i ].mChannel );
+            fields.push_back( events[ i ].mState );
+            fields.push_back( uint64_t( events[ i ].mValue ) );
+            fields.push_back( events[ i ].mFirstSample );
+            fields.push_back( events[ i ].mFrames );
+            mTestServer.record( TEST_SERVER_RECORD_LOCKSTEP, fields );
+        }
+    }
+
+    bool sequenceEnabled() const
+    {
+        return mSequence.enabled();
+    }
+
+    const SequenceCheck::Totals& sequenceTotals() const
+    {
+        return mSequence.totals();
+    }
+
+    /**
+     * @brief Check a decoded word of the sequence test pattern, see SequenceCheck::push().
+     *
+     * Every event is also sent to the test server. Corruptions are test errors, the caller reports them and records them with
+     * recordMismatch().
+     */
+    void processSequence( U32 channel, U64 value, U64 sampleNumber, std::vector<SequenceCheck::Event>& events )
+    {
+        size_t first = events.size();
+        mTestPassed = mSequence.push( channel, value, sampleNumber, events ) || mTestPassed;
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+        for( size_t i = first; i < events.size(); i++ )
+        {
+            // kind, first sample, sequence number, expected sequence number, frames dropped or late.
+            std::vector<uint64_t> fields;
+            fields.push_back( events[ i ].mKind );
+            fields.push_back( events[ i ].mFirstSample );
+            fields.push_back( events[ i ].mSequence );
+            fields.push_back( events[ i ].mExpected );
+            fields.push_back( events[ i ].mFrames );
+            mTestServer.record( TEST_SERVER_RECORD_SEQUENCE, fields );
+        }
+    }
+
+    /**
+     * @brief Did the test pass a word (a contiguous sample, a reference lock, a frame in lock-step or with a good CRC) since the
+     *        last call?
+     */
+    bool takeTestPassed()
+    {
+        bool passed = mTestPassed;
+        mTestPassed = false;
+        return passed;
+    }
+
+    bool startupEnabled() const
+    {
+        return mStartup.enabled();
+    }
+
+    /**
+     * @brief Start timing a power cycle, see StartupTiming::start().
+     *
+     * @return true if the previous cycle was cut short, with it in finished. This is also sent to the test server.
+     */
+    bool startupStart( U64 anchor, U64 firstClock, StartupTiming::Cycle& finished )
+    {
+        if( !mStartup.start( anchor, firstClock, finished ) )
+        {
+            return false;
+        }
+        sendStartup( finished );
+        return true;
+    }
+
+    void startupFrameBit( BitState frame, U64 sampleNumber )
+    {
+        mStartup.frameBit( frame, sampleNumber );
+    }
+
+    /**
+     * @return true when this completed the cycle, with it in cycle. This is also sent to the test server.
+     */
+    bool startupValidFrame( U64 sampleNumber, StartupTiming::Cycle& cycle )
+    {
+        if( !mStartup.validFrame( sampleNumber, cycle ) )
+        {
+            return false;
+        }
+        sendStartup( cycle );
+        return true;
+    }
+
+    /**
+     * @return true when this completed the cycle, with it in cycle. This is also sent to the test server.
+     */
+    bool startupTestPass( U64 sampleNumber, StartupTiming::Cycle& cycle )
+    {
+        if( !mStartup.testPass( sampleNumber, cycle ) )
+        {
+            return false;
+        }
+        sendStartup( cycle );
+        return true;
+    }
+
+    /**
+     * @brief Send a recovered clock report to the test server.
+     */
+    void sendClockRecovery( const ClockRecovery::Report& report )
+    {
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+
+        // locked, lock changed, first sample, last sample, frames, bad frames, edges, then bit period, rms and peak to peak jitter
+        // in samples as IEEE doubles.
+        std::vector<uint64_t> fields;
+        fields.push_back( report.mLocked );
+        fields.push_back( report.mLockChanged );
+        fields.push_back( report.mFirstSample );
+        fields.push_back( report.mLastSample );
+        fields.push_back( report.mFrames );
+        fields.push_back( report.mBadFrames );
+        fields.push_back( report.mEdges );
+        fields.push_back( doubleBits( report.mBitPeriod ) );
+        fields.push_back( doubleBits( report.mJitterRms ) );
+        fields.push_back( doubleBits( report.mJitterPeakToPeak ) );
+        mTestServer.record( TEST_SERVER_RECORD_CLOCK_RECOVERY, fields );
+    }
+
+    /**
+     * @brief Send a clock tree ratio change or phase slip to the test server.
+     */
+    void sendClockTreeEvent( const ClockTreeMonitor::Event& event )
+    {
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+
+        // kind, sample, then the previous and current count or phase as IEEE doubles.
+        std::vector<uint64_t> fields;
+        fields.push_back( event.mKind );
+        fields.push_back( event.mSample );
+        fields.push_back( doubleBits( event.mPrevious ) );
+        fields.push_back( doubleBits( event.mCurrent ) );
+        mTestServer.record( TEST_SERVER_RECORD_CLOCK_TREE_EVENT, fields );
+    }
+
+    /**
+     * @brief Send a clock tree stability report to the test server.
+     */
+    void sendClockTreeReport( const ClockTreeMonitor::Report& report )
+    {
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+
+        // first sample, last sample, frames, MCLK and CLOCK periods per FRAME period, ratio changes, phase slips, then the MCLK and
+        // CLOCK phase mean, rms and peak to peak in periods as IEEE doubles.
+        std::vector<uint64_t> fields;
+        fields.push_back( report.mFirstSample );
+        fields.push_back( report.mLastSample );
+        fields.push_back( report.mFrames );
+        fields.push_back( report.mMclkPerFrame );
+        fields.push_back( report.mBclkPerFrame );
+        fields.push_back( report.mRatioChanges );
+        fields.push_back( report.mPhaseSlips );
+        const ClockTreeMonitor::PhaseStatistics* phases[] = { &report.mMclkPhase, &report.mBclkPhase };
+        for( const ClockTreeMonitor::PhaseStatistics* phase : phases )
+        {
+            fields.push_back( doubleBits( phase->mMean ) );
+            fields.push_back( doubleBits( phase->mRms ) );
+            fields.push_back( doubleBits( phase->mPeakToPeak ) );
+        }
+        mTestServer.record( TEST_SERVER_RECORD_CLOCK_TREE, fields );
+    }
+
+    /**
+     * @brief Send a jitter spectrum report to the test server.
+     */
+    void sendJitterSpectrum( const JitterSpectrum::Report& report )
+    {
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+
+        // first sample, last sample, blocks, spur count, then the bit period, rms jitter and the rms jitter of each band in samples,
+        // then the frequency in Hz and rms in samples of each spur, as IEEE doubles.
+        std::vector<uint64_t> fields;
+        fields.push_back( report.mFirstSample );
+        fields.push_back( report.mLastSample );
+        fields.push_back( report.mBlocks );
+        fields.push_back( report.mSpurCount );
+        fields.push_back( doubleBits( report.mBitPeriod ) );
+        fields.push_back( doubleBits( report.mRms ) );
+        for( U32 band = 0; band < JITTER_SPECTRUM_BANDS; band++ )
+            fields.push_back( doubleBits( report.mBandRms[ band ] ) );
+        for( U32 spur = 0; spur < report.mSpurCount; spur++ )
+        {
+            fields.push_back( doubleBits( report.mSpurs[ spur ].mFrequencyHz ) );
+            fields.push_back( doubleBits( report.mSpurs[ spur ].mRms ) );
+        }
+        mTestServer.record( TEST_SERVER_RECORD_JITTER_SPECTRUM, fields );
+    }
+
+    /**
+     * @brief Send a CLOCK glitch to the test server.
+     */
+    void sendClockGlitch( const ClockPulseMonitor::Glitch& glitch )
+    {
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+
+        // first sample, last sample, short pulses, shortest pulse in samples, level of the shortest pulse (1 high).
+        std::vector<uint64_t> fields;
+        fields.push_back( glitch.mStartSample );
+        fields.push_back( glitch.mEndSample );
+        fields.push_back( glitch.mPulses );
+        fields.push_back( glitch.mShortest );
+        fields.push_back( glitch.mShortestHigh );
+        mTestServer.record( TEST_SERVER_RECORD_CLOCK_GLITCH, fields );
+    }
+
+    /**
+     * @brief Send a CLOCK pulse width and duty cycle report to the test server.
+     */
+    void sendClockPulses( const ClockPulseMonitor::Report& report )
+    {
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+
+        // first sample, last sample, glitches, glitch pulses, then the count, min and max in samples of the high and the low
+        // pulses, then the high and low mean in samples and the duty cycle, its min and its max as IEEE doubles.
+        std::vector<uint64_t> fields;
+        fields.push_back( report.mFirstSample );
+        fields.push_back( report.mLastSample );
+        fields.push_back( report.mGlitches );
+        fields.push_back( report.mGlitchPulses );
+        const ClockPulseMonitor::PulseStatistics* levels[] = { &report.mHigh, &report.mLow };
+        for( const ClockPulseMonitor::PulseStatistics* level : levels )
+        {
+            fields.push_back( level->mCount );
+            fields.push_back( level->mMin );
+            fields.push_back( level->mMax );
+        }
+        fields.push_back( doubleBits( report.mHigh.mMean ) );
+        fields.push_back( doubleBits( report.mLow.mMean ) );
+        fields.push_back( doubleBits( report.mDutyCycle ) );
+        fields.push_back( doubleBits( report.mDutyMin ) );
+        fields.push_back( doubleBits( report.mDutyMax ) );
+        mTestServer.record( TEST_SERVER_RECORD_CLOCK_PULSES, fields );
+    }
+
+    /**
+     * @brief Send a FRAME period that slipped from the established bit count to the test server straight away.
+     */
+    void sendFrameSlip( const FrameLengthTracker::Slip& slip )
+    {
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+
+        // first sample, bit count, established bit count.
+        std::vector<uint64_t> fields;
+        fields.push_back( slip.mSample );
+        fields.push_back( slip.mBits );
+        fields.push_back( slip.mNominal );
+        mTestServer.record( TEST_SERVER_RECORD_FRAME_SLIP, fields );
+    }
+
+    /**
+     * @brief Send a frame length summary to the test server.
+     */
+    void sendFrameLengths( const FrameLengthTracker::Report& report )
+    {
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+
+        // first sample, last sample, frames, established bit count, slips, total slips, runs truncated flag, frames with other
+        // lengths, run count, histogram entries, slip sample count, then the runs and the histogram entries as bit count, frames
+        // pairs, then the slip samples.
+        std::vector<uint64_t> fields;
+        fields.push_back( report.mFirstSample );
+        fields.push_back( report.mLastSample );
+        fields.push_back( report.mFrames );
+        fields.push_back( report.mNominal );
+        fields.push_back( report.mSlips );
+        fields.push_back( report.mTotalSlips );
+        fields.push_back( report.mRunsTruncated );
+        fields.push_back( report.mOtherFrames );
+        fields.push_back( report.mRuns.size() );
+        fields.push_back( report.mLengths.size() );
+        fields.push_back( report.mSlipSamples.size() );
+        const std::vector<FrameLengthTracker::Run>* lists[] = { &report.mRuns, &report.mLengths };
+        for( const std::vector<FrameLengthTracker::Run>* list : lists )
+        {
+            for( const FrameLengthTracker::Run& run : *list )
+            {
+                fields.push_back( run.mBits );
+                fields.push_back( run.mFrames );
+            }
+        }
+        fields.insert( fields.end(), report.mSlipSamples.begin(), report.mSlipSamples.end() );
+        mTestServer.record( TEST_SERVER_RECORD_FRAME_LENGTH, fields );
+    }
+
+    /**
+     * @brief Send an established sample rate to the test server.
+     */
+    void sendSampleRate( const SampleRateTracker::Change& change )
+    {
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+
+        // sample, segment, then the previous rate, the rate and the nominal rate in Hz as IEEE doubles.
+        std::vector<uint64_t> fields;
+        fields.push_back( change.mSample );
+        fields.push_back( change.mSegment );
+        fields.push_back( doubleBits( change.mPrevious ) );
+        fields.push_back( doubleBits( change.mRate ) );
+        fields.push_back( doubleBits( change.mNominal ) );
+        mTestServer.record( TEST_SERVER_RECORD_SAMPLE_RATE, fields );
+    }
+
+    /**
+     * @brief Send the statistics of a finished sample rate segment to the test server.
+     */
+    void sendRateSegment( const SampleRateTracker::Segment& segment )
+    {
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+
+        // segment, first sample, last sample, frames, off rate frames, errors, clock gaps, then the rate, the nominal rate, its
+        // offset in ppm and the min and max rate of single FRAME periods as IEEE doubles.
+        std::vector<uint64_t> fields;
+        fields.push_back( segment.mIndex );
+        fields.push_back( segment.mFirstSample );
+        fields.push_back( segment.mLastSample );
+        fields.push_back( segment.mFrames );
+        fields.push_back( segment.mOffRateFrames );
+        fields.push_back( segment.mErrors );
+        fields.push_back( segment.mClockGaps );
+        fields.push_back( doubleBits( segment.mRate ) );
+        fields.push_back( doubleBits( segment.mNominal ) );
+        fields.push_back( doubleBits( segment.mPpm ) );
+        fields.push_back( doubleBits( segment.mMinRate ) );
+        fields.push_back( doubleBits( segment.mMaxRate ) );
+        mTestServer.record( TEST_SERVER_RECORD_RATE_SEGMENT, fields );
+    }
+
+    bool latencyEnabled() const
+    {
+        return mLatency.enabled();
+    }
+
+    /**
+     * @brief Feed the marker word of an input frame to the latency measurement.
+     */
+    void processLatencyInput( U64 value, U64 sampleNumber )
+    {
+        mLatency.pushInput( value, sampleNumber );
+    }
+
+    /**
+     * @brief Feed the marker word of an output frame to the latency measurement, after the input words up to it.
+     *
+     * @return true when a report completed, with it in summary. This is also sent to the test server.
+     */
+    bool processLatencyOutput( U64 value, U64 sampleNumber, LoopbackLatency::Summary& summary )
+    {
+        if( !mLatency.pushOutput( value, sampleNumber, summary ) )
+        {
+            return false;
+        }
+
+        if( mTestServerConnected )
+        {
+            // first sample, last sample, matches, unmatched, then latency, min, max, total min and total max in samples,
+            // then mean, jitter and frame period in samples as IEEE doubles.
+            std::vector<uint64_t> fields;
+            fields.push_back( summary.mFirstSample );
+            fields.push_back( summary.mLastSample );
+            fields.push_back( summary.mMatches );
+            fields.push_back( summary.mUnmatched );
+            fields.push_back( summary.mLatency );
+            fields.push_back( summary.mMin );
+            fields.push_back( summary.mMax );
+            fields.push_back( summary.mTotalMin );
+            fields.push_back( summary.mTotalMax );
+            fields.push_back( doubleBits( summary.mMean ) );
+            fields.push_back( doubleBits( summary.mJitter ) );
+            fields.push_back( doubleBits( summary.mFramePeriod ) );
+            mTestServer.record( TEST_SERVER_RECORD_LATENCY, fields );
+        }
+        return true;
+    }
+
+    BitFaultMap& faultMap()
+    {
+        return mFaultMap;
+    }
+
     void setDataValidEdge( uint64_t sampleNumber )
     {
         // We want to detect movements in the clock of +/- 1ppm.
@@ -162,7 +1244,14 @@ class TestExtension
         // With a sample rate of 48000, 500 times per second equates to once every 96 frames: 500000000 / (48000/96).
         // Therefore, we output the delta between the  measured number of samples between FS clk edge every 96 samples, and 1000000.
 
-        if(edgeCount >= (96*32*2)-1)
+        if( !mClockStatsPrimed )
+        {
+            // Start timing from here, there is no previous edge to measure against.
+            mDataValidEdgeSample = sampleNumber;
+            mClockStatsPrimed = true;
+            edgeCount = 0;
+        }
+        else if(edgeCount >= (96*32*2)-1)
         {
             U64 clockDelta = sampleNumber - mDataValidEdgeSample;
             mDataValidEdgeSample = sampleNumber;
@@ -177,6 +1266,10 @@ class TestExtension
                 if( mTestServerConnected )
                 {
                     mTestServer.update( mClockMinInterval, mClockMaxInterval );
+                    if( mFaultMapDirty )
+                    {
+                        sendFaultMap();
+                    }
                 }
                 mClockMinInterval = std::numeric_limits<U64>::max();
                 mClockMaxInterval = 0;
@@ -193,15 +1286,101 @@ class TestExtension
     }
 
   protected:
+    static uint64_t doubleBits( double value )
+    {
+        uint64_t bits;
+        memcpy( &bits, &value, sizeof( bits ) );
+        return bits;
+    }
+
+    void sendLevelStatistics( const LevelStatistics::Summary& summary, bool isTotal )
+    {
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+
+        // channel, total flag, first sample, last sample, count, min, max, clipped, longest silence, then mean and RMS as IEEE doubles.
+        std::vector<uint64_t> fields;
+        fields.push_back( summary.mChannel );
+        fields.push_back( isTotal );
+        fields.push_back( summary.mFirstSample );
+        fields.push_back( summary.mLastSample );
+        fields.push_back( summary.mCount );
+        fields.push_back( uint64_t( summary.mMin ) );
+        fields.push_back( uint64_t( summary.mMax ) );
+        fields.push_back( summary.mClipped );
+        fields.push_back( summary.mLongestSilence );
+        fields.push_back( doubleBits( summary.mMean ) );
+        fields.push_back( doubleBits( summary.mRms ) );
+        mTestServer.record( TEST_SERVER_RECORD_LEVEL, fields );
+    }
+
+    void sendStartup( const StartupTiming::Cycle& cycle )
+    {
+        if( !mTestServerConnected )
+        {
+            return;
+        }
+
+        // cycle, complete flag, anchor, then the sample of each milestone: CLOCK edge, FRAME edge, valid frame, test pass.
+        std::vector<uint64_t> fields;
+        fields.push_back( cycle.mIndex );
+        fields.push_back( cycle.mComplete );
+        fields.push_back( cycle.mAnchor );
+        fields.insert( fields.end(), cycle.mSamples, cycle.mSamples + StartupTiming::MILESTONE_COUNT );
+        mTestServer.record( TEST_SERVER_RECORD_STARTUP, fields );
+    }
+
+    void sendFaultMap()
+    {
+        mFaultMapDirty = false;
+        for( U32 channel = 0; channel < mFaultMap.channelCount(); channel++ )
+        {
+            const BitFaultMap::ChannelFaults& faults = mFaultMap.faults( channel );
+            if( faults.mErrorCount == 0 )
+            {
+                continue;
+            }
+
+            // channel, error count, mismatch mask, stuck high mask, stuck low mask, 4 slip counts, then one count per bit.
+            std::vector<uint64_t> fields;
+            fields.push_back( channel );
+            fields.push_back( faults.mErrorCount );
+            fields.push_back( faults.mMismatchMask );
+            fields.push_back( mFaultMap.stuckHighMask( channel ) );
+            fields.push_back( mFaultMap.stuckLowMask( channel ) );
+            fields.insert( fields.end(), faults.mSlipCounts, faults.mSlipCounts + BIT_FAULT_MAP_MAX_SLIP * 2 );
+            fields.insert( fields.end(), faults.mBitErrors, faults.mBitErrors + mFaultMap.bitsPerWord() );
+            mTestServer.record( TEST_SERVER_RECORD_FAULT_MAP, fields );
+        }
+    }
+
     U64 mClockMinInterval = std::numeric_limits<U64>::max();
     U64 mClockMaxInterval = 0;
     U32 mStatsUpdateInterval = 500;
     U32 mStatsUpdateCount = 0;
-    std::vector<U32> mTestExpectedResults;
+    std::vector<U64> mTestExpectedResults;
     std::vector<bool> mTestChannelPrimed;
+    U64 mWordMask = ~0ULL;
+
+    BitFaultMap mFaultMap;
+    bool mFaultMapDirty = false;
+    U64 mLastExpected = 0;
+    int mLastSlip = 0;
+
+    AudioQualityAnalysis mAudioQuality;
+    LevelStatistics mLevelStatistics;
+    ReferenceCompare mReference;
+    LoopbackLatency mLatency;
+    LockStepCheck mLockStep;
+    SequenceCheck mSequence;
+    StartupTiming mStartup;
+    bool mTestPassed = false;
     TestServer mTestServer;
     bool mTestServerConnected = false;
 
     uint64_t mDataValidEdgeSample = 0;
+    bool mClockStatsPrimed = false;
     uint32_t edgeCount = 0;
 };
\ No newline at end of file
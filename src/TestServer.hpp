@@ -1,13 +1,39 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <sys/socket.h>
 #include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 
 #define TEST_SERVER_PORT 65432
 #define TEST_SERVER_IP "127.0.0.1"
 
+// Variable length records are sent as a header pair ( TEST_SERVER_RECORD_MAGIC, ( type << 32 ) | field count ),
+// followed by the fields as little endian uint64s.
+#define TEST_SERVER_RECORD_MAGIC 0x5245434F5244ULL
+#define TEST_SERVER_RECORD_FAULT_MAP 1
+#define TEST_SERVER_RECORD_ERROR 2
+#define TEST_SERVER_RECORD_AUDIO_QUALITY 3
+#define TEST_SERVER_RECORD_LEVEL 4
+#define TEST_SERVER_RECORD_REFERENCE 5
+#define TEST_SERVER_RECORD_LATENCY 6
+#define TEST_SERVER_RECORD_LOCKSTEP 7
+#define TEST_SERVER_RECORD_SEQUENCE 8
+#define TEST_SERVER_RECORD_STARTUP 9
+#define TEST_SERVER_RECORD_CLOCK_RECOVERY 10
+#define TEST_SERVER_RECORD_CLOCK_TREE_EVENT 11
+#define TEST_SERVER_RECORD_CLOCK_TREE 12
+#define TEST_SERVER_RECORD_JITTER_SPECTRUM 13
+#define TEST_SERVER_RECORD_CLOCK_GLITCH 14
+#define TEST_SERVER_RECORD_CLOCK_PULSES 15
+#define TEST_SERVER_RECORD_FRAME_SLIP 16
+#define TEST_SERVER_RECORD_FRAME_LENGTH 17
+#define TEST_SERVER_RECORD_SAMPLE_RATE 18
+#define TEST_SERVER_RECORD_RATE_SEGMENT 19
+
 class TestServer
 {
   public:
@@ -26,6 +52,10 @@ class TestServer
             mErrorString = "Failed to create socket";
         }
 
+        // Error events are the automation's stop trigger, so don't let Nagle hold them back.
+        int no_delay = 1;
+        setsockopt(mSocket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
         mServerAddress.sin_family = AF_INET;
         mServerAddress.sin_port = htons(TEST_SERVER_PORT);
 
@@ -70,11 +100,36 @@ class TestServer
         return true;
     }
 
-    bool error()
+    /**
+     * @brief Send an error event. This replaces the old ( 1111, 9999 ) stop message.
+     *
+     * @param errorType I2sResultType of the error
+     */
+    bool error(uint64_t startSample, uint64_t endSample, uint64_t channel, uint64_t expected, uint64_t received, uint64_t errorType)
+    {
+        std::vector<uint64_t> fields;
+        fields.push_back(startSample);
+        fields.push_back(endSample);
+        fields.push_back(channel);
+        fields.push_back(expected);
+        fields.push_back(received);
+        fields.push_back(errorType);
+        return record(TEST_SERVER_RECORD_ERROR, fields);
+    }
+
+    bool record( uint64_t type, const std::vector<uint64_t>& fields )
     {
         if(mSocket < 0){ return false; }
 
-        std::string msg = serialise(1111, 9999);
+        std::string msg = serialise(TEST_SERVER_RECORD_MAGIC, (type << 32) | fields.size());
+        for(size_t i = 0; i + 1 < fields.size(); i += 2)
+        {
+            msg += serialise(fields[i], fields[i + 1]);
+        }
+        if(fields.size() & 1)
+        {
+            msg += serialise(fields.back(), 0).substr(0, 8);
+        }
 
         if (send(mSocket, msg.c_str(), msg.size(), 0) < 0)
         {